@@ -0,0 +1,266 @@
+/*
+ * Copyright (C) 2025 Da'Jour J. Christophe. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "internal/hash.h"
+#include "map.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#define KEYS   (1UL << 16)
+#define ROUNDS 200UL
+
+static double now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/*
+ * The key block stays in L1/L2 so the numbers are hashing cost, not
+ * memory bandwidth.
+ */
+static void bench_batch(const size_t len)
+{
+  uint8_t *keys = malloc(KEYS * len);
+  uint64_t *out = malloc(KEYS * sizeof(*out));
+  uint64_t sink = 0UL;
+  size_t r;
+  size_t i;
+
+  for (i = 0UL; i < KEYS * len; i++)
+  {
+    keys[i] = (uint8_t)(i * 131U);
+  }
+
+  double start = now();
+
+  for (r = 0UL; r < ROUNDS; r++)
+  {
+    for (i = 0UL; i < KEYS; i++)
+    {
+      out[i] = xxh3(keys + i * len, len, r);
+    }
+
+    sink += out[r];
+  }
+
+  const double scalar = now() - start;
+
+  start = now();
+
+  for (r = 0UL; r < ROUNDS; r++)
+  {
+    xxh3_batch(keys, len, len, KEYS, r, out);
+    sink += out[r];
+  }
+
+  const double batch = now() - start;
+
+  printf("xxh3 %2lu-byte keys  scalar %8.1f Mkeys/s  batch %8.1f Mkeys/s  (%.2fx, %lx)\n",
+         (unsigned long)len, (double)(KEYS * ROUNDS) / scalar * 1e-6,
+         (double)(KEYS * ROUNDS) / batch * 1e-6, scalar / batch, (unsigned long)(sink & 0xF));
+
+  free(keys);
+  free(out);
+}
+
+static const struct
+{
+  const char *name;
+  hash_fn_t   fn;
+} fns[] = {
+  {"xxh3",       xxh3},
+  {"crc32c_mix", crc32c_mix},
+  {"aes_mix",    aes_mix},
+};
+
+#define FNS (sizeof(fns) / sizeof(*fns))
+
+/* one call per key, the way a table hashes, for each function a table can use */
+static void bench_fns(const size_t len)
+{
+  uint8_t *keys = malloc(KEYS * len);
+  uint64_t sink = 0UL;
+  double rate[FNS];
+  size_t f;
+  size_t r;
+  size_t i;
+
+  for (i = 0UL; i < KEYS * len; i++)
+  {
+    keys[i] = (uint8_t)(i * 131U);
+  }
+
+  for (f = 0UL; f < FNS; f++)
+  {
+    const double start = now();
+
+    for (r = 0UL; r < ROUNDS / 4UL; r++)
+    {
+      for (i = 0UL; i < KEYS; i++)
+      {
+        sink += fns[f].fn(keys + i * len, len, r);
+      }
+    }
+
+    rate[f] = (double)(KEYS * (ROUNDS / 4UL)) / (now() - start) * 1e-6;
+  }
+
+  printf("%4lu-byte keys ", (unsigned long)len);
+
+  for (f = 0UL; f < FNS; f++)
+  {
+    printf(" %s %7.1f Mkeys/s", fns[f].name, rate[f]);
+  }
+
+  printf("  (%lx)\n", (unsigned long)(sink & 0xF));
+
+  free(keys);
+}
+
+static void bench_map_fns(void)
+{
+  const size_t n = 1UL << 20;
+  uint64_t *keys = malloc(2UL * n * sizeof(*keys));
+  size_t f;
+  size_t i;
+
+  for (i = 0UL; i < 2UL * n; i++)
+  {
+    keys[i] = i * 0x9E3779B97F4A7C15ULL;
+  }
+
+  for (f = 0UL; f < FNS; f++)
+  {
+    map_t *map = map_new(2UL * n);
+    size_t found = 0UL;
+
+    map_use_hash(map, fns[f].fn);
+    map_set_batch(map, keys, sizeof(*keys), keys, sizeof(*keys), n);
+
+    const double start = now();
+
+    for (i = 0UL; i < 2UL * n; i++)
+    {
+      found += (size_t)map_exists(map, &keys[i], sizeof(*keys));
+    }
+
+    printf("map_exists %-10s %8.1f Mkeys/s  (%lu hits)\n", fns[f].name,
+           (double)(2UL * n) / (now() - start) * 1e-6, (unsigned long)found);
+
+    map_destroy(map);
+  }
+
+  free(keys);
+}
+
+static void bench_map_batch(void)
+{
+  const size_t n = 1UL << 20;
+  map_t *map = map_new(2UL * n);
+  uint64_t *keys = malloc(2UL * n * sizeof(*keys));
+  size_t found = 0UL;
+  size_t i;
+
+  for (i = 0UL; i < 2UL * n; i++)
+  {
+    keys[i] = i * 0x9E3779B97F4A7C15ULL;
+  }
+
+  map_set_batch(map, keys, sizeof(*keys), keys, sizeof(*keys), n);
+
+  double start = now();
+
+  for (i = 0UL; i < 2UL * n; i++)
+  {
+    found += (size_t)map_exists(map, &keys[i], sizeof(*keys));
+  }
+
+  const double single = now() - start;
+
+  start = now();
+  found += map_exists_batch(map, keys, sizeof(*keys), 2UL * n, NULL);
+
+  const double batch = now() - start;
+
+  printf("map_exists        %8.1f Mkeys/s  batch %8.1f Mkeys/s  (%.2fx, %lu hits)\n",
+         (double)(2UL * n) / single * 1e-6, (double)(2UL * n) / batch * 1e-6,
+         single / batch, (unsigned long)found);
+
+  free(keys);
+  map_destroy(map);
+}
+
+/*
+ * Tree hashing a buffer larger than the last-level cache, by thread count.
+ * It should scale until the cores saturate memory bandwidth.
+ */
+static void bench_tree(void)
+{
+  const size_t len = 1UL << 29;
+  uint8_t *buf = malloc(len);
+  const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  unsigned int threads;
+  uint64_t sink = 0UL;
+  size_t i;
+
+  for (i = 0UL; i < len; i++)
+  {
+    buf[i] = (uint8_t)(i * 131U);
+  }
+
+  double start = now();
+  sink += xxh3(buf, len, 0);
+  printf("xxh3      %2u threads %6.2f GB/s\n", 1U, (double)len / (now() - start) * 1e-9);
+
+  for (threads = 1U; threads <= (unsigned int)(cpus > 0L ? cpus : 1L); threads *= 2U)
+  {
+    start = now();
+    sink += xxh3_tree(buf, len, 0, threads);
+    printf("xxh3_tree %2u threads %6.2f GB/s  (%lx)\n", threads, (double)len / (now() - start) * 1e-9,
+           (unsigned long)(sink & 0xF));
+  }
+
+  free(buf);
+}
+
+int main(void)
+{
+  bench_batch(4UL);
+  bench_batch(8UL);
+  bench_batch(16UL);
+  bench_map_batch();
+  bench_fns(4UL);
+  bench_fns(8UL);
+  bench_fns(16UL);
+  bench_fns(32UL);
+  bench_fns(64UL);
+  bench_fns(256UL);
+  bench_fns(1024UL);
+  bench_map_fns();
+  bench_tree();
+
+  return 0;
+}
@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 2025 Da'Jour J. Christophe. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#define _POSIX_C_SOURCE 199309L
+
+#include "internal/hash.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#define CALLS (1UL << 22)
+#define BYTES (1UL << 26)
+
+/*
+ * Reference cycles from the time-stamp counter; where there is none the
+ * nanosecond clock stands in and the columns read per nanosecond.
+ */
+static uint64_t cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return (uint64_t)ts.tv_sec * 1000000000UL + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+static const struct
+{
+  const char *name;
+  hash_fn_t   fn;
+} fns[] = {
+  {"xxh3",       xxh3},
+  {"crc32c_mix", crc32c_mix},
+  {"aes_mix",    aes_mix},
+};
+
+#define FNS (sizeof(fns) / sizeof(*fns))
+
+static const size_t sizes[] = {
+  1, 2, 3, 4, 7, 8, 12, 16, 24, 32, 48, 64, 96, 128, 192, 240, 256, 512, 1024, 2048, 4096,
+};
+
+#define SIZES (sizeof(sizes) / sizeof(*sizes))
+
+static size_t calls_for(const size_t len)
+{
+  const size_t calls = BYTES / len;
+
+  return calls < CALLS ? calls : CALLS;
+}
+
+/* independent calls: the hashes overlap in the pipeline */
+static double bytes_per_cycle(const hash_fn_t fn, const uint8_t *key, const size_t len)
+{
+  const size_t calls = calls_for(len);
+  uint64_t sink = 0UL;
+  size_t i;
+
+  const uint64_t start = cycles();
+
+  for (i = 0UL; i < calls; i++)
+  {
+    sink += fn(key, len, i);
+  }
+
+  const uint64_t elapsed = cycles() - start;
+
+  __asm__ volatile ("" : : "r" (sink));
+
+  return (double)(calls * len) / (double)elapsed;
+}
+
+/* each seed is the previous hash, so every call waits for the last one */
+static double latency(const hash_fn_t fn, const uint8_t *key, const size_t len)
+{
+  const size_t calls = calls_for(len);
+  uint64_t h = 0UL;
+  size_t i;
+
+  const uint64_t start = cycles();
+
+  for (i = 0UL; i < calls; i++)
+  {
+    h = fn(key, len, h);
+  }
+
+  const uint64_t elapsed = cycles() - start;
+
+  __asm__ volatile ("" : : "r" (h));
+
+  return (double)elapsed / (double)calls;
+}
+
+int main(void)
+{
+  uint8_t *buf = NULL;
+  size_t f;
+  size_t s;
+  size_t i;
+
+  if (0 != posix_memalign((void **)&buf, 64UL, 4096UL + 64UL))
+  {
+    fprintf(stderr, "%s(): %s\n", __func__, "could not allocate key buffer to the heap");
+    exit(EXIT_FAILURE);
+  }
+
+  for (i = 0UL; i < 4096UL + 64UL; i++)
+  {
+    buf[i] = (uint8_t)(i * 131U);
+  }
+
+  printf("%-10s %5s  %9s %9s  %9s %9s\n", "", "", "aligned", "", "unaligned", "");
+  printf("%-10s %5s  %9s %9s  %9s %9s\n", "hash", "bytes", "B/cycle", "cyc/hash", "B/cycle", "cyc/hash");
+
+  for (f = 0UL; f < FNS; f++)
+  {
+    for (s = 0UL; s < SIZES; s++)
+    {
+      printf("%-10s %5lu  %9.2f %9.1f  %9.2f %9.1f\n", fns[f].name, (unsigned long)sizes[s],
+             bytes_per_cycle(fns[f].fn, buf, sizes[s]), latency(fns[f].fn, buf, sizes[s]),
+             bytes_per_cycle(fns[f].fn, buf + 1, sizes[s]), latency(fns[f].fn, buf + 1, sizes[s]));
+    }
+  }
+
+  free(buf);
+
+  return 0;
+}
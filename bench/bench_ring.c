@@ -0,0 +1,483 @@
+/*
+ * Copyright (C) 2025 Da'Jour J. Christophe. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#define _POSIX_C_SOURCE 200112L
+
+#include "deque.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MESSAGES (1UL << 24)
+#define CAPACITY (1UL << 16)
+#define BATCH    64UL
+
+static double now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void *producer(void *arg)
+{
+  ring_buffer_t *ring = (ring_buffer_t *)arg;
+  uint64_t i;
+
+  for (i = 0UL; i < MESSAGES; i++)
+  {
+    while (0 > ring_buffer_enqueue(ring, &i, sizeof(i)))
+    {
+      sched_yield();
+    }
+  }
+
+  return NULL;
+}
+
+/*
+ * One producer thread and one consumer thread passing 8-byte messages,
+ * through the allocating dequeue, the copying dequeue_into and the
+ * zero-copy peek/release.
+ */
+static void bench_spsc(const int mode)
+{
+  static const char *const modes[] = {"dequeue", "dequeue_into", "peek/release"};
+  ring_buffer_t *ring = ring_buffer_create(CAPACITY);
+  pthread_t thread;
+  uint64_t *item = NULL;
+  const uint64_t *front = NULL;
+  uint64_t value;
+  uint64_t sum = 0UL;
+  uint64_t i;
+
+  const double start = now();
+
+  if (0 != pthread_create(&thread, NULL, producer, ring))
+  {
+    fprintf(stderr, "%s(): %s\n", __func__, "could not start the producer thread");
+    exit(EXIT_FAILURE);
+  }
+
+  for (i = 0UL; i < MESSAGES; i++)
+  {
+    if (mode == 0)
+    {
+      while (NULL == (item = ring_buffer_dequeue(ring, sizeof(*item))))
+      {
+        sched_yield();
+      }
+
+      sum += *item;
+      free(item);
+    }
+    else if (mode == 1)
+    {
+      while (0 > ring_buffer_dequeue_into(ring, &value, sizeof(value)))
+      {
+        sched_yield();
+      }
+
+      sum += value;
+    }
+    else
+    {
+      while (NULL == (front = ring_buffer_peek(ring, sizeof(*front))))
+      {
+        sched_yield();
+      }
+
+      sum += *front;
+      ring_buffer_release(ring, sizeof(*front));
+    }
+  }
+
+  pthread_join(thread, NULL);
+
+  const double elapsed = now() - start;
+
+  printf("ring_buffer %-13s %8.1f Mmsgs/s  (%lu)\n", modes[mode], (double)MESSAGES / elapsed * 1e-6,
+         (unsigned long)(sum == MESSAGES * (MESSAGES - 1UL) / 2UL));
+
+  ring_buffer_destroy(ring);
+}
+
+static void *producer_bulk(void *arg)
+{
+  ring_buffer_t *ring = (ring_buffer_t *)arg;
+  uint64_t batch[BATCH];
+  size_t n;
+  size_t sent;
+  uint64_t i;
+
+  for (i = 0UL; i < MESSAGES; i += n)
+  {
+    for (n = 0UL; n < BATCH && i + n < MESSAGES; n++)
+    {
+      batch[n] = i + n;
+    }
+
+    sent = 0UL;
+
+    while ((sent += ring_buffer_enqueue_bulk(ring, batch + sent, sizeof(*batch), n - sent)) < n)
+    {
+      sched_yield();
+    }
+  }
+
+  return NULL;
+}
+
+/* the same traffic moved BATCH messages per call, one cursor update each */
+static void bench_spsc_bulk(void)
+{
+  ring_buffer_t *ring = ring_buffer_create(CAPACITY);
+  pthread_t thread;
+  uint64_t batch[BATCH];
+  uint64_t sum = 0UL;
+  size_t n;
+  size_t k;
+  uint64_t i;
+
+  const double start = now();
+
+  if (0 != pthread_create(&thread, NULL, producer_bulk, ring))
+  {
+    fprintf(stderr, "%s(): %s\n", __func__, "could not start the producer thread");
+    exit(EXIT_FAILURE);
+  }
+
+  for (i = 0UL; i < MESSAGES; i += n)
+  {
+    while (0UL == (n = ring_buffer_dequeue_bulk(ring, batch, sizeof(*batch), BATCH)))
+    {
+      sched_yield();
+    }
+
+    for (k = 0UL; k < n; k++)
+    {
+      sum += batch[k];
+    }
+  }
+
+  pthread_join(thread, NULL);
+
+  const double elapsed = now() - start;
+
+  printf("ring_buffer %-13s %8.1f Mmsgs/s  (%lu)\n", "bulk", (double)MESSAGES / elapsed * 1e-6,
+         (unsigned long)(sum == MESSAGES * (MESSAGES - 1UL) / 2UL));
+
+  ring_buffer_destroy(ring);
+}
+
+#define RECORD 100UL
+
+static void *producer_records(void *arg)
+{
+  ring_buffer_t *ring = (ring_buffer_t *)arg;
+  uint8_t record[RECORD] = {0};
+  uint64_t i;
+
+  for (i = 0UL; i < MESSAGES / 4UL; i++)
+  {
+    memcpy(record, &i, sizeof(i));
+
+    while (0 > ring_buffer_enqueue(ring, record, sizeof(record)))
+    {
+      sched_yield();
+    }
+  }
+
+  return NULL;
+}
+
+/*
+ * 100-byte records, which straddle the end of the ring now and then: a
+ * plain ring copies those in two pieces, a mirrored one never does and
+ * lets the consumer read every record in place.
+ */
+static void bench_records(const int mirrored)
+{
+  ring_buffer_t *ring = mirrored ? ring_buffer_create_mirrored(CAPACITY) : ring_buffer_create(CAPACITY);
+  uint8_t record[RECORD];
+  const uint8_t *front = NULL;
+  pthread_t thread;
+  uint64_t value;
+  uint64_t sum = 0UL;
+  uint64_t i;
+
+  if (ring == NULL)
+  {
+    printf("ring_buffer mirrored      unavailable\n");
+    return;
+  }
+
+  const double start = now();
+
+  if (0 != pthread_create(&thread, NULL, producer_records, ring))
+  {
+    fprintf(stderr, "%s(): %s\n", __func__, "could not start the producer thread");
+    exit(EXIT_FAILURE);
+  }
+
+  for (i = 0UL; i < MESSAGES / 4UL; i++)
+  {
+    if (mirrored)
+    {
+      while (NULL == (front = ring_buffer_peek(ring, RECORD)))
+      {
+        sched_yield();
+      }
+
+      memcpy(&value, front, sizeof(value));
+      ring_buffer_release(ring, RECORD);
+    }
+    else
+    {
+      while (0 > ring_buffer_dequeue_into(ring, record, RECORD))
+      {
+        sched_yield();
+      }
+
+      memcpy(&value, record, sizeof(value));
+    }
+
+    sum += value;
+  }
+
+  pthread_join(thread, NULL);
+
+  const double elapsed = now() - start;
+
+  printf("ring_buffer %-13s %8.1f Mrecs/s  %5.2f GB/s  (%lu)\n", mirrored ? "mirrored" : "100-byte",
+         (double)(MESSAGES / 4UL) / elapsed * 1e-6, (double)(MESSAGES / 4UL * RECORD) / elapsed * 1e-9,
+         (unsigned long)(sum == (MESSAGES / 4UL) * (MESSAGES / 4UL - 1UL) / 2UL));
+
+  ring_buffer_destroy(ring);
+}
+
+struct mpmc_worker
+{
+  mpmc_queue_t *queue;
+  size_t        messages;
+  size_t        batch;
+};
+
+static void *mpmc_producer(void *arg)
+{
+  struct mpmc_worker *self = (struct mpmc_worker *)arg;
+  uint64_t batch[BATCH];
+  size_t n;
+  size_t sent;
+  uint64_t i;
+
+  for (i = 0UL; i < self->messages; i += n)
+  {
+    for (n = 0UL; n < self->batch && i + n < self->messages; n++)
+    {
+      batch[n] = i + n;
+    }
+
+    sent = 0UL;
+
+    while ((sent += mpmc_queue_enqueue_bulk(self->queue, batch + sent, n - sent)) < n)
+    {
+      sched_yield();
+    }
+  }
+
+  return NULL;
+}
+
+static void *mpmc_consumer(void *arg)
+{
+  struct mpmc_worker *self = (struct mpmc_worker *)arg;
+  uint64_t batch[BATCH];
+  size_t n;
+  uint64_t i;
+
+  for (i = 0UL; i < self->messages; i += n)
+  {
+    const size_t want = self->messages - i < self->batch ? self->messages - i : self->batch;
+
+    while (0UL == (n = mpmc_queue_dequeue_bulk(self->queue, batch, want)))
+    {
+      sched_yield();
+    }
+  }
+
+  return NULL;
+}
+
+/*
+ * n producers and n consumers moving batch items per call; retries per
+ * message show CAS contention.
+ */
+static void bench_mpmc(const size_t n, const size_t batch)
+{
+  mpmc_queue_t *queue = mpmc_queue_create(CAPACITY / sizeof(uint64_t), sizeof(uint64_t));
+  pthread_t *threads = malloc(2UL * n * sizeof(*threads));
+  struct mpmc_worker worker = {queue, MESSAGES / n, batch};
+  mpmc_queue_stats_t stats;
+  size_t i;
+
+  const double start = now();
+
+  for (i = 0UL; i < n; i++)
+  {
+    if (0 != pthread_create(&threads[i], NULL, mpmc_producer, &worker) ||
+        0 != pthread_create(&threads[n + i], NULL, mpmc_consumer, &worker))
+    {
+      fprintf(stderr, "%s(): %s\n", __func__, "could not start a worker thread");
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  for (i = 0UL; i < 2UL * n; i++)
+  {
+    pthread_join(threads[i], NULL);
+  }
+
+  const double elapsed = now() - start;
+  const double messages = (double)(worker.messages * n);
+
+  mpmc_queue_get_stats(queue, &stats);
+
+  printf("mpmc_queue %2lu x %-2lu bulk %-2lu %8.1f Mmsgs/s  retries/msg enqueue %.3f dequeue %.3f  full %lu empty %lu\n",
+         (unsigned long)n, (unsigned long)n, (unsigned long)batch, messages / elapsed * 1e-6,
+         (double)stats.enqueue_retries / messages, (double)stats.dequeue_retries / messages,
+         (unsigned long)stats.full, (unsigned long)stats.empty);
+
+  free(threads);
+  mpmc_queue_destroy(queue);
+}
+
+struct broadcast_worker
+{
+  broadcast_ring_t *ring;
+  int               id;
+};
+
+static void *broadcast_consumer(void *arg)
+{
+  struct broadcast_worker *self = (struct broadcast_worker *)arg;
+  uint64_t sum = 0UL;
+  uint64_t seen;
+  size_t available;
+  size_t i;
+
+  for (seen = 0UL; seen < MESSAGES; seen += available)
+  {
+    while (0UL == (available = broadcast_ring_available(self->ring, self->id)))
+    {
+      sched_yield();
+    }
+
+    for (i = 0UL; i < available; i++)
+    {
+      sum += *(const uint64_t *)broadcast_ring_peek(self->ring, self->id, i);
+    }
+
+    broadcast_ring_release(self->ring, self->id, available);
+  }
+
+  return (void *)(uintptr_t)sum;
+}
+
+/* one producer, two independent consumers and a third that depends on both */
+static void bench_broadcast(void)
+{
+  broadcast_ring_t *ring = broadcast_ring_create(CAPACITY / sizeof(uint64_t), sizeof(uint64_t));
+  struct broadcast_worker workers[3];
+  pthread_t threads[3];
+  const int deps[2] = {0, 1};
+  uint64_t *slot;
+  uint64_t i;
+  int t;
+
+  broadcast_ring_add_consumer(ring, NULL, 0UL);
+  broadcast_ring_add_consumer(ring, NULL, 0UL);
+  broadcast_ring_add_consumer(ring, deps, 2UL);
+
+  const double start = now();
+
+  for (t = 0; t < 3; t++)
+  {
+    workers[t].ring = ring;
+    workers[t].id = t;
+
+    if (0 != pthread_create(&threads[t], NULL, broadcast_consumer, &workers[t]))
+    {
+      fprintf(stderr, "%s(): %s\n", __func__, "could not start a consumer thread");
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  for (i = 0UL; i < MESSAGES; i++)
+  {
+    while (NULL == (slot = broadcast_ring_reserve(ring)))
+    {
+      sched_yield();
+    }
+
+    *slot = i;
+    broadcast_ring_commit(ring);
+  }
+
+  for (t = 0; t < 3; t++)
+  {
+    pthread_join(threads[t], NULL);
+  }
+
+  const double elapsed = now() - start;
+
+  printf("broadcast_ring 1 -> 3     %8.1f Mevents/s  (%.1f M reads/s)\n",
+         (double)MESSAGES / elapsed * 1e-6, 3.0 * (double)MESSAGES / elapsed * 1e-6);
+
+  broadcast_ring_destroy(ring);
+}
+
+/* usage: bench_ring [max threads per side], one per online CPU by default */
+int main(int argc, char **argv)
+{
+  const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  const size_t max = argc > 1 ? strtoul(argv[1], NULL, 10) : (size_t)(cpus > 0L ? cpus : 1L);
+  size_t n;
+
+  bench_spsc(0);
+  bench_spsc(1);
+  bench_spsc(2);
+  bench_spsc_bulk();
+  bench_records(0);
+  bench_records(1);
+  bench_broadcast();
+
+  for (n = 1UL; n <= max; n *= 2UL)
+  {
+    bench_mpmc(n, 1UL);
+    bench_mpmc(n, BATCH);
+  }
+
+  return 0;
+}
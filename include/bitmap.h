@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2025 Da'Jour J. Christophe. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef BITMAP_H
+#define BITMAP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif/*__cplusplus*/
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Compressed bitmap of uint32_t keys. The key space is split into 64K
+ * chunks by the high 16 bits; each chunk is held as a sorted array, a
+ * 8 KiB bitmap or a list of runs, whichever the contents call for.
+ */
+typedef struct bitmap bitmap_t;
+
+bitmap_t *bitmap_new(void);
+
+void bitmap_destroy(bitmap_t *self);
+
+int bitmap_add(bitmap_t *self, const uint32_t value);
+
+int bitmap_remove(bitmap_t *self, const uint32_t value);
+
+int bitmap_contains(const bitmap_t *self, const uint32_t value);
+
+uint64_t bitmap_cardinality(const bitmap_t *self);
+
+bitmap_t *bitmap_and(const bitmap_t *a, const bitmap_t *b);
+
+bitmap_t *bitmap_or(const bitmap_t *a, const bitmap_t *b);
+
+bitmap_t *bitmap_xor(const bitmap_t *a, const bitmap_t *b);
+
+void bitmap_run_optimize(bitmap_t *self);
+
+size_t bitmap_to_array(const bitmap_t *self, uint32_t *out);
+
+size_t bitmap_memory(const bitmap_t *self);
+
+#ifdef __cplusplus
+}
+#endif/*__cplusplus*/
+
+#endif/*BITMAP_H*/
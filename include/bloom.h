@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2025 Da'Jour J. Christophe. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef BLOOM_H
+#define BLOOM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif/*__cplusplus*/
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Split-block Bloom filter. Every key maps to one 256-bit block and sets
+ * one bit in each of its eight 32-bit words, so a lookup reads a single
+ * cache line. The *_hash variants take a precomputed xxh3 value.
+ * bloom_new returns NULL unless 0 < fpp < 1.
+ */
+typedef struct bloom bloom_t;
+
+bloom_t *bloom_new(const size_t capacity, const double fpp);
+
+void bloom_destroy(bloom_t *self);
+
+void bloom_clear(bloom_t *self);
+
+void bloom_add(bloom_t *self, const void *key, const size_t keylen);
+
+int bloom_contains(const bloom_t *self, const void *key, const size_t keylen);
+
+void bloom_add_hash(bloom_t *self, const uint64_t hash);
+
+int bloom_contains_hash(const bloom_t *self, const uint64_t hash);
+
+size_t bloom_memory(const bloom_t *self);
+
+#ifdef __cplusplus
+}
+#endif/*__cplusplus*/
+
+#endif/*BLOOM_H*/
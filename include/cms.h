@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2025 Da'Jour J. Christophe. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef CMS_H
+#define CMS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif/*__cplusplus*/
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define CMS_MAX_DEPTH 16UL
+
+/*
+ * Count-Min sketch with conservative update: an add only raises the
+ * counters that are below the new minimum estimate, which keeps the
+ * overestimate for heavy hitters tight. A sketch has at most
+ * CMS_MAX_DEPTH rows; cms_new_with_error uses ceil(ln(1 / delta)) of
+ * them, so it returns NULL for delta below about 1.1e-7 (e^-16) as well
+ * as for epsilon <= 0 or delta outside (0, 1).
+ */
+typedef struct cms cms_t;
+
+cms_t *cms_new(const size_t width, const size_t depth);
+
+cms_t *cms_new_with_error(const double epsilon, const double delta);
+
+void cms_destroy(cms_t *self);
+
+uint32_t cms_add(cms_t *self, const void *key, const size_t keylen, const uint32_t count);
+
+uint32_t cms_add_hash(cms_t *self, const uint64_t hash, const uint32_t count);
+
+uint32_t cms_estimate(const cms_t *self, const void *key, const size_t keylen);
+
+uint32_t cms_estimate_hash(const cms_t *self, const uint64_t hash);
+
+uint64_t cms_total(const cms_t *self);
+
+int cms_merge(cms_t *self, const cms_t *other);
+
+size_t cms_memory(const cms_t *self);
+
+#ifdef __cplusplus
+}
+#endif/*__cplusplus*/
+
+#endif/*CMS_H*/
@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) 2025 Da'Jour J. Christophe. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef CUCKOO_H
+#define CUCKOO_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif/*__cplusplus*/
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Cuckoo filter with 4-way buckets and 8, 12 or 16-bit fingerprints
+ * packed back to back. Unlike a Bloom filter it supports removal, as
+ * long as only keys that were added are removed.
+ */
+typedef struct cuckoo cuckoo_t;
+
+cuckoo_t *cuckoo_new(const size_t capacity, const unsigned int fingerprint_bits);
+
+void cuckoo_destroy(cuckoo_t *self);
+
+int cuckoo_add(cuckoo_t *self, const void *key, const size_t keylen);
+
+int cuckoo_contains(const cuckoo_t *self, const void *key, const size_t keylen);
+
+int cuckoo_remove(cuckoo_t *self, const void *key, const size_t keylen);
+
+size_t cuckoo_count(const cuckoo_t *self);
+
+double cuckoo_false_positive_rate(const cuckoo_t *self);
+
+size_t cuckoo_memory(const cuckoo_t *self);
+
+#ifdef __cplusplus
+}
+#endif/*__cplusplus*/
+
+#endif/*CUCKOO_H*/
@@ -22,6 +22,7 @@ extern "C" {
 
 #include <stddef.h>
 #include <stdint.h>
+#include <sys/types.h>
 
 typedef struct ring_buffer_writer ring_buffer_writer_t;
 
@@ -35,16 +36,151 @@ uint64_t ring_buffer_reader_get_head(const ring_buffer_reader_t *self);
 
 uint64_t ring_buffer_reader_get_tail(const ring_buffer_reader_t *self);
 
+/*
+ * Byte ring for one producer and one consumer, which may run on different
+ * threads: enqueue is only called from the producer and dequeue from the
+ * consumer. Records may straddle the end of the buffer. The capacity is
+ * rounded up to a power of two.
+ */
 typedef struct ring_buffer ring_buffer_t;
 
 ring_buffer_t *ring_buffer_create(const size_t cap);
 
+/*
+ * A ring whose pages are mapped twice in a row, so every record up to
+ * the capacity is contiguous: copies are a single memcpy and reserve and
+ * peek never refuse a span for wrapping. The capacity is at least a page.
+ * Returns NULL where the mapping cannot be made.
+ */
+ring_buffer_t *ring_buffer_create_mirrored(const size_t cap);
+
+/*
+ * A ring that grows instead of refusing a record: it doubles when full,
+ * unrolling the wrapped bytes into the new buffer, and halves when no
+ * more than an eighth full, never below the initial capacity. Resizing
+ * moves the data and rebases the cursors, so a growable ring is for one
+ * thread that both enqueues and dequeues, and pointers from reserve or
+ * peek do not survive the next enqueue or dequeue.
+ */
+ring_buffer_t *ring_buffer_create_growable(const size_t cap);
+
+/*
+ * A ring in memory shared between processes. create_fd lays out a ring in
+ * the file behind fd, such as a memfd, and attach_fd maps one created
+ * there by another process; the named forms do the same for a POSIX
+ * shared memory object, which the creator must shm_unlink when done. The
+ * header holds no pointers, so each process may map it anywhere, and one
+ * writer and one reader exchange records with no system calls. Waits
+ * across processes sleep in short slices, and there is no eventfd. All
+ * return NULL where the memory cannot be created or is not a ring.
+ */
+ring_buffer_t *ring_buffer_create_fd(const int fd, const size_t cap);
+
+ring_buffer_t *ring_buffer_attach_fd(const int fd);
+
+ring_buffer_t *ring_buffer_create_shared(const char *name, const size_t cap);
+
+ring_buffer_t *ring_buffer_attach_shared(const char *name);
+
 void ring_buffer_destroy(ring_buffer_t *self);
 
 int ring_buffer_enqueue(ring_buffer_t *self, const void *data, size_t size);
 
 void *ring_buffer_dequeue(ring_buffer_t *self, const size_t size);
 
+int ring_buffer_dequeue_into(ring_buffer_t *self, void *data, const size_t size);
+
+/*
+ * Move up to n records of size bytes, packed back to back in data, with
+ * one cursor update. Both return the number of records moved.
+ */
+size_t ring_buffer_enqueue_bulk(ring_buffer_t *self, const void *data, const size_t size, const size_t n);
+
+size_t ring_buffer_dequeue_bulk(ring_buffer_t *self, void *data, const size_t size, const size_t n);
+
+/*
+ * Zero-copy access: reserve returns size bytes of the ring to fill and
+ * commit publishes them; peek returns the next size bytes in place and
+ * release frees them. Both return NULL when the span is not available as
+ * one piece, which cannot happen while every record has the same size
+ * and that size divides the capacity.
+ */
+void *ring_buffer_reserve(ring_buffer_t *self, const size_t size);
+
+void ring_buffer_commit(ring_buffer_t *self, const size_t size);
+
+const void *ring_buffer_peek(ring_buffer_t *self, const size_t size);
+
+void ring_buffer_release(ring_buffer_t *self, const size_t size);
+
+/*
+ * Framed records of any length up to UINT32_MAX, each behind a small
+ * header and kept 8-byte aligned, so the reader need not know the size of
+ * the next record. reserve_frame returns room for len bytes and
+ * commit_frame publishes the first len of them (at most the reserved
+ * length); write_frame does both with a copy. read_frame returns the next
+ * payload in place and its length, or NULL when empty, and release_frame
+ * frees it. A ring used for frames should carry nothing but frames. On
+ * a fixed, unmirrored ring a frame, header and padding included, may take
+ * at most half the capacity, so that it fits wherever the cursor stands
+ * once the ring drains; larger frames are refused at once.
+ */
+void *ring_buffer_reserve_frame(ring_buffer_t *self, const size_t len);
+
+void ring_buffer_commit_frame(ring_buffer_t *self, const size_t len);
+
+int ring_buffer_write_frame(ring_buffer_t *self, const void *data, const size_t len);
+
+const void *ring_buffer_read_frame(ring_buffer_t *self, size_t *len);
+
+void ring_buffer_release_frame(ring_buffer_t *self, const size_t len);
+
+/*
+ * Block the consumer until size bytes can be read, or the producer until
+ * size bytes can be written, spinning briefly before sleeping. timeout is
+ * in milliseconds, -1 waits forever and 0 only polls; both return -1 when
+ * it runs out. Publishes wake a sleeper only when one has said it is
+ * going to sleep, so they cost nothing otherwise. A poll or timeout
+ * leaves the consumer's request armed: the eventfd, created by the first
+ * ring_buffer_get_eventfd, becomes readable on the next publish, which
+ * lets the ring sit in an epoll loop. The fd is -1 where unsupported.
+ */
+int ring_buffer_wait_nonempty(ring_buffer_t *self, const size_t size, const int timeout);
+
+int ring_buffer_wait_nonfull(ring_buffer_t *self, const size_t size, const int timeout);
+
+int ring_buffer_get_eventfd(ring_buffer_t *self);
+
+/*
+ * Move bytes between the ring and a file descriptor without a staging
+ * copy, with one readv or writev over the (at most two) regions involved.
+ * write_fd is called by the consumer and sends up to max readable bytes,
+ * releasing what was written; read_fd is called by the producer and reads
+ * up to max bytes into free space, committing what arrived. Both return
+ * the byte count as write and read do, except that read_fd on a full ring
+ * returns -1 with errno set to ENOBUFS.
+ */
+ssize_t ring_buffer_write_fd(ring_buffer_t *self, const int fd, const size_t max);
+
+ssize_t ring_buffer_read_fd(ring_buffer_t *self, const int fd, const size_t max);
+
+/*
+ * Asynchronous draining of a ring to fd through io_uring, for the
+ * consumer. Each flush releases the bytes whose writes have completed
+ * and, when none are in flight, submits everything readable in a single
+ * system call; with wait set it also blocks for a completion. flush
+ * returns the bytes released, or -1 with errno set after a failed write
+ * or where io_uring is unavailable. create returns NULL for a growable
+ * ring or where io_uring cannot be set up.
+ */
+typedef struct ring_buffer_uring ring_buffer_uring_t;
+
+ring_buffer_uring_t *ring_buffer_uring_create(ring_buffer_t *ring, const int fd);
+
+void ring_buffer_uring_destroy(ring_buffer_uring_t *self);
+
+ssize_t ring_buffer_uring_flush(ring_buffer_uring_t *self, const int wait);
+
 size_t ring_buffer_size(const ring_buffer_t *self);
 
 size_t ring_buffer_get_cap(const ring_buffer_t *self);
@@ -55,6 +191,103 @@ ring_buffer_reader_t *ring_buffer_get_reader(const ring_buffer_t *self);
 
 uint8_t *ring_buffer_get_data(const ring_buffer_t *self);
 
+/*
+ * Bounded queue of fixed-size items for any number of producers and
+ * consumers. The capacity is rounded up to a power of two. enqueue and
+ * dequeue return -1 when the queue is full or empty. The stats count CAS
+ * retries and failed calls, as a measure of contention.
+ */
+typedef struct mpmc_queue mpmc_queue_t;
+
+typedef struct
+{
+  uint64_t enqueue_retries;
+  uint64_t dequeue_retries;
+  uint64_t full;
+  uint64_t empty;
+} mpmc_queue_stats_t;
+
+mpmc_queue_t *mpmc_queue_create(const size_t cap, const size_t size);
+
+void mpmc_queue_destroy(mpmc_queue_t *self);
+
+int mpmc_queue_enqueue(mpmc_queue_t *self, const void *data);
+
+int mpmc_queue_dequeue(mpmc_queue_t *self, void *data);
+
+/* up to n items with one CAS; return the number moved */
+size_t mpmc_queue_enqueue_bulk(mpmc_queue_t *self, const void *data, const size_t n);
+
+size_t mpmc_queue_dequeue_bulk(mpmc_queue_t *self, void *data, const size_t n);
+
+size_t mpmc_queue_size(const mpmc_queue_t *self);
+
+size_t mpmc_queue_get_cap(const mpmc_queue_t *self);
+
+void mpmc_queue_get_stats(const mpmc_queue_t *self, mpmc_queue_stats_t *stats);
+
+/*
+ * Broadcast ring of fixed-size events for one producer and up to
+ * BROADCAST_RING_CONSUMERS consumers, each of which sees every event in
+ * place. Consumers are added before the first event is published, and
+ * each may depend on consumers added before it, reading an event only
+ * after all of them have released it. reserve returns the next slot to
+ * fill, or NULL while the slowest consumer still holds it, and commit
+ * publishes it; publish does both with a copy. available returns how many
+ * events consumer id may read now, peek returns the index-th of them and
+ * release marks the first n processed. The capacity is rounded up to a
+ * power of two.
+ */
+#define BROADCAST_RING_CONSUMERS 16
+
+typedef struct broadcast_ring broadcast_ring_t;
+
+broadcast_ring_t *broadcast_ring_create(const size_t cap, const size_t size);
+
+void broadcast_ring_destroy(broadcast_ring_t *self);
+
+int broadcast_ring_add_consumer(broadcast_ring_t *self, const int *deps, const size_t n);
+
+void *broadcast_ring_reserve(broadcast_ring_t *self);
+
+void broadcast_ring_commit(broadcast_ring_t *self);
+
+int broadcast_ring_publish(broadcast_ring_t *self, const void *data);
+
+size_t broadcast_ring_available(broadcast_ring_t *self, const int id);
+
+const void *broadcast_ring_peek(const broadcast_ring_t *self, const int id, const size_t index);
+
+void broadcast_ring_release(broadcast_ring_t *self, const int id, const size_t n);
+
+size_t broadcast_ring_get_cap(const broadcast_ring_t *self);
+
+/*
+ * Double-ended queue of fixed-size elements, stored inline in blocks so
+ * that growth at either end never moves existing elements. Pops copy the
+ * element out when data is not NULL and return -1 when empty; deque_at
+ * returns a pointer to the index-th element from the front, valid until
+ * that element is popped, or NULL past the end. deque_create returns NULL
+ * for a zero element size.
+ */
+typedef struct deque deque_t;
+
+deque_t *deque_create(const size_t size);
+
+void deque_destroy(deque_t *self);
+
+int deque_push_front(deque_t *self, const void *data);
+
+int deque_push_back(deque_t *self, const void *data);
+
+int deque_pop_front(deque_t *self, void *data);
+
+int deque_pop_back(deque_t *self, void *data);
+
+void *deque_at(const deque_t *self, const size_t index);
+
+size_t deque_size(const deque_t *self);
+
 #ifdef __cplusplus
 }
 #endif/*__cplusplus*/
@@ -20,15 +20,35 @@
 extern "C" {
 #endif/*__cplusplus*/
 
+#include "deque.h"
 #include "map.h"
+#include "set.h"
 
 #include <stddef.h>
+#include <stdint.h>
 
 typedef struct graph_node graph_node_t;
 
+struct graph_edge
+{
+  graph_node_t *dest;
+};
+
+typedef struct graph_edge graph_edge_t;
+
+struct graph_node
+{
+  void *data;
+  size_t size;
+  uint32_t id;
+  set_t *edges;
+};
+
 struct graph
 {
   map_t *nodes;
+  deque_t *index;
+  uint32_t num_nodes;
 };
 
 typedef struct graph graph_t;
@@ -41,8 +61,6 @@ void graph_bfs(graph_t *self, const void *start_data, const size_t size);
 
 void graph_dfs(graph_t *self, const void *start_data, const size_t size);
 
-static graph_node_t *graph_add_node(graph_t *self, const void *data, const size_t size);
-
 void graph_add_edge(graph_t *self, const void *a, const size_t as, const void *b, const size_t bs);
 
 #ifdef __cplusplus
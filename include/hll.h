@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2025 Da'Jour J. Christophe. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef HLL_H
+#define HLL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif/*__cplusplus*/
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * HyperLogLog distinct counter with 2^precision registers. Small
+ * sketches keep a sorted sparse list of (register, rank) pairs and
+ * switch to one byte per register once that would be smaller.
+ */
+typedef struct hll hll_t;
+
+hll_t *hll_new(const unsigned int precision);
+
+void hll_destroy(hll_t *self);
+
+void hll_add(hll_t *self, const void *key, const size_t keylen);
+
+void hll_add_hash(hll_t *self, const uint64_t hash);
+
+void hll_add_hashes(hll_t *self, const uint64_t *hashes, const size_t n);
+
+uint64_t hll_count(const hll_t *self);
+
+int hll_merge(hll_t *self, const hll_t *other);
+
+int hll_is_sparse(const hll_t *self);
+
+size_t hll_memory(const hll_t *self);
+
+#ifdef __cplusplus
+}
+#endif/*__cplusplus*/
+
+#endif/*HLL_H*/
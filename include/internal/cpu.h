@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2025 Da'Jour J. Christophe. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef CPU_H
+#define CPU_H
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CPU_X86 1
+#endif
+
+#define CPU_SSE2   (1U << 0)
+#define CPU_SSSE3  (1U << 1)
+#define CPU_POPCNT (1U << 2)
+#define CPU_AVX2   (1U << 3)
+#define CPU_BMI2   (1U << 4)
+#define CPU_AVX512 (1U << 5)
+#define CPU_SSE42  (1U << 6)
+#define CPU_AES    (1U << 7)
+
+/*
+ * SIMD kernels are compiled for their instruction set with cpu_target()
+ * rather than for the build host, and callers pick one with cpu_has().
+ * cpu_features is filled in when the library is loaded; until then it is
+ * zero and every caller takes its portable path.
+ */
+#define cpu_target(isa) __attribute__ ((target(isa)))
+
+extern unsigned int cpu_features;
+
+static inline int cpu_has(const unsigned int features)
+{
+  return (cpu_features & features) == features;
+}
+
+unsigned int cpu_detect(void);
+
+/* limit dispatch to a subset of the detected features, for tests and benchmarks */
+void cpu_restrict(const unsigned int mask);
+
+#endif/*CPU_H*/
@@ -19,8 +19,76 @@
 #include <stddef.h>
 #include <stdint.h>
 
+typedef struct
+{
+  uint64_t low64;
+  uint64_t high64;
+} xxh128_t;
+
 uint64_t xxh3(const void *data, size_t len, uint64_t seed);
 
+xxh128_t xxh3_128(const void *data, size_t len, uint64_t seed);
+
+/*
+ * Hashes n keys of len bytes each, stride bytes apart, into out. Equal to
+ * calling xxh3() per key; short keys are hashed several per instruction.
+ */
+void xxh3_batch(const void *keys, size_t stride, size_t len, size_t n, uint64_t seed, uint64_t *out);
+
+#define XXH3_BUFFER_SIZE 256
+
+/*
+ * Incremental hashing of keys that arrive in pieces. After any sequence
+ * of updates, the digests equal the one-shot hash of the concatenated
+ * input. A state may live on the stack or in memory from malloc() and is
+ * reused by resetting it; it needs no more than natural alignment.
+ */
+typedef struct
+{
+  uint64_t acc[8];
+  uint8_t  secret[192];
+  uint8_t  buffer[XXH3_BUFFER_SIZE];
+  uint64_t seed;
+  uint64_t total_len;
+  size_t   buffered;
+  size_t   stripes;
+} xxh3_state_t;
+
+void xxh3_reset(xxh3_state_t *state, uint64_t seed);
+
+void xxh3_update(xxh3_state_t *state, const void *data, size_t len);
+
+uint64_t xxh3_digest(const xxh3_state_t *state);
+
+xxh128_t xxh3_128_digest(const xxh3_state_t *state);
+
+#define XXH3_TREE_LEAF (1UL << 20)
+
+/*
+ * Tree hash for large inputs: each XXH3_TREE_LEAF-byte leaf is hashed
+ * with xxh3_128 on one of threads workers (0 for one per online CPU), and
+ * the leaf digests, in order, are hashed again with xxh3. The value does
+ * not depend on the thread count, but differs from xxh3() of the input.
+ */
+uint64_t xxh3_tree(const void *data, size_t len, uint64_t seed, unsigned int threads);
+
+/* xxh3_tree() of a file's contents, read through mmap; -1 if it cannot be read */
+int xxh3_tree_file(const char *path, uint64_t seed, unsigned int threads, uint64_t *out);
+
+/*
+ * Alternatives to xxh3 for short keys. crc32c_mix runs two CRC32C lanes
+ * and finishes with a 64-bit mixer; aes_mix absorbs 16-byte blocks with
+ * AES rounds. Both give the same values with and without SSE4.2 and
+ * AES-NI, but neither is meant to resist chosen-key attacks.
+ */
+typedef uint64_t (*hash_fn_t)(const void *data, size_t len, uint64_t seed);
+
+uint64_t crc32c_mix(const void *data, size_t len, uint64_t seed);
+
+uint64_t aes_mix(const void *data, size_t len, uint64_t seed);
+
 #define __hash__(data, len, seed) xxh3(data, len, seed)
 
+#define __hash128__(data, len, seed) xxh3_128(data, len, seed)
+
 #endif/*HASH_H*/
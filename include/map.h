@@ -21,6 +21,7 @@ extern "C" {
 #endif/*__cplusplus*/
 
 #include "internal/hash.h"
+#include "bloom.h"
 
 #include <stddef.h>
 #include <stdint.h>
@@ -31,6 +32,9 @@ struct map
 {
   bucket_t **buckets;
     size_t   size;
+   bloom_t  *filter;
+       int   identity;
+ hash_fn_t   hash;
 };
 
 typedef struct map map_t;
@@ -46,8 +50,36 @@ int map_exists(map_t *self, const void *key, const size_t keylen);
 int map_set(map_t *self, const void *key,  const size_t keylen,
                          const void *data, const size_t datalen);
 
+/*
+ * Batched forms for n fixed-size keys packed back to back (and, for
+ * map_set_batch, n values of datalen bytes likewise). map_exists_batch
+ * stores each result in found when it is not NULL and returns the count
+ * of keys present; map_set_batch returns -1 if any key did not fit.
+ */
+int map_set_batch(map_t *self, const void *keys, const size_t keylen,
+                               const void *data, const size_t datalen, const size_t n);
+
+size_t map_exists_batch(map_t *self, const void *keys, const size_t keylen, const size_t n, int *found);
+
 int map_del(map_t *self, const void *key, const size_t keylen);
 
+int map_enable_filter(map_t *self, const double fpp);
+
+void map_compact(map_t *self);
+
+/*
+ * Treat keys with equal 128-bit xxh3 hashes as the same key and skip
+ * the byte comparison, for content-addressed use.
+ */
+void map_enable_identity(map_t *self);
+
+/*
+ * Hash keys with fn instead of xxh3 (e.g. crc32c_mix or aes_mix for short
+ * fixed-size keys) and rehash what is already stored. Identity mode keeps
+ * using the 128-bit xxh3.
+ */
+void map_use_hash(map_t *self, const hash_fn_t fn);
+
 #ifdef __cplusplus
 }
 #endif/*__cplusplus*/
@@ -21,6 +21,7 @@ extern "C" {
 #endif/*__cplusplus*/
 
 #include "internal/hash.h"
+#include "bloom.h"
 
 #include <stddef.h>
 #include <stdint.h>
@@ -31,6 +32,9 @@ struct set
 {
   bucket_t **buckets;
     size_t   size;
+   bloom_t  *filter;
+       int   identity;
+ hash_fn_t   hash;
 };
 
 typedef struct set set_t;
@@ -49,6 +53,49 @@ int set_add(set_t *self, const void *key, const size_t keylen);
 
 int set_remove(set_t *self, const void *key, const size_t keylen);
 
+int set_enable_filter(set_t *self, const double fpp);
+
+void set_compact(set_t *self);
+
+/*
+ * Treat keys with equal 128-bit xxh3 hashes as the same key and skip
+ * the byte comparison, for content-addressed use.
+ */
+void set_enable_identity(set_t *self);
+
+/*
+ * Hash keys with fn instead of xxh3 (e.g. crc32c_mix or aes_mix for short
+ * fixed-size keys) and rehash what is already stored. Identity mode keeps
+ * using the 128-bit xxh3.
+ */
+void set_use_hash(set_t *self, const hash_fn_t fn);
+
+set_t *set_union(set_t *a, set_t *b);
+
+set_t *set_intersect(set_t *a, set_t *b);
+
+set_t *set_difference(set_t *a, set_t *b);
+
+int set_is_subset(set_t *a, set_t *b);
+
+/*
+ * Sorted integer sets: strictly ascending arrays of uint32_t. The output
+ * buffer must hold na + nb elements for a union and min(na, nb) or na
+ * elements for an intersection or difference. Each returns the number
+ * of elements written.
+ */
+size_t set_union_u32(const uint32_t *a, const size_t na,
+                     const uint32_t *b, const size_t nb, uint32_t *out);
+
+size_t set_intersect_u32(const uint32_t *a, const size_t na,
+                         const uint32_t *b, const size_t nb, uint32_t *out);
+
+size_t set_difference_u32(const uint32_t *a, const size_t na,
+                          const uint32_t *b, const size_t nb, uint32_t *out);
+
+int set_is_subset_u32(const uint32_t *a, const size_t na,
+                      const uint32_t *b, const size_t nb);
+
 #ifdef __cplusplus
 }
 #endif/*__cplusplus*/
@@ -0,0 +1,930 @@
+/*
+ * Copyright (C) 2025 Da'Jour J. Christophe. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "internal/cpu.h"
+#include "bitmap.h"
+#include "common.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(CPU_X86)
+#include <immintrin.h>
+#endif
+
+#define BITMAP_ARRAY_MAX 4096U
+#define BITMAP_WORDS     1024U
+
+enum
+{
+  CONTAINER_ARRAY,
+  CONTAINER_BITMAP,
+  CONTAINER_RUN,
+};
+
+enum
+{
+  BITMAP_OP_AND,
+  BITMAP_OP_OR,
+  BITMAP_OP_XOR,
+};
+
+/*
+ * values holds the sorted members of an array container, or (start,
+ * length - 1) pairs for a run container. words holds a bitmap container.
+ */
+typedef struct container
+{
+  uint8_t   type;
+  uint32_t  cardinality;
+  uint32_t  cap;
+  uint16_t *values;
+  uint64_t *words;
+} container_t;
+
+struct bitmap
+{
+  uint16_t    *keys;
+  container_t *containers;
+  size_t       size;
+  size_t       cap;
+};
+
+static uint16_t *container_values_new(const size_t count)
+{
+  uint16_t *values = NULL;
+
+  values = (uint16_t *)calloc(count > 0UL ? count : 1UL, sizeof(*values));
+  if (values == NULL)
+  {
+    fprintf(stderr, "%s(): %s\n", __func__, "could not allocate container.values to the heap");
+    exit(EXIT_FAILURE);
+  }
+
+  return values;
+}
+
+static uint64_t *container_words_new(void)
+{
+  uint64_t *words = NULL;
+
+  words = (uint64_t *)calloc(BITMAP_WORDS, sizeof(*words));
+  if (words == NULL)
+  {
+    fprintf(stderr, "%s(): %s\n", __func__, "could not allocate container.words to the heap");
+    exit(EXIT_FAILURE);
+  }
+
+  return words;
+}
+
+static void container_destroy(container_t *self)
+{
+  if (self->values != NULL)
+  {
+    free(self->values);
+    self->values = NULL;
+  }
+
+  if (self->words != NULL)
+  {
+    free(self->words);
+    self->words = NULL;
+  }
+}
+
+static container_t container_array(const uint32_t cap)
+{
+  container_t self = {CONTAINER_ARRAY, 0U, cap, NULL, NULL};
+
+  self.values = container_values_new(cap);
+
+  return self;
+}
+
+static container_t container_clone(const container_t *other)
+{
+  container_t self = *other;
+
+  if (other->type == CONTAINER_BITMAP)
+  {
+    self.words = container_words_new();
+    memcpy(self.words, other->words, BITMAP_WORDS * sizeof(*self.words));
+  }
+  else if (other->type == CONTAINER_RUN)
+  {
+    self.values = container_values_new(2UL * other->cap);
+    memcpy(self.values, other->values, 2UL * other->cap * sizeof(*self.values));
+  }
+  else
+  {
+    self.values = container_values_new(other->cap);
+    memcpy(self.values, other->values, other->cardinality * sizeof(*self.values));
+  }
+
+  return self;
+}
+
+/*
+ * Expands any container into a 1024-word bitmap. Bitmap containers are
+ * returned as-is; the others are written into scratch.
+ */
+static const uint64_t *container_words(const container_t *self, uint64_t *scratch)
+{
+  uint32_t i;
+
+  if (self->type == CONTAINER_BITMAP)
+  {
+    return self->words;
+  }
+
+  memset(scratch, 0, BITMAP_WORDS * sizeof(*scratch));
+
+  if (self->type == CONTAINER_ARRAY)
+  {
+    for (i = 0U; i < self->cardinality; i++)
+    {
+      scratch[self->values[i] >> 6] |= 1ULL << (self->values[i] & 63U);
+    }
+
+    return scratch;
+  }
+
+  for (i = 0U; i < self->cap; i++)
+  {
+    uint32_t value = self->values[2U * i];
+    const uint32_t last = value + self->values[2U * i + 1U];
+
+    for (; value <= last; value++)
+    {
+      scratch[value >> 6] |= 1ULL << (value & 63U);
+    }
+  }
+
+  return scratch;
+}
+
+static void container_from_words(container_t *self, const uint64_t *words, const uint32_t cardinality)
+{
+  uint32_t i;
+  uint32_t k = 0U;
+
+  self->cardinality = cardinality;
+
+  if (cardinality > BITMAP_ARRAY_MAX)
+  {
+    self->type = CONTAINER_BITMAP;
+    self->cap = 0U;
+    self->words = container_words_new();
+    memcpy(self->words, words, BITMAP_WORDS * sizeof(*words));
+    return;
+  }
+
+  self->type = CONTAINER_ARRAY;
+  self->cap = cardinality;
+  self->values = container_values_new(cardinality);
+
+  for (i = 0U; i < BITMAP_WORDS; i++)
+  {
+    uint64_t word = words[i];
+
+    while (word != 0ULL)
+    {
+      self->values[k++] = (uint16_t)((i << 6) + (uint32_t)__builtin_ctzll(word));
+      word &= word - 1ULL;
+    }
+  }
+}
+
+static void container_convert(container_t *self)
+{
+  uint64_t scratch[BITMAP_WORDS];
+  container_t other = {0};
+
+  container_from_words(&other, container_words(self, scratch), self->cardinality);
+  container_destroy(self);
+  *self = other;
+}
+
+static void container_to_bitmap(container_t *self)
+{
+  uint64_t *words = container_words_new();
+  const uint32_t cardinality = self->cardinality;
+
+  container_words(self, words);
+  container_destroy(self);
+
+  self->type = CONTAINER_BITMAP;
+  self->cardinality = cardinality;
+  self->cap = 0U;
+  self->words = words;
+}
+
+static uint32_t container_find(const uint16_t *values, const uint32_t count, const uint16_t value)
+{
+  uint32_t lo = 0U;
+  uint32_t hi = count;
+
+  while (lo < hi)
+  {
+    const uint32_t mid = lo + ((hi - lo) >> 1);
+
+    if (values[mid] < value)
+    {
+      lo = mid + 1U;
+    }
+    else
+    {
+      hi = mid;
+    }
+  }
+
+  return lo;
+}
+
+static int container_contains(const container_t *self, const uint16_t value)
+{
+  uint32_t i;
+
+  switch (self->type)
+  {
+    case CONTAINER_BITMAP:
+      return (int)((self->words[value >> 6] >> (value & 63U)) & 1ULL);
+
+    case CONTAINER_ARRAY:
+      i = container_find(self->values, self->cardinality, value);
+      return i < self->cardinality && self->values[i] == value;
+
+    default:
+      break;
+  }
+
+  uint32_t lo = 0U;
+  uint32_t hi = self->cap;
+
+  while (lo < hi)
+  {
+    const uint32_t mid = lo + ((hi - lo) >> 1);
+
+    if (self->values[2U * mid] <= value)
+    {
+      lo = mid + 1U;
+    }
+    else
+    {
+      hi = mid;
+    }
+  }
+
+  if (lo == 0U)
+  {
+    return 0;
+  }
+
+  i = lo - 1U;
+
+  return (uint32_t)value <= (uint32_t)self->values[2U * i] + self->values[2U * i + 1U];
+}
+
+static int container_add(container_t *self, const uint16_t value)
+{
+  uint32_t i;
+
+  if (self->type == CONTAINER_RUN)
+  {
+    container_convert(self);
+  }
+
+  if (self->type == CONTAINER_ARRAY)
+  {
+    i = container_find(self->values, self->cardinality, value);
+
+    if (i < self->cardinality && self->values[i] == value)
+    {
+      return 0;
+    }
+
+    if (self->cardinality == BITMAP_ARRAY_MAX)
+    {
+      container_to_bitmap(self);
+    }
+    else
+    {
+      if (self->cardinality == self->cap)
+      {
+        uint16_t *old = self->values;
+        uint32_t cap = self->cap > 0U ? self->cap * 2U : 4U;
+
+        cap = cap < BITMAP_ARRAY_MAX ? cap : BITMAP_ARRAY_MAX;
+
+        self->values = (uint16_t *)realloc(old, cap * sizeof(*self->values));
+        if (self->values == NULL)
+        {
+          fprintf(stderr, "%s(): %s\n", __func__, "could not reallocate container.values to the heap");
+          exit(EXIT_FAILURE);
+        }
+
+        self->cap = cap;
+      }
+
+      memmove(self->values + i + 1U, self->values + i, (self->cardinality - i) * sizeof(*self->values));
+      self->values[i] = value;
+      self->cardinality++;
+
+      return 1;
+    }
+  }
+
+  const uint64_t bit = 1ULL << (value & 63U);
+
+  if ((self->words[value >> 6] & bit) != 0ULL)
+  {
+    return 0;
+  }
+
+  self->words[value >> 6] |= bit;
+  self->cardinality++;
+
+  return 1;
+}
+
+static int container_remove(container_t *self, const uint16_t value)
+{
+  uint32_t i;
+
+  if (0 == container_contains(self, value))
+  {
+    return 0;
+  }
+
+  if (self->type == CONTAINER_RUN)
+  {
+    container_convert(self);
+  }
+
+  if (self->type == CONTAINER_ARRAY)
+  {
+    i = container_find(self->values, self->cardinality, value);
+    memmove(self->values + i, self->values + i + 1U, (self->cardinality - i - 1U) * sizeof(*self->values));
+    self->cardinality--;
+
+    return 1;
+  }
+
+  self->words[value >> 6] &= ~(1ULL << (value & 63U));
+  self->cardinality--;
+
+  if (self->cardinality <= BITMAP_ARRAY_MAX)
+  {
+    container_convert(self);
+  }
+
+  return 1;
+}
+
+#if defined(CPU_X86)
+static cpu_target("avx2,popcnt") uint32_t bitmap_words_op_avx2(const uint64_t *a, const uint64_t *b, uint64_t *out, const int op)
+{
+  uint32_t cardinality = 0U;
+  uint32_t i;
+
+  for (i = 0U; i < BITMAP_WORDS; i += 4U)
+  {
+    const __m256i va = _mm256_loadu_si256((const __m256i *)(a + i));
+    const __m256i vb = _mm256_loadu_si256((const __m256i *)(b + i));
+    __m256i vr;
+
+    switch (op)
+    {
+      case BITMAP_OP_AND: vr = _mm256_and_si256(va, vb); break;
+      case BITMAP_OP_OR:  vr = _mm256_or_si256(va, vb);  break;
+      default:            vr = _mm256_xor_si256(va, vb); break;
+    }
+
+    _mm256_storeu_si256((__m256i *)(out + i), vr);
+
+    cardinality += (uint32_t)__builtin_popcountll(out[i]);
+    cardinality += (uint32_t)__builtin_popcountll(out[i + 1U]);
+    cardinality += (uint32_t)__builtin_popcountll(out[i + 2U]);
+    cardinality += (uint32_t)__builtin_popcountll(out[i + 3U]);
+  }
+
+  return cardinality;
+}
+#endif
+
+/*
+ * Applies op to two full bitmaps and returns the popcount of the result,
+ * so cardinality falls out of the same pass.
+ */
+static uint32_t bitmap_words_op(const uint64_t *a, const uint64_t *b, uint64_t *out, const int op)
+{
+  uint32_t cardinality = 0U;
+  uint32_t i;
+
+#if defined(CPU_X86)
+  if (cpu_has(CPU_AVX2 | CPU_POPCNT))
+  {
+    return bitmap_words_op_avx2(a, b, out, op);
+  }
+#endif
+
+  for (i = 0U; i < BITMAP_WORDS; i++)
+  {
+    switch (op)
+    {
+      case BITMAP_OP_AND: out[i] = a[i] & b[i]; break;
+      case BITMAP_OP_OR:  out[i] = a[i] | b[i]; break;
+      default:            out[i] = a[i] ^ b[i]; break;
+    }
+
+    cardinality += (uint32_t)__builtin_popcountll(out[i]);
+  }
+
+  return cardinality;
+}
+
+static uint32_t container_merge_arrays(const container_t *a, const container_t *b, uint16_t *out, const int op)
+{
+  uint32_t i = 0U;
+  uint32_t j = 0U;
+  uint32_t k = 0U;
+
+  while (i < a->cardinality && j < b->cardinality)
+  {
+    const uint16_t x = a->values[i];
+    const uint16_t y = b->values[j];
+
+    if (x == y)
+    {
+      if (op != BITMAP_OP_XOR)
+      {
+        out[k++] = x;
+      }
+    }
+    else if (op != BITMAP_OP_AND)
+    {
+      out[k++] = x < y ? x : y;
+    }
+
+    i += x <= y;
+    j += y <= x;
+  }
+
+  if (op != BITMAP_OP_AND)
+  {
+    while (i < a->cardinality)
+    {
+      out[k++] = a->values[i++];
+    }
+
+    while (j < b->cardinality)
+    {
+      out[k++] = b->values[j++];
+    }
+  }
+
+  return k;
+}
+
+static container_t container_op(const container_t *a, const container_t *b, const int op)
+{
+  container_t self = {0};
+
+  if (a->type == CONTAINER_ARRAY && b->type == CONTAINER_ARRAY &&
+      a->cardinality + b->cardinality <= BITMAP_ARRAY_MAX)
+  {
+    self = container_array(a->cardinality + b->cardinality);
+    self.cardinality = container_merge_arrays(a, b, self.values, op);
+    return self;
+  }
+
+  if (op == BITMAP_OP_AND && (a->type == CONTAINER_ARRAY || b->type == CONTAINER_ARRAY))
+  {
+    const container_t *small = a->type == CONTAINER_ARRAY ? a : b;
+    const container_t *large = a->type == CONTAINER_ARRAY ? b : a;
+    uint32_t i;
+
+    self = container_array(small->cardinality);
+
+    for (i = 0U; i < small->cardinality; i++)
+    {
+      if (1 == container_contains(large, small->values[i]))
+      {
+        self.values[self.cardinality++] = small->values[i];
+      }
+    }
+
+    return self;
+  }
+
+  uint64_t scratch_a[BITMAP_WORDS];
+  uint64_t scratch_b[BITMAP_WORDS];
+  uint64_t words[BITMAP_WORDS];
+
+  const uint32_t cardinality = bitmap_words_op(container_words(a, scratch_a),
+                                               container_words(b, scratch_b), words, op);
+  container_from_words(&self, words, cardinality);
+
+  return self;
+}
+
+static uint32_t container_count_runs(const container_t *self)
+{
+  uint32_t runs = 0U;
+  uint32_t i;
+
+  switch (self->type)
+  {
+    case CONTAINER_RUN:
+      return self->cap;
+
+    case CONTAINER_ARRAY:
+      for (i = 0U; i < self->cardinality; i++)
+      {
+        runs += (i == 0U || self->values[i] != (uint16_t)(self->values[i - 1U] + 1U));
+      }
+      return runs;
+
+    default:
+      break;
+  }
+
+  uint64_t carry = 0ULL;
+
+  for (i = 0U; i < BITMAP_WORDS; i++)
+  {
+    const uint64_t word = self->words[i];
+
+    runs += (uint32_t)__builtin_popcountll(word & ~((word << 1) | carry));
+    carry = word >> 63;
+  }
+
+  return runs;
+}
+
+static void container_to_runs(container_t *self, const uint32_t runs)
+{
+  uint64_t scratch[BITMAP_WORDS];
+  const uint64_t *words = container_words(self, scratch);
+  uint16_t *values = container_values_new(2UL * runs);
+  uint32_t k = 0U;
+  uint32_t value = 0U;
+
+  while (value < 65536U)
+  {
+    if (((words[value >> 6] >> (value & 63U)) & 1ULL) == 0ULL)
+    {
+      value++;
+      continue;
+    }
+
+    const uint32_t start = value;
+
+    while (value < 65536U && ((words[value >> 6] >> (value & 63U)) & 1ULL) != 0ULL)
+    {
+      value++;
+    }
+
+    values[2U * k] = (uint16_t)start;
+    values[2U * k + 1U] = (uint16_t)(value - start - 1U);
+    k++;
+  }
+
+  const uint32_t cardinality = self->cardinality;
+
+  container_destroy(self);
+
+  self->type = CONTAINER_RUN;
+  self->cardinality = cardinality;
+  self->cap = runs;
+  self->values = values;
+}
+
+static size_t container_memory(const container_t *self)
+{
+  switch (self->type)
+  {
+    case CONTAINER_BITMAP: return BITMAP_WORDS * sizeof(uint64_t);
+    case CONTAINER_RUN:    return 2UL * self->cap * sizeof(uint16_t);
+    default:               return self->cap * sizeof(uint16_t);
+  }
+}
+
+bitmap_t *bitmap_new(void)
+{
+  bitmap_t *self = NULL;
+
+  self = (bitmap_t *)calloc(1UL, sizeof(*self));
+  if (self == NULL)
+  {
+    fprintf(stderr, "%s(): %s\n", __func__, "could not allocate bitmap to the heap");
+    exit(EXIT_FAILURE);
+  }
+
+  return self;
+}
+
+void bitmap_destroy(bitmap_t *self)
+{
+  if (self != NULL)
+  {
+    size_t i;
+
+    for (i = 0UL; i < self->size; i++)
+    {
+      container_destroy(&self->containers[i]);
+    }
+
+    free(self->containers);
+    self->containers = NULL;
+
+    free(self->keys);
+    self->keys = NULL;
+
+    free(self);
+    self = NULL;
+  }
+}
+
+static size_t bitmap_find(const bitmap_t *self, const uint16_t key)
+{
+  size_t lo = 0UL;
+  size_t hi = self->size;
+
+  while (lo < hi)
+  {
+    const size_t mid = lo + ((hi - lo) >> 1);
+
+    if (self->keys[mid] < key)
+    {
+      lo = mid + 1UL;
+    }
+    else
+    {
+      hi = mid;
+    }
+  }
+
+  return lo;
+}
+
+static void bitmap_insert(bitmap_t *self, const size_t i, const uint16_t key, const container_t container)
+{
+  if (self->size == self->cap)
+  {
+    const size_t cap = self->cap > 0UL ? self->cap * 2UL : 4UL;
+    uint16_t *keys = NULL;
+    container_t *containers = NULL;
+
+    keys = (uint16_t *)realloc(self->keys, cap * sizeof(*keys));
+    if (keys == NULL)
+    {
+      fprintf(stderr, "%s(): %s\n", __func__, "could not reallocate bitmap.keys to the heap");
+      exit(EXIT_FAILURE);
+    }
+    self->keys = keys;
+
+    containers = (container_t *)realloc(self->containers, cap * sizeof(*containers));
+    if (containers == NULL)
+    {
+      fprintf(stderr, "%s(): %s\n", __func__, "could not reallocate bitmap.containers to the heap");
+      exit(EXIT_FAILURE);
+    }
+    self->containers = containers;
+
+    self->cap = cap;
+  }
+
+  memmove(self->keys + i + 1UL, self->keys + i, (self->size - i) * sizeof(*self->keys));
+  memmove(self->containers + i + 1UL, self->containers + i, (self->size - i) * sizeof(*self->containers));
+
+  self->keys[i] = key;
+  self->containers[i] = container;
+  self->size++;
+}
+
+static void bitmap_erase(bitmap_t *self, const size_t i)
+{
+  container_destroy(&self->containers[i]);
+
+  memmove(self->keys + i, self->keys + i + 1UL, (self->size - i - 1UL) * sizeof(*self->keys));
+  memmove(self->containers + i, self->containers + i + 1UL, (self->size - i - 1UL) * sizeof(*self->containers));
+
+  self->size--;
+}
+
+int bitmap_add(bitmap_t *self, const uint32_t value)
+{
+  const uint16_t key = (uint16_t)(value >> 16);
+  const size_t i = bitmap_find(self, key);
+
+  if (i == self->size || self->keys[i] != key)
+  {
+    bitmap_insert(self, i, key, container_array(4U));
+  }
+
+  container_add(&self->containers[i], (uint16_t)value);
+
+  return 0;
+}
+
+int bitmap_remove(bitmap_t *self, const uint32_t value)
+{
+  const uint16_t key = (uint16_t)(value >> 16);
+  const size_t i = bitmap_find(self, key);
+
+  if (i == self->size || self->keys[i] != key)
+  {
+    return (-1);
+  }
+
+  if (0 == container_remove(&self->containers[i], (uint16_t)value))
+  {
+    return (-1);
+  }
+
+  if (self->containers[i].cardinality == 0U)
+  {
+    bitmap_erase(self, i);
+  }
+
+  return 0;
+}
+
+int bitmap_contains(const bitmap_t *self, const uint32_t value)
+{
+  const uint16_t key = (uint16_t)(value >> 16);
+  const size_t i = bitmap_find(self, key);
+
+  if (i == self->size || self->keys[i] != key)
+  {
+    return 0;
+  }
+
+  return container_contains(&self->containers[i], (uint16_t)value);
+}
+
+uint64_t bitmap_cardinality(const bitmap_t *self)
+{
+  uint64_t cardinality = 0ULL;
+  size_t i;
+
+  for (i = 0UL; i < self->size; i++)
+  {
+    cardinality += self->containers[i].cardinality;
+  }
+
+  return cardinality;
+}
+
+static bitmap_t *bitmap_op(const bitmap_t *a, const bitmap_t *b, const int op)
+{
+  bitmap_t *self = bitmap_new();
+  container_t container;
+  size_t i = 0UL;
+  size_t j = 0UL;
+
+  while (i < a->size || j < b->size)
+  {
+    if (j == b->size || (i < a->size && a->keys[i] < b->keys[j]))
+    {
+      if (op != BITMAP_OP_AND)
+      {
+        bitmap_insert(self, self->size, a->keys[i], container_clone(&a->containers[i]));
+      }
+      i++;
+      continue;
+    }
+
+    if (i == a->size || b->keys[j] < a->keys[i])
+    {
+      if (op != BITMAP_OP_AND)
+      {
+        bitmap_insert(self, self->size, b->keys[j], container_clone(&b->containers[j]));
+      }
+      j++;
+      continue;
+    }
+
+    container = container_op(&a->containers[i], &b->containers[j], op);
+
+    if (container.cardinality > 0U)
+    {
+      bitmap_insert(self, self->size, a->keys[i], container);
+    }
+    else
+    {
+      container_destroy(&container);
+    }
+
+    i++;
+    j++;
+  }
+
+  return self;
+}
+
+bitmap_t *bitmap_and(const bitmap_t *a, const bitmap_t *b)
+{
+  return bitmap_op(a, b, BITMAP_OP_AND);
+}
+
+bitmap_t *bitmap_or(const bitmap_t *a, const bitmap_t *b)
+{
+  return bitmap_op(a, b, BITMAP_OP_OR);
+}
+
+bitmap_t *bitmap_xor(const bitmap_t *a, const bitmap_t *b)
+{
+  return bitmap_op(a, b, BITMAP_OP_XOR);
+}
+
+void bitmap_run_optimize(bitmap_t *self)
+{
+  size_t i;
+
+  for (i = 0UL; i < self->size; i++)
+  {
+    container_t *container = &self->containers[i];
+
+    if (container->type == CONTAINER_RUN)
+    {
+      continue;
+    }
+
+    const uint32_t runs = container_count_runs(container);
+
+    if (2UL * runs * sizeof(uint16_t) < container_memory(container))
+    {
+      container_to_runs(container, runs);
+    }
+  }
+}
+
+size_t bitmap_to_array(const bitmap_t *self, uint32_t *out)
+{
+  uint64_t scratch[BITMAP_WORDS];
+  size_t k = 0UL;
+  size_t i;
+  uint32_t j;
+
+  for (i = 0UL; i < self->size; i++)
+  {
+    const uint32_t high = (uint32_t)self->keys[i] << 16;
+    const container_t *container = &self->containers[i];
+
+    if (container->type == CONTAINER_ARRAY)
+    {
+      for (j = 0U; j < container->cardinality; j++)
+      {
+        out[k++] = high | container->values[j];
+      }
+
+      continue;
+    }
+
+    const uint64_t *words = container_words(container, scratch);
+
+    for (j = 0U; j < BITMAP_WORDS; j++)
+    {
+      uint64_t word = words[j];
+
+      while (word != 0ULL)
+      {
+        out[k++] = high | ((j << 6) + (uint32_t)__builtin_ctzll(word));
+        word &= word - 1ULL;
+      }
+    }
+  }
+
+  return k;
+}
+
+size_t bitmap_memory(const bitmap_t *self)
+{
+  size_t memory = sizeof(*self) + self->cap * (sizeof(*self->keys) + sizeof(*self->containers));
+  size_t i;
+
+  for (i = 0UL; i < self->size; i++)
+  {
+    memory += container_memory(&self->containers[i]);
+  }
+
+  return memory;
+}
@@ -0,0 +1,187 @@
+/*
+ * Copyright (C) 2025 Da'Jour J. Christophe. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#define _POSIX_C_SOURCE 200112L
+
+#include "internal/cpu.h"
+#include "internal/hash.h"
+#include "bloom.h"
+#include "common.h"
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(CPU_X86)
+#include <immintrin.h>
+#endif
+
+#define BLOOM_BLOCK_WORDS 8UL
+
+struct bloom
+{
+  uint32_t *blocks;
+  size_t    size;
+};
+
+static const uint32_t bloom_salt[BLOOM_BLOCK_WORDS] = {
+  0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+  0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U,
+};
+
+bloom_t *bloom_new(const size_t capacity, const double fpp)
+{
+  bloom_t *self = NULL;
+  void *blocks = NULL;
+
+  /* written so that NaN fails it as well */
+  if (!(fpp > 0.0 && fpp < 1.0))
+  {
+    return NULL;
+  }
+
+  self = (bloom_t *)calloc(1UL, sizeof(*self));
+  if (self == NULL)
+  {
+    fprintf(stderr, "%s(): %s\n", __func__, "could not allocate bloom filter to the heap");
+    exit(EXIT_FAILURE);
+  }
+
+  const double bits = -8.0 * (double)capacity / log(1.0 - pow(fpp, 1.0 / 8.0));
+
+  self->size = (size_t)(bits / 256.0) + 1UL;
+
+  if (0 != posix_memalign(&blocks, 64UL, self->size * BLOOM_BLOCK_WORDS * sizeof(uint32_t)))
+  {
+    fprintf(stderr, "%s(): %s\n", __func__, "could not allocate bloom.blocks to the heap");
+    exit(EXIT_FAILURE);
+  }
+
+  self->blocks = (uint32_t *)blocks;
+  bloom_clear(self);
+
+  return self;
+}
+
+void bloom_destroy(bloom_t *self)
+{
+  if (self != NULL)
+  {
+    if (self->blocks != NULL)
+    {
+      free(self->blocks);
+      self->blocks = NULL;
+    }
+
+    free(self);
+    self = NULL;
+  }
+}
+
+void bloom_clear(bloom_t *self)
+{
+  memset(self->blocks, 0, self->size * BLOOM_BLOCK_WORDS * sizeof(uint32_t));
+}
+
+static inline uint32_t always_inline *bloom_block(const bloom_t *self, const uint64_t hash)
+{
+  const uint64_t index = ((hash >> 32) * (uint64_t)self->size) >> 32;
+
+  return self->blocks + index * BLOOM_BLOCK_WORDS;
+}
+
+#if defined(CPU_X86)
+static inline cpu_target("avx2") __m256i bloom_mask_avx2(const uint64_t hash)
+{
+  const __m256i salt = _mm256_loadu_si256((const __m256i *)bloom_salt);
+  const __m256i bits = _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_set1_epi32((int)(uint32_t)hash), salt), 27);
+
+  return _mm256_sllv_epi32(_mm256_set1_epi32(1), bits);
+}
+
+static cpu_target("avx2") void bloom_add_avx2(uint32_t *block, const uint64_t hash)
+{
+  const __m256i words = _mm256_load_si256((const __m256i *)block);
+
+  _mm256_store_si256((__m256i *)block, _mm256_or_si256(words, bloom_mask_avx2(hash)));
+}
+
+static cpu_target("avx2") int bloom_contains_avx2(const uint32_t *block, const uint64_t hash)
+{
+  const __m256i words = _mm256_load_si256((const __m256i *)block);
+
+  return _mm256_testc_si256(words, bloom_mask_avx2(hash));
+}
+#endif
+
+void bloom_add_hash(bloom_t *self, const uint64_t hash)
+{
+  uint32_t *block = bloom_block(self, hash);
+  size_t i;
+
+#if defined(CPU_X86)
+  if (cpu_has(CPU_AVX2))
+  {
+    bloom_add_avx2(block, hash);
+    return;
+  }
+#endif
+
+  for (i = 0UL; i < BLOOM_BLOCK_WORDS; i++)
+  {
+    block[i] |= 1U << (((uint32_t)hash * bloom_salt[i]) >> 27);
+  }
+}
+
+int bloom_contains_hash(const bloom_t *self, const uint64_t hash)
+{
+  const uint32_t *block = bloom_block(self, hash);
+  uint32_t missing = 0U;
+  size_t i;
+
+#if defined(CPU_X86)
+  if (cpu_has(CPU_AVX2))
+  {
+    return bloom_contains_avx2(block, hash);
+  }
+#endif
+
+  for (i = 0UL; i < BLOOM_BLOCK_WORDS; i++)
+  {
+    missing |= ~block[i] & (1U << (((uint32_t)hash * bloom_salt[i]) >> 27));
+  }
+
+  return missing == 0U;
+}
+
+#define SEED 2
+
+void bloom_add(bloom_t *self, const void *key, const size_t keylen)
+{
+  bloom_add_hash(self, __hash__(key, keylen, SEED));
+}
+
+int bloom_contains(const bloom_t *self, const void *key, const size_t keylen)
+{
+  return bloom_contains_hash(self, __hash__(key, keylen, SEED));
+}
+
+size_t bloom_memory(const bloom_t *self)
+{
+  return sizeof(*self) + self->size * BLOOM_BLOCK_WORDS * sizeof(uint32_t);
+}
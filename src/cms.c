@@ -0,0 +1,193 @@
+/*
+ * Copyright (C) 2025 Da'Jour J. Christophe. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "internal/hash.h"
+#include "cms.h"
+#include "common.h"
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct cms
+{
+  uint32_t *counters;
+  size_t    width;
+  size_t    depth;
+  uint64_t  total;
+};
+
+cms_t *cms_new(const size_t width, const size_t depth)
+{
+  cms_t *self = NULL;
+
+  if (width == 0UL || depth == 0UL || depth > CMS_MAX_DEPTH)
+  {
+    return NULL;
+  }
+
+  self = (cms_t *)calloc(1UL, sizeof(*self));
+  if (self == NULL)
+  {
+    fprintf(stderr, "%s(): %s\n", __func__, "could not allocate count-min sketch to the heap");
+    exit(EXIT_FAILURE);
+  }
+
+  self->width = 1UL;
+  while (self->width < width)
+  {
+    self->width <<= 1;
+  }
+
+  self->depth = depth;
+
+  self->counters = (uint32_t *)calloc(self->width * self->depth, sizeof(*self->counters));
+  if (self->counters == NULL)
+  {
+    fprintf(stderr, "%s(): %s\n", __func__, "could not allocate count-min sketch.counters to the heap");
+    exit(EXIT_FAILURE);
+  }
+
+  return self;
+}
+
+cms_t *cms_new_with_error(const double epsilon, const double delta)
+{
+  if (epsilon <= 0.0 || delta <= 0.0 || delta >= 1.0)
+  {
+    return NULL;
+  }
+
+  return cms_new((size_t)ceil(exp(1.0) / epsilon), (size_t)ceil(log(1.0 / delta)));
+}
+
+void cms_destroy(cms_t *self)
+{
+  if (self != NULL)
+  {
+    if (self->counters != NULL)
+    {
+      free(self->counters);
+      self->counters = NULL;
+    }
+
+    free(self);
+    self = NULL;
+  }
+}
+
+/*
+ * Row i uses h1 + i * h2 (Kirsch-Mitzenmacher), so one 64-bit hash
+ * yields every row's column without rehashing the key.
+ */
+static inline void always_inline cms_indexes(const cms_t *self, const uint64_t hash, size_t *index)
+{
+  const uint32_t h1 = (uint32_t)hash;
+  const uint32_t h2 = (uint32_t)(hash >> 32) | 1U;
+  size_t i;
+
+  for (i = 0UL; i < self->depth; i++)
+  {
+    index[i] = i * self->width + ((h1 + (uint32_t)i * h2) & (self->width - 1UL));
+  }
+}
+
+uint32_t cms_add_hash(cms_t *self, const uint64_t hash, const uint32_t count)
+{
+  size_t index[CMS_MAX_DEPTH];
+  uint32_t minimum = UINT32_MAX;
+  size_t i;
+
+  cms_indexes(self, hash, index);
+
+  for (i = 0UL; i < self->depth; i++)
+  {
+    minimum = self->counters[index[i]] < minimum ? self->counters[index[i]] : minimum;
+  }
+
+  const uint32_t target = minimum > UINT32_MAX - count ? UINT32_MAX : minimum + count;
+
+  for (i = 0UL; i < self->depth; i++)
+  {
+    self->counters[index[i]] = self->counters[index[i]] < target ? target : self->counters[index[i]];
+  }
+
+  self->total += count;
+
+  return target;
+}
+
+uint32_t cms_estimate_hash(const cms_t *self, const uint64_t hash)
+{
+  size_t index[CMS_MAX_DEPTH];
+  uint32_t minimum = UINT32_MAX;
+  size_t i;
+
+  cms_indexes(self, hash, index);
+
+  for (i = 0UL; i < self->depth; i++)
+  {
+    minimum = self->counters[index[i]] < minimum ? self->counters[index[i]] : minimum;
+  }
+
+  return minimum;
+}
+
+#define SEED 2
+
+uint32_t cms_add(cms_t *self, const void *key, const size_t keylen, const uint32_t count)
+{
+  return cms_add_hash(self, __hash__(key, keylen, SEED), count);
+}
+
+uint32_t cms_estimate(const cms_t *self, const void *key, const size_t keylen)
+{
+  return cms_estimate_hash(self, __hash__(key, keylen, SEED));
+}
+
+uint64_t cms_total(const cms_t *self)
+{
+  return self->total;
+}
+
+int cms_merge(cms_t *self, const cms_t *other)
+{
+  const size_t size = self->width * self->depth;
+  size_t i;
+
+  if (self->width != other->width || self->depth != other->depth)
+  {
+    return (-1);
+  }
+
+  for (i = 0UL; i < size; i++)
+  {
+    const uint64_t sum = (uint64_t)self->counters[i] + other->counters[i];
+
+    self->counters[i] = sum > UINT32_MAX ? UINT32_MAX : (uint32_t)sum;
+  }
+
+  self->total += other->total;
+
+  return 0;
+}
+
+size_t cms_memory(const cms_t *self)
+{
+  return sizeof(*self) + self->width * self->depth * sizeof(*self->counters);
+}
@@ -0,0 +1,319 @@
+/*
+ * Copyright (C) 2025 Da'Jour J. Christophe. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "internal/hash.h"
+#include "common.h"
+#include "cuckoo.h"
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CUCKOO_SLOTS     4U
+#define CUCKOO_MAX_KICKS 500U
+
+/*
+ * A bucket is CUCKOO_SLOTS fingerprints of bits each, stored in
+ * stride = 4 * bits / 8 bytes. Buckets are read through a 64-bit word,
+ * so the table carries 8 bytes of tail padding. A zero fingerprint
+ * marks an empty slot.
+ */
+struct cuckoo
+{
+  uint8_t  *table;
+  size_t    size;
+  size_t    count;
+  uint32_t  bits;
+  uint32_t  stride;
+  uint64_t  rng;
+  int       has_victim;
+  size_t    victim_index;
+  uint32_t  victim_fingerprint;
+};
+
+cuckoo_t *cuckoo_new(const size_t capacity, const unsigned int fingerprint_bits)
+{
+  cuckoo_t *self = NULL;
+
+  if (fingerprint_bits != 8U && fingerprint_bits != 12U && fingerprint_bits != 16U)
+  {
+    return NULL;
+  }
+
+  self = (cuckoo_t *)calloc(1UL, sizeof(*self));
+  if (self == NULL)
+  {
+    fprintf(stderr, "%s(): %s\n", __func__, "could not allocate cuckoo filter to the heap");
+    exit(EXIT_FAILURE);
+  }
+
+  self->size = 1UL;
+  while ((double)(self->size * CUCKOO_SLOTS) * 0.95 < (double)capacity)
+  {
+    self->size <<= 1;
+  }
+
+  self->bits = fingerprint_bits;
+  self->stride = (CUCKOO_SLOTS * fingerprint_bits) / 8U;
+  self->rng = 0x9E3779B97F4A7C15ULL;
+
+  self->table = (uint8_t *)calloc(self->size * self->stride + sizeof(uint64_t), sizeof(*self->table));
+  if (self->table == NULL)
+  {
+    fprintf(stderr, "%s(): %s\n", __func__, "could not allocate cuckoo.table to the heap");
+    exit(EXIT_FAILURE);
+  }
+
+  return self;
+}
+
+void cuckoo_destroy(cuckoo_t *self)
+{
+  if (self != NULL)
+  {
+    if (self->table != NULL)
+    {
+      free(self->table);
+      self->table = NULL;
+    }
+
+    free(self);
+    self = NULL;
+  }
+}
+
+static inline uint64_t always_inline cuckoo_bucket_read(const cuckoo_t *self, const size_t index)
+{
+  uint64_t word;
+
+  memcpy(&word, self->table + index * self->stride, sizeof(word));
+
+  return self->bits == 16U ? word : word & ((1ULL << (CUCKOO_SLOTS * self->bits)) - 1ULL);
+}
+
+static inline void always_inline cuckoo_bucket_write(cuckoo_t *self, const size_t index, const uint64_t word)
+{
+  memcpy(self->table + index * self->stride, &word, self->stride);
+}
+
+static inline uint32_t always_inline cuckoo_slot(const cuckoo_t *self, const uint64_t word, const uint32_t slot)
+{
+  return (uint32_t)(word >> (slot * self->bits)) & ((1U << self->bits) - 1U);
+}
+
+static inline uint64_t always_inline cuckoo_slot_set(const cuckoo_t *self, const uint64_t word,
+                                                     const uint32_t slot, const uint32_t fingerprint)
+{
+  const uint64_t mask = (uint64_t)((1U << self->bits) - 1U) << (slot * self->bits);
+
+  return (word & ~mask) | ((uint64_t)fingerprint << (slot * self->bits));
+}
+
+#define SEED 2
+
+static inline size_t always_inline cuckoo_alt_index(const cuckoo_t *self, const size_t index, const uint32_t fingerprint)
+{
+  const uint16_t value = (uint16_t)fingerprint;
+
+  return (index ^ (size_t)__hash__(&value, sizeof(value), SEED)) & (self->size - 1UL);
+}
+
+static inline void always_inline cuckoo_locate(const cuckoo_t *self, const void *key, const size_t keylen,
+                                               size_t *index, uint32_t *fingerprint)
+{
+  const uint64_t hash = __hash__(key, keylen, SEED);
+
+  *index = (size_t)hash & (self->size - 1UL);
+  *fingerprint = (uint32_t)(hash >> 32) & ((1U << self->bits) - 1U);
+  *fingerprint += (*fingerprint == 0U);
+}
+
+static int cuckoo_bucket_find(const cuckoo_t *self, const size_t index, const uint32_t fingerprint)
+{
+  const uint64_t word = cuckoo_bucket_read(self, index);
+  uint32_t slot;
+
+  for (slot = 0U; slot < CUCKOO_SLOTS; slot++)
+  {
+    if (cuckoo_slot(self, word, slot) == fingerprint)
+    {
+      return (int)slot;
+    }
+  }
+
+  return (-1);
+}
+
+static int cuckoo_bucket_insert(cuckoo_t *self, const size_t index, const uint32_t fingerprint)
+{
+  const int slot = cuckoo_bucket_find(self, index, 0U);
+
+  if (slot < 0)
+  {
+    return (-1);
+  }
+
+  cuckoo_bucket_write(self, index, cuckoo_slot_set(self, cuckoo_bucket_read(self, index), (uint32_t)slot, fingerprint));
+
+  return 0;
+}
+
+int cuckoo_add(cuckoo_t *self, const void *key, const size_t keylen)
+{
+  size_t index;
+  uint32_t fingerprint;
+  uint32_t kick;
+
+  if (self->has_victim)
+  {
+    return (-1);
+  }
+
+  cuckoo_locate(self, key, keylen, &index, &fingerprint);
+
+  if (0 == cuckoo_bucket_insert(self, index, fingerprint))
+  {
+    self->count++;
+    return 0;
+  }
+
+  index = cuckoo_alt_index(self, index, fingerprint);
+
+  for (kick = 0U; kick < CUCKOO_MAX_KICKS; kick++)
+  {
+    if (0 == cuckoo_bucket_insert(self, index, fingerprint))
+    {
+      self->count++;
+      return 0;
+    }
+
+    self->rng ^= self->rng << 13;
+    self->rng ^= self->rng >> 7;
+    self->rng ^= self->rng << 17;
+
+    const uint32_t slot = (uint32_t)(self->rng % CUCKOO_SLOTS);
+    const uint64_t word = cuckoo_bucket_read(self, index);
+    const uint32_t evicted = cuckoo_slot(self, word, slot);
+
+    cuckoo_bucket_write(self, index, cuckoo_slot_set(self, word, slot, fingerprint));
+
+    fingerprint = evicted;
+    index = cuckoo_alt_index(self, index, fingerprint);
+  }
+
+  /*
+   * The table is effectively full. Park the homeless fingerprint so no
+   * key that was already added starts reporting false negatives.
+   */
+  self->has_victim = 1;
+  self->victim_index = index;
+  self->victim_fingerprint = fingerprint;
+  self->count++;
+
+  return 0;
+}
+
+int cuckoo_contains(const cuckoo_t *self, const void *key, const size_t keylen)
+{
+  size_t index;
+  uint32_t fingerprint;
+
+  cuckoo_locate(self, key, keylen, &index, &fingerprint);
+
+  const size_t alt = cuckoo_alt_index(self, index, fingerprint);
+
+  if (self->has_victim && self->victim_fingerprint == fingerprint &&
+      (self->victim_index == index || self->victim_index == alt))
+  {
+    return 1;
+  }
+
+  return cuckoo_bucket_find(self, index, fingerprint) >= 0 || cuckoo_bucket_find(self, alt, fingerprint) >= 0;
+}
+
+int cuckoo_remove(cuckoo_t *self, const void *key, const size_t keylen)
+{
+  size_t index;
+  uint32_t fingerprint;
+  int slot;
+
+  cuckoo_locate(self, key, keylen, &index, &fingerprint);
+
+  const size_t alt = cuckoo_alt_index(self, index, fingerprint);
+
+  if (self->has_victim && self->victim_fingerprint == fingerprint &&
+      (self->victim_index == index || self->victim_index == alt))
+  {
+    self->has_victim = 0;
+    self->count--;
+    return 0;
+  }
+
+  if ((slot = cuckoo_bucket_find(self, index, fingerprint)) < 0)
+  {
+    index = alt;
+
+    if ((slot = cuckoo_bucket_find(self, index, fingerprint)) < 0)
+    {
+      return (-1);
+    }
+  }
+
+  cuckoo_bucket_write(self, index, cuckoo_slot_set(self, cuckoo_bucket_read(self, index), (uint32_t)slot, 0U));
+  self->count--;
+
+  if (self->has_victim)
+  {
+    const size_t victim = self->victim_index;
+    const uint32_t victim_fingerprint = self->victim_fingerprint;
+
+    self->has_victim = 0;
+
+    if (0 == cuckoo_bucket_insert(self, victim, victim_fingerprint) ||
+        0 == cuckoo_bucket_insert(self, cuckoo_alt_index(self, victim, victim_fingerprint), victim_fingerprint))
+    {
+      return 0;
+    }
+
+    self->has_victim = 1;
+  }
+
+  return 0;
+}
+
+size_t cuckoo_count(const cuckoo_t *self)
+{
+  return self->count;
+}
+
+/*
+ * A negative lookup compares one fingerprint against the occupied slots
+ * of two buckets, each matching with probability 1 / (2^bits - 1).
+ */
+double cuckoo_false_positive_rate(const cuckoo_t *self)
+{
+  const double load = (double)self->count / (double)(self->size * CUCKOO_SLOTS);
+  const double match = 1.0 / (double)((1U << self->bits) - 1U);
+
+  return 1.0 - pow(1.0 - match, 2.0 * CUCKOO_SLOTS * load);
+}
+
+size_t cuckoo_memory(const cuckoo_t *self)
+{
+  return sizeof(*self) + self->size * self->stride + sizeof(uint64_t);
+}
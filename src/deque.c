@@ -13,23 +13,62 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#define _GNU_SOURCE
+
 #include "common.h"
 #include "deque.h"
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include <errno.h>
+#include <sched.h>
+#include <sys/uio.h>
+#include <time.h>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <linux/membarrier.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#if defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#define RING_BUFFER_URING 1
+#endif
+#endif
+#endif
+
+#define CACHE_LINE 64UL
+
+/*
+ * Single-producer/single-consumer byte ring. Cursors only grow and are
+ * masked on access. Each side owns a cache line: head is its own cursor,
+ * published with release stores, and tail is its cached view of how far
+ * the other side lets it go (reader.head + cap for the writer, writer.head
+ * for the reader). The other side's line is only read, with an acquire
+ * load, when the cached limit runs out. waiting is set by the other side
+ * before it sleeps, so each side only checks its own line to know whether
+ * a publish has to wake anyone.
+ */
 struct ring_buffer_writer {
   uint64_t head;
   uint64_t tail;
-};
+  uint32_t waiting;
+} __attribute__ ((aligned(CACHE_LINE)));
 
 uint64_t ring_buffer_writer_get_head(const ring_buffer_writer_t *self)
 {
-  return self->head;
+  return __atomic_load_n(&self->head, __ATOMIC_ACQUIRE);
 }
 
 uint64_t ring_buffer_writer_get_tail(const ring_buffer_writer_t *self)
@@ -40,11 +79,12 @@ uint64_t ring_buffer_writer_get_tail(const ring_buffer_writer_t *self)
 struct ring_buffer_reader {
   uint64_t head;
   uint64_t tail;
-};
+  uint32_t waiting;
+} __attribute__ ((aligned(CACHE_LINE)));
 
 uint64_t ring_buffer_reader_get_head(const ring_buffer_reader_t *self)
 {
-  return self->head;
+  return __atomic_load_n(&self->head, __ATOMIC_ACQUIRE);
 }
 
 uint64_t ring_buffer_reader_get_tail(const ring_buffer_reader_t *self)
@@ -52,155 +92,1994 @@ uint64_t ring_buffer_reader_get_tail(const ring_buffer_reader_t *self)
   return self->tail;
 }
 
+/*
+ * span is how many bytes can be addressed from the data onwards: cap for
+ * a plain ring, 2 * cap for a mirrored one, whose second half maps the
+ * same pages as the first so that no record ever has to wrap. min_cap is
+ * zero for a fixed ring; a growable one keeps its data on the heap and
+ * never shrinks below it. The data is found at offset bytes from the
+ * header rather than through a pointer, and magic is only set on a ring
+ * in a shared mapping, so the same header works at whatever address each
+ * process maps it.
+ */
 struct ring_buffer
 {
+  uint64_t magic;
   size_t cap;
+  size_t span;
+  size_t min_cap;
+  uintptr_t offset;
+  int fd;
   ring_buffer_writer_t writer;
   ring_buffer_reader_t reader;
-  uint8_t data[];
+  uint8_t storage[] __attribute__ ((aligned(CACHE_LINE)));
 };
 
+#define RING_BUFFER_MAGIC 0x72696e6762756631UL
+
+static inline uint8_t *always_inline ring_buffer_data(const ring_buffer_t *self)
+{
+  return (uint8_t *)((uintptr_t)self + self->offset);
+}
+
+static inline void always_inline ring_buffer_set_data(ring_buffer_t *self, const uint8_t *data)
+{
+  self->offset = (uintptr_t)data - (uintptr_t)self;
+}
+
+/* shared by every queue here: capacities are powers of two */
+static inline uint64_t always_inline ring_buffer_mask(const size_t cap, const uint64_t index)
+{
+  return index & (cap - 1UL);
+}
+
+static inline size_t always_inline ring_buffer_round_cap(const size_t cap)
+{
+  size_t size = 1UL;
+
+  while (size < cap)
+  {
+    size <<= 1;
+  }
+
+  return size;
+}
+
+/* capacities are rounded up to a power of two so cursors can be masked */
 ring_buffer_t *ring_buffer_create(const size_t cap)
 {
-  const size_t memory = offsetof(ring_buffer_t, data[cap]);
+  const size_t size = ring_buffer_round_cap(cap);
   ring_buffer_t *self = NULL;
 
-  self = (ring_buffer_t *)calloc(memory, sizeof(uint8_t));
-  if (self == NULL)
+  if (0 != posix_memalign((void **)&self, CACHE_LINE, offsetof(ring_buffer_t, storage) + size))
   {
     fprintf(stderr, "%s(): %s\n", __func__, "Could not allocate ring buffer to the heap");
     exit(EXIT_FAILURE);
   }
 
-  self->cap = cap;
-  self->writer.tail = cap;
+  memset(self, 0, offsetof(ring_buffer_t, storage) + size);
+
+  self->cap = size;
+  self->span = size;
+  self->offset = offsetof(ring_buffer_t, storage);
+  self->writer.tail = size;
+  self->fd = -1;
+
+  return self;
+}
+
+/*
+ * Maps one memfd twice, back to back, inside a reservation of twice the
+ * capacity. The capacity is also rounded up to whole pages.
+ */
+ring_buffer_t *ring_buffer_create_mirrored(const size_t cap)
+{
+#if defined(__linux__)
+  const long page = sysconf(_SC_PAGESIZE);
+  const size_t size = ring_buffer_round_cap(cap < (size_t)page ? (size_t)page : cap);
+  ring_buffer_t *self = NULL;
+  uint8_t *data = NULL;
+  int fd;
+
+  fd = memfd_create("ring_buffer", MFD_CLOEXEC);
+  if (fd < 0)
+  {
+    return NULL;
+  }
+
+  if (0 != ftruncate(fd, (off_t)size))
+  {
+    close(fd);
+    return NULL;
+  }
+
+  data = mmap(NULL, 2UL * size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (data == MAP_FAILED)
+  {
+    close(fd);
+    return NULL;
+  }
+
+  if (MAP_FAILED == mmap(data, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) ||
+      MAP_FAILED == mmap(data + size, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0))
+  {
+    munmap(data, 2UL * size);
+    close(fd);
+    return NULL;
+  }
+
+  close(fd);
+
+  if (0 != posix_memalign((void **)&self, CACHE_LINE, sizeof(*self)))
+  {
+    fprintf(stderr, "%s(): %s\n", __func__, "Could not allocate ring buffer to the heap");
+    exit(EXIT_FAILURE);
+  }
+
+  memset(self, 0, sizeof(*self));
+
+  self->cap = size;
+  self->span = 2UL * size;
+  ring_buffer_set_data(self, data);
+  self->writer.tail = size;
+  self->fd = -1;
+
+  return self;
+#else
+  UNUSED(cap);
+
+  return NULL;
+#endif
+}
+
+/*
+ * A growable ring doubles when a record does not fit and halves once it
+ * is no more than an eighth full, so a resize leaves it a quarter full
+ * and needs a fourfold swing in occupancy before the next one.
+ */
+ring_buffer_t *ring_buffer_create_growable(const size_t cap)
+{
+  const size_t size = ring_buffer_round_cap(cap < CACHE_LINE ? CACHE_LINE : cap);
+  ring_buffer_t *self = NULL;
+  uint8_t *data = NULL;
+
+  if (0 != posix_memalign((void **)&self, CACHE_LINE, sizeof(*self)))
+  {
+    fprintf(stderr, "%s(): %s\n", __func__, "Could not allocate ring buffer to the heap");
+    exit(EXIT_FAILURE);
+  }
+
+  memset(self, 0, sizeof(*self));
+
+  if (0 != posix_memalign((void **)&data, CACHE_LINE, size))
+  {
+    fprintf(stderr, "%s(): %s\n", __func__, "Could not allocate ring buffer data to the heap");
+    exit(EXIT_FAILURE);
+  }
+
+  ring_buffer_set_data(self, data);
+  self->cap = size;
+  self->span = size;
+  self->min_cap = size;
+  self->writer.tail = size;
+  self->fd = -1;
+
+  return self;
+}
+
+/*
+ * A shared ring is a plain ring laid out in a mapping of a file: the
+ * header followed by the data. The creator sizes and initialises it and
+ * stores the magic last, so an attacher never sees a half-built header.
+ */
+ring_buffer_t *ring_buffer_create_fd(const int fd, const size_t cap)
+{
+#if defined(__linux__)
+  const size_t size = ring_buffer_round_cap(cap < CACHE_LINE ? CACHE_LINE : cap);
+  ring_buffer_t *self = NULL;
+
+  if (0 != ftruncate(fd, (off_t)(offsetof(ring_buffer_t, storage) + size)))
+  {
+    return NULL;
+  }
+
+  self = mmap(NULL, offsetof(ring_buffer_t, storage) + size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (self == MAP_FAILED)
+  {
+    return NULL;
+  }
+
+  memset(self, 0, offsetof(ring_buffer_t, storage));
+
+  self->cap = size;
+  self->span = size;
+  self->offset = offsetof(ring_buffer_t, storage);
+  self->writer.tail = size;
+  self->fd = -1;
+
+  __atomic_store_n(&self->magic, RING_BUFFER_MAGIC, __ATOMIC_RELEASE);
+
+  return self;
+#else
+  UNUSED(fd);
+  UNUSED(cap);
+
+  return NULL;
+#endif
+}
+
+ring_buffer_t *ring_buffer_attach_fd(const int fd)
+{
+#if defined(__linux__)
+  ring_buffer_t *self = NULL;
+  struct stat st;
+
+  if (0 != fstat(fd, &st) || (size_t)st.st_size < offsetof(ring_buffer_t, storage))
+  {
+    return NULL;
+  }
+
+  self = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (self == MAP_FAILED)
+  {
+    return NULL;
+  }
+
+  if (RING_BUFFER_MAGIC != __atomic_load_n(&self->magic, __ATOMIC_ACQUIRE) ||
+      self->cap == 0UL || 0UL != (self->cap & (self->cap - 1UL)) || self->span != self->cap ||
+      self->offset != offsetof(ring_buffer_t, storage) ||
+      (size_t)st.st_size != offsetof(ring_buffer_t, storage) + self->cap)
+  {
+    munmap(self, (size_t)st.st_size);
+    return NULL;
+  }
+
+  return self;
+#else
+  UNUSED(fd);
+
+  return NULL;
+#endif
+}
+
+ring_buffer_t *ring_buffer_create_shared(const char *name, const size_t cap)
+{
+#if defined(__linux__)
+  ring_buffer_t *self = NULL;
+  int fd;
+
+  fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+  if (fd < 0)
+  {
+    return NULL;
+  }
+
+  self = ring_buffer_create_fd(fd, cap);
+  if (self == NULL)
+  {
+    shm_unlink(name);
+  }
+
+  close(fd);
+
+  return self;
+#else
+  UNUSED(name);
+  UNUSED(cap);
+
+  return NULL;
+#endif
+}
+
+ring_buffer_t *ring_buffer_attach_shared(const char *name)
+{
+#if defined(__linux__)
+  ring_buffer_t *self = NULL;
+  int fd;
+
+  fd = shm_open(name, O_RDWR, 0);
+  if (fd < 0)
+  {
+    return NULL;
+  }
+
+  self = ring_buffer_attach_fd(fd);
+  close(fd);
 
   return self;
+#else
+  UNUSED(name);
+
+  return NULL;
+#endif
 }
 
 void ring_buffer_destroy(ring_buffer_t *self)
 {
   if (self != NULL)
   {
+#if defined(__linux__)
+    if (self->magic == RING_BUFFER_MAGIC)
+    {
+      munmap(self, offsetof(ring_buffer_t, storage) + self->cap);
+      return;
+    }
+#endif
+
+    if (self->min_cap != 0UL)
+    {
+      free(ring_buffer_data(self));
+    }
+
+#if defined(__linux__)
+    if (self->fd >= 0)
+    {
+      close(self->fd);
+    }
+#endif
+
+#if defined(__linux__)
+    if (self->span > self->cap)
+    {
+      munmap(ring_buffer_data(self), self->span);
+    }
+#endif
+
     free(self);
     self = NULL;
   }
 }
 
-static inline uint64_t always_inline ring_buffer_mask(ring_buffer_t *self, const uint64_t index)
+/* copies in or out of the ring at a cursor, in two pieces when it wraps */
+static inline void always_inline ring_buffer_write(ring_buffer_t *self, const uint64_t at, const void *data, const size_t size)
 {
-  return index & (self->cap - 1UL);
+  const uint64_t offset = ring_buffer_mask(self->cap, at);
+  const size_t first = size < self->span - offset ? size : self->span - offset;
+  uint8_t *buffer = ring_buffer_data(self);
+
+  memcpy(buffer + offset, data, first);
+  memcpy(buffer, (const uint8_t *)data + first, size - first);
 }
 
-static inline uint64_t always_inline ring_buffer_reader_capacity(ring_buffer_t *self)
+static inline void always_inline ring_buffer_read(const ring_buffer_t *self, const uint64_t at, void *data, const size_t size)
 {
-  return self->reader.tail - self->reader.head;
+  const uint64_t offset = ring_buffer_mask(self->cap, at);
+  const size_t first = size < self->span - offset ? size : self->span - offset;
+  const uint8_t *buffer = ring_buffer_data(self);
+
+  memcpy(data, buffer + offset, first);
+  memcpy((uint8_t *)data + first, buffer, size - first);
 }
 
-static inline uint64_t always_inline ring_buffer_writer_capacity(ring_buffer_t *self)
+/* unrolls the live bytes to the start of a new buffer and rebases the cursors */
+static void ring_buffer_resize(ring_buffer_t *self, const size_t cap)
 {
-  return self->writer.tail - self->writer.head;
+  const size_t used = self->writer.head - self->reader.head;
+  uint8_t *data = NULL;
+
+  if (0 != posix_memalign((void **)&data, CACHE_LINE, cap))
+  {
+    fprintf(stderr, "%s(): %s\n", __func__, "Could not allocate ring buffer data to the heap");
+    exit(EXIT_FAILURE);
+  }
+
+  ring_buffer_read(self, self->reader.head, data, used);
+  free(ring_buffer_data(self));
+
+  ring_buffer_set_data(self, data);
+  self->cap = cap;
+  self->span = cap;
+  self->reader.head = 0UL;
+  self->reader.tail = used;
+  self->writer.head = used;
+  self->writer.tail = cap;
 }
 
-static inline void always_inline ring_buffer_try_resize(ring_buffer_t *self)
+static int ring_buffer_grow(ring_buffer_t *self, const size_t size)
 {
-  if (self->writer.head == self->writer.tail)
+  const size_t used = self->writer.head - self->reader.head;
+  size_t cap = self->cap;
+
+  if (self->min_cap == 0UL)
+  {
+    return 0;
+  }
+
+  while (cap - used < size)
   {
-    self->writer.tail = self->reader.head;
+    cap <<= 1;
   }
+
+  ring_buffer_resize(self, cap);
+
+  return 1;
 }
 
-static inline void always_inline ring_buffer_increment(ring_buffer_t *self, const size_t size)
+static inline void always_inline ring_buffer_shrink(ring_buffer_t *self)
 {
-  self->writer.head += size;
-  self->reader.tail += size;
+  if (self->min_cap != 0UL && self->cap > self->min_cap &&
+      self->writer.head - self->reader.head <= self->cap / 8UL)
+  {
+    ring_buffer_resize(self, self->cap / 2UL);
+  }
 }
 
-static inline void always_inline ring_buffer_try_reset(ring_buffer_t *self)
+/* refresh the cached limit from the other side's cursor only when it runs out */
+static inline int always_inline ring_buffer_writable(ring_buffer_t *self, const size_t size)
 {
-  if (self->reader.head == self->reader.tail)
+  if (size > self->writer.tail - self->writer.head)
   {
-    self->reader.head = self->writer.head;
-    self->reader.tail = self->reader.head;
+    self->writer.tail = __atomic_load_n(&self->reader.head, __ATOMIC_ACQUIRE) + self->cap;
   }
+
+  return size <= self->writer.tail - self->writer.head;
 }
 
-static inline void always_inline ring_buffer_decrement(ring_buffer_t *self, const size_t size)
+static inline int always_inline ring_buffer_readable(ring_buffer_t *self, const size_t size)
 {
-  self->reader.head += size;
+  if (size > self->reader.tail - self->reader.head)
+  {
+    self->reader.tail = __atomic_load_n(&self->writer.head, __ATOMIC_ACQUIRE);
+  }
+
+  return size <= self->reader.tail - self->reader.head;
 }
 
-int ring_buffer_enqueue(ring_buffer_t *self, const void *data, size_t size)
+/*
+ * Blocking waits. A side about to sleep sets the waiting flag on the other
+ * side's line, then rechecks and sleeps on the flag with a futex; a publish
+ * wakes it only if the flag is set. The recheck must not be ordered before
+ * the flag store, nor the flag load before the publish: the sleeper pays
+ * for both with an expedited membarrier, which runs a full barrier on every
+ * thread of the process, so a publish needs only a compiler barrier. Where
+ * membarrier is missing, or the other side may be another process sharing
+ * the ring, sleeps are cut into slices of RING_BUFFER_SLICE nanoseconds,
+ * which bounds the delay of a missed wake.
+ */
+#define RING_BUFFER_SPIN  256U
+#define RING_BUFFER_SLICE 1000000L
+
+static int ring_buffer_membarrier = 0;
+
+static int ring_buffer_barrier(void)
 {
-  if (size > ring_buffer_writer_capacity(self))
+  int state = __atomic_load_n(&ring_buffer_membarrier, __ATOMIC_RELAXED);
+
+#if defined(__linux__)
+  if (state == 0)
   {
-    return (-1);
+    const long cmds = syscall(SYS_membarrier, MEMBARRIER_CMD_QUERY, 0, 0);
+
+    state = -1;
+
+    if (cmds > 0 && (cmds & MEMBARRIER_CMD_PRIVATE_EXPEDITED) &&
+        0 == syscall(SYS_membarrier, MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0, 0))
+    {
+      state = 1;
+    }
+
+    __atomic_store_n(&ring_buffer_membarrier, state, __ATOMIC_RELAXED);
+  }
+
+  if (state > 0 && 0 == syscall(SYS_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0, 0))
+  {
+    return 1;
+  }
+#endif
+
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+  return 0;
+}
+
+static inline void always_inline ring_buffer_pause(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#endif
+}
+
+static void ring_buffer_wake(uint32_t *waiting, const int fd)
+{
+  if (0U == __atomic_exchange_n(waiting, 0U, __ATOMIC_RELAXED))
+  {
+    return;
   }
 
-  if (size > (self->writer.head % self->cap))
+#if defined(__linux__)
+  const uint64_t one = 1UL;
+
+  syscall(SYS_futex, waiting, FUTEX_WAKE, 1, NULL, NULL, 0);
+
+  if (fd >= 0 && 0 > write(fd, &one, sizeof(one)))
   {
-    self->writer.head = 0UL;
+    return;
   }
+#else
+  UNUSED(fd);
+#endif
+}
 
-  if (size > ring_buffer_writer_capacity(self))
+/* sleeps while *waiting is still set, until woken or the deadline; -1 once it has passed */
+static int ring_buffer_sleep(uint32_t *waiting, const struct timespec *deadline, const int exact)
+{
+  struct timespec now;
+  long slice = exact ? -1L : RING_BUFFER_SLICE;
+
+  if (deadline != NULL)
   {
-    return (-1);
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    const long left = (long)(deadline->tv_sec - now.tv_sec) * 1000000000L + (deadline->tv_nsec - now.tv_nsec);
+
+    if (left <= 0L)
+    {
+      return (-1);
+    }
+
+    slice = slice < 0L || left < slice ? left : slice;
   }
 
-  const void *pointer = self->data + ring_buffer_mask(self, self->writer.head);
-  memcpy((void *)pointer, data, size);
+#if defined(__linux__)
+  struct timespec timeout = { slice / 1000000000L, slice % 1000000000L };
 
-  ring_buffer_increment(self, size);
-  ring_buffer_try_resize(self);
+  syscall(SYS_futex, waiting, FUTEX_WAIT, 1U, slice < 0L ? NULL : &timeout, NULL, 0);
+#else
+  UNUSED(waiting);
+  UNUSED(slice);
+
+  sched_yield();
+#endif
 
   return 0;
 }
 
-void *ring_buffer_dequeue(ring_buffer_t *self, const size_t size)
+/*
+ * Shared by both waits: ready is the side's own readable or writable, and
+ * waiting the flag on the other side's line.
+ */
+static inline int always_inline ring_buffer_wait(ring_buffer_t *self, int (*ready)(ring_buffer_t *, size_t), uint32_t *waiting, const size_t size, const int timeout)
 {
-  if (size > ring_buffer_reader_capacity(self))
+  struct timespec deadline;
+  unsigned spin;
+
+  for (spin = 0U; spin < RING_BUFFER_SPIN; spin++)
   {
-    return NULL;
+    if (ready(self, size))
+    {
+      return 0;
+    }
+
+    ring_buffer_pause();
   }
 
-  void *data = NULL;
-  data = calloc(size, sizeof(*self->data));
-  if (self == NULL)
+  if (timeout > 0)
   {
-    fprintf(stderr, "%s(): %s\n", __func__, "Could not allocate data buffer to the heap");
-    exit(EXIT_FAILURE);
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += timeout / 1000;
+    deadline.tv_nsec += (long)(timeout % 1000) * 1000000L;
+
+    if (deadline.tv_nsec >= 1000000000L)
+    {
+      deadline.tv_sec++;
+      deadline.tv_nsec -= 1000000000L;
+    }
   }
 
-  const void *pointer = self->data + ring_buffer_mask(self, self->reader.head);
-  memcpy(data, pointer, size);
+  while (true)
+  {
+    __atomic_store_n(waiting, 1U, __ATOMIC_RELAXED);
 
-  ring_buffer_decrement(self, size);
-  ring_buffer_try_reset(self);
+    const int exact = ring_buffer_barrier() && self->magic != RING_BUFFER_MAGIC;
 
-  return data;
+    if (ready(self, size))
+    {
+      __atomic_store_n(waiting, 0U, __ATOMIC_RELAXED);
+      return 0;
+    }
+
+    if (timeout == 0 || 0 > ring_buffer_sleep(waiting, timeout > 0 ? &deadline : NULL, exact))
+    {
+      return (-1);
+    }
+  }
 }
 
-size_t ring_buffer_size(const ring_buffer_t *self)
+static int ring_buffer_readable_fn(ring_buffer_t *self, size_t size)
 {
-  return self->writer.head - self->reader.head;
+  return ring_buffer_readable(self, size);
 }
 
-size_t ring_buffer_get_cap(const ring_buffer_t *self)
+static int ring_buffer_writable_fn(ring_buffer_t *self, size_t size)
 {
-  return self->cap;
+  return ring_buffer_writable(self, size);
 }
 
-ring_buffer_writer_t *ring_buffer_get_writer(const ring_buffer_t *self)
+int ring_buffer_wait_nonempty(ring_buffer_t *self, const size_t size, const int timeout)
 {
-  return (ring_buffer_writer_t *)&self->writer;
+  return ring_buffer_wait(self, ring_buffer_readable_fn, &self->writer.waiting, size, timeout);
 }
 
-ring_buffer_reader_t *ring_buffer_get_reader(const ring_buffer_t *self)
+int ring_buffer_wait_nonfull(ring_buffer_t *self, const size_t size, const int timeout)
 {
-  return (ring_buffer_reader_t *)&self->reader;
+  return ring_buffer_wait(self, ring_buffer_writable_fn, &self->reader.waiting, size, timeout);
 }
 
-uint8_t *ring_buffer_get_data(const ring_buffer_t *self)
+int ring_buffer_get_eventfd(ring_buffer_t *self)
+{
+#if defined(__linux__)
+  int fd = __atomic_load_n(&self->fd, __ATOMIC_ACQUIRE);
+  int expected = -1;
+
+  /* the producer reads fd on its publish path, so it is installed atomically */
+  if (fd < 0 && self->magic != RING_BUFFER_MAGIC)
+  {
+    fd = eventfd(0U, EFD_CLOEXEC | EFD_NONBLOCK);
+
+    if (fd >= 0 && !__atomic_compare_exchange_n(&self->fd, &expected, fd, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+    {
+      close(fd);
+      fd = expected;
+    }
+  }
+
+  return fd;
+#else
+  UNUSED(self);
+
+  return (-1);
+#endif
+}
+
+/* publish a cursor, then wake the other side only if it is asleep */
+static inline void always_inline ring_buffer_publish_write(ring_buffer_t *self, const uint64_t head)
+{
+  __atomic_store_n(&self->writer.head, head, __ATOMIC_RELEASE);
+  __atomic_signal_fence(__ATOMIC_SEQ_CST);
+
+  if (__builtin_expect(0U != __atomic_load_n(&self->writer.waiting, __ATOMIC_RELAXED), 0))
+  {
+    ring_buffer_wake(&self->writer.waiting, __atomic_load_n(&self->fd, __ATOMIC_ACQUIRE));
+  }
+}
+
+static inline void always_inline ring_buffer_publish_read(ring_buffer_t *self, const uint64_t head)
+{
+  __atomic_store_n(&self->reader.head, head, __ATOMIC_RELEASE);
+  __atomic_signal_fence(__ATOMIC_SEQ_CST);
+
+  if (__builtin_expect(0U != __atomic_load_n(&self->reader.waiting, __ATOMIC_RELAXED), 0))
+  {
+    ring_buffer_wake(&self->reader.waiting, -1);
+  }
+}
+
+int ring_buffer_enqueue(ring_buffer_t *self, const void *data, size_t size)
+{
+  if (!ring_buffer_writable(self, size) && !ring_buffer_grow(self, size))
+  {
+    return (-1);
+  }
+
+  const uint64_t head = self->writer.head;
+
+  ring_buffer_write(self, head, data, size);
+
+  ring_buffer_publish_write(self, head + size);
+
+  return 0;
+}
+
+void *ring_buffer_dequeue(ring_buffer_t *self, const size_t size)
+{
+  if (!ring_buffer_readable(self, size))
+  {
+    return NULL;
+  }
+
+  void *data = NULL;
+  data = calloc(size, sizeof(uint8_t));
+  if (data == NULL)
+  {
+    fprintf(stderr, "%s(): %s\n", __func__, "Could not allocate data buffer to the heap");
+    exit(EXIT_FAILURE);
+  }
+
+  ring_buffer_dequeue_into(self, data, size);
+
+  return data;
+}
+
+int ring_buffer_dequeue_into(ring_buffer_t *self, void *data, const size_t size)
+{
+  const uint64_t head = self->reader.head;
+
+  if (!ring_buffer_readable(self, size))
+  {
+    return (-1);
+  }
+
+  ring_buffer_read(self, head, data, size);
+
+  ring_buffer_publish_read(self, head + size);
+
+  ring_buffer_shrink(self);
+
+  return 0;
+}
+
+/*
+ * Bulk forms move as many whole records as fit, up to n, with one copy
+ * per side of the wrap and a single cursor update, and return the count.
+ */
+size_t ring_buffer_enqueue_bulk(ring_buffer_t *self, const void *data, const size_t size, const size_t n)
+{
+  size_t count = n;
+
+  if (size == 0UL)
+  {
+    return 0UL;
+  }
+
+  if (!ring_buffer_writable(self, n * size))
+  {
+    ring_buffer_grow(self, n * size);
+  }
+
+  const uint64_t head = self->writer.head;
+
+  if (count > (self->writer.tail - head) / size)
+  {
+    count = (self->writer.tail - head) / size;
+  }
+
+  if (count == 0UL)
+  {
+    return 0UL;
+  }
+
+  ring_buffer_write(self, head, data, count * size);
+
+  ring_buffer_publish_write(self, head + count * size);
+
+  return count;
+}
+
+size_t ring_buffer_dequeue_bulk(ring_buffer_t *self, void *data, const size_t size, const size_t n)
+{
+  const uint64_t head = self->reader.head;
+  size_t count = n;
+
+  if (size == 0UL)
+  {
+    return 0UL;
+  }
+
+  ring_buffer_readable(self, n * size);
+
+  if (count > (self->reader.tail - head) / size)
+  {
+    count = (self->reader.tail - head) / size;
+  }
+
+  if (count == 0UL)
+  {
+    return 0UL;
+  }
+
+  ring_buffer_read(self, head, data, count * size);
+
+  ring_buffer_publish_read(self, head + count * size);
+
+  ring_buffer_shrink(self);
+
+  return count;
+}
+
+/*
+ * The zero-copy calls hand out the ring's own memory, so a span that
+ * would wrap past the end is refused; the copying calls still take it.
+ * A mirrored ring never refuses one.
+ */
+void *ring_buffer_reserve(ring_buffer_t *self, const size_t size)
+{
+  if (!ring_buffer_writable(self, size) && !ring_buffer_grow(self, size))
+  {
+    return NULL;
+  }
+
+  const uint64_t offset = ring_buffer_mask(self->cap, self->writer.head);
+
+  if (size > self->span - offset)
+  {
+    return NULL;
+  }
+
+  return ring_buffer_data(self) + offset;
+}
+
+void ring_buffer_commit(ring_buffer_t *self, const size_t size)
+{
+  ring_buffer_publish_write(self, self->writer.head + size);
+}
+
+const void *ring_buffer_peek(ring_buffer_t *self, const size_t size)
+{
+  const uint64_t offset = ring_buffer_mask(self->cap, self->reader.head);
+
+  if (size > self->span - offset || !ring_buffer_readable(self, size))
+  {
+    return NULL;
+  }
+
+  return ring_buffer_data(self) + offset;
+}
+
+void ring_buffer_release(ring_buffer_t *self, const size_t size)
+{
+  ring_buffer_publish_read(self, self->reader.head + size);
+
+  ring_buffer_shrink(self);
+}
+
+/*
+ * A frame is an 8-byte header, the payload and padding up to the next
+ * multiple of 8, so every header and payload stays 8-byte aligned. When
+ * a frame does not fit before the end of the buffer, the writer fills
+ * the rest with a pad frame and starts the real one at the beginning;
+ * the pad records its own length, so it survives a growable resize.
+ */
+#define RING_BUFFER_FRAME_PAD 1U
+
+typedef struct ring_buffer_frame
+{
+  uint32_t len;
+  uint32_t flags;
+} ring_buffer_frame_t;
+
+static inline size_t always_inline ring_buffer_frame_size(const size_t len)
+{
+  return sizeof(ring_buffer_frame_t) + ((len + sizeof(ring_buffer_frame_t) - 1UL) & ~(sizeof(ring_buffer_frame_t) - 1UL));
+}
+
+void *ring_buffer_reserve_frame(ring_buffer_t *self, const size_t len)
+{
+  const size_t size = ring_buffer_frame_size(len);
+  ring_buffer_frame_t *frame = NULL;
+  uint64_t offset = ring_buffer_mask(self->cap, self->writer.head);
+  size_t skip = size > self->span - offset ? self->span - offset : 0UL;
+
+  /* a pad is shorter than its frame, so half a fixed ring fits once drained */
+  if (len > UINT32_MAX || (self->min_cap == 0UL && self->span == self->cap && size > self->cap / 2UL))
+  {
+    return NULL;
+  }
+
+  if (!ring_buffer_writable(self, skip + size))
+  {
+    if (!ring_buffer_grow(self, skip + size))
+    {
+      return NULL;
+    }
+
+    offset = ring_buffer_mask(self->cap, self->writer.head);
+    skip = size > self->span - offset ? self->span - offset : 0UL;
+  }
+
+  frame = (ring_buffer_frame_t *)(ring_buffer_data(self) + offset);
+
+  if (skip != 0UL)
+  {
+    frame->len = (uint32_t)(skip - sizeof(*frame));
+    frame->flags = RING_BUFFER_FRAME_PAD;
+    frame = (ring_buffer_frame_t *)ring_buffer_data(self);
+  }
+
+  frame->len = (uint32_t)len;
+  frame->flags = 0U;
+
+  return frame + 1;
+}
+
+void ring_buffer_commit_frame(ring_buffer_t *self, const size_t len)
+{
+  const uint64_t head = self->writer.head;
+  ring_buffer_frame_t *frame = (ring_buffer_frame_t *)(ring_buffer_data(self) + ring_buffer_mask(self->cap, head));
+  size_t skip = 0UL;
+
+  if (frame->flags & RING_BUFFER_FRAME_PAD)
+  {
+    skip = sizeof(*frame) + frame->len;
+    frame = (ring_buffer_frame_t *)ring_buffer_data(self);
+  }
+
+  frame->len = (uint32_t)len;
+
+  ring_buffer_publish_write(self, head + skip + ring_buffer_frame_size(len));
+}
+
+int ring_buffer_write_frame(ring_buffer_t *self, const void *data, const size_t len)
+{
+  void *payload = ring_buffer_reserve_frame(self, len);
+
+  if (payload == NULL)
+  {
+    return (-1);
+  }
+
+  memcpy(payload, data, len);
+  ring_buffer_commit_frame(self, len);
+
+  return 0;
+}
+
+const void *ring_buffer_read_frame(ring_buffer_t *self, size_t *len)
+{
+  const ring_buffer_frame_t *frame = NULL;
+
+  while (true)
+  {
+    if (!ring_buffer_readable(self, sizeof(*frame)))
+    {
+      return NULL;
+    }
+
+    frame = (const ring_buffer_frame_t *)(ring_buffer_data(self) + ring_buffer_mask(self->cap, self->reader.head));
+
+    if (!(frame->flags & RING_BUFFER_FRAME_PAD))
+    {
+      break;
+    }
+
+    ring_buffer_publish_read(self, self->reader.head + sizeof(*frame) + frame->len);
+  }
+
+  *len = frame->len;
+
+  return frame + 1;
+}
+
+void ring_buffer_release_frame(ring_buffer_t *self, const size_t len)
+{
+  ring_buffer_release(self, ring_buffer_frame_size(len));
+}
+
+/* describes n bytes of the ring from a cursor as at most two contiguous regions */
+static inline int always_inline ring_buffer_iovec(const ring_buffer_t *self, const uint64_t at, const size_t n, struct iovec *iov)
+{
+  const uint64_t offset = ring_buffer_mask(self->cap, at);
+  const size_t first = n < self->span - offset ? n : self->span - offset;
+
+  iov[0].iov_base = ring_buffer_data(self) + offset;
+  iov[0].iov_len = first;
+  iov[1].iov_base = ring_buffer_data(self);
+  iov[1].iov_len = n - first;
+
+  return n > first ? 2 : 1;
+}
+
+ssize_t ring_buffer_write_fd(ring_buffer_t *self, const int fd, const size_t max)
+{
+  struct iovec iov[2];
+  ssize_t written;
+  size_t n;
+
+  self->reader.tail = __atomic_load_n(&self->writer.head, __ATOMIC_ACQUIRE);
+  n = self->reader.tail - self->reader.head;
+  n = n < max ? n : max;
+
+  if (n == 0UL)
+  {
+    return 0;
+  }
+
+  written = writev(fd, iov, ring_buffer_iovec(self, self->reader.head, n, iov));
+  if (written > 0)
+  {
+    ring_buffer_release(self, (size_t)written);
+  }
+
+  return written;
+}
+
+ssize_t ring_buffer_read_fd(ring_buffer_t *self, const int fd, const size_t max)
+{
+  struct iovec iov[2];
+  ssize_t got;
+  size_t n;
+
+  self->writer.tail = __atomic_load_n(&self->reader.head, __ATOMIC_ACQUIRE) + self->cap;
+  n = self->writer.tail - self->writer.head;
+  n = n < max ? n : max;
+
+  if (n == 0UL)
+  {
+    errno = ENOBUFS;
+    return (-1);
+  }
+
+  got = readv(fd, iov, ring_buffer_iovec(self, self->writer.head, n, iov));
+  if (got > 0)
+  {
+    ring_buffer_commit(self, (size_t)got);
+  }
+
+  return got;
+}
+
+/*
+ * Drains a ring to a file descriptor through io_uring, set up with raw
+ * system calls. The ring's data is registered as a fixed buffer when the
+ * kernel allows it. Each flush queues the readable bytes as a chain of at
+ * most two linked writes, so they land in order, and only releases them
+ * once they complete; a short write cancels the rest of the chain, which
+ * is then queued again from where it stopped. One chain is in flight at a
+ * time, so a flush costs one io_uring_enter however much it moves.
+ */
+#if defined(RING_BUFFER_URING)
+struct ring_buffer_uring
+{
+  ring_buffer_t *ring;
+  int uring;
+  int fd;
+  int fixed;
+  uint32_t *sq_tail;
+  uint32_t *sq_mask;
+  uint32_t *sq_array;
+  struct io_uring_sqe *sqes;
+  uint32_t *cq_head;
+  uint32_t *cq_tail;
+  uint32_t *cq_mask;
+  struct io_uring_cqe *cqes;
+  void *sq_map;
+  size_t sq_size;
+  void *cq_map;
+  size_t cq_size;
+  size_t sqes_size;
+  uint32_t inflight;
+  int failed;
+};
+
+#define RING_BUFFER_URING_DEPTH 4U
+#endif
+
+ring_buffer_uring_t *ring_buffer_uring_create(ring_buffer_t *ring, const int fd)
+{
+#if defined(RING_BUFFER_URING)
+  ring_buffer_uring_t *self = NULL;
+  struct io_uring_params params;
+  struct iovec iov;
+  int uring;
+
+  /* a growable ring moves its data, so it cannot stay registered */
+  if (ring->min_cap != 0UL)
+  {
+    return NULL;
+  }
+
+  memset(&params, 0, sizeof(params));
+
+  uring = (int)syscall(__NR_io_uring_setup, RING_BUFFER_URING_DEPTH, &params);
+  if (uring < 0)
+  {
+    return NULL;
+  }
+
+  self = (ring_buffer_uring_t *)calloc(1UL, sizeof(*self));
+  if (self == NULL)
+  {
+    fprintf(stderr, "%s(): %s\n", __func__, "Could not allocate ring buffer uring to the heap");
+    exit(EXIT_FAILURE);
+  }
+
+  self->ring = ring;
+  self->uring = uring;
+  self->fd = fd;
+  self->sq_size = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+  self->cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  self->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+
+  if (params.features & IORING_FEAT_SINGLE_MMAP)
+  {
+    self->sq_size = self->sq_size > self->cq_size ? self->sq_size : self->cq_size;
+  }
+
+  self->sq_map = mmap(NULL, self->sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, uring, IORING_OFF_SQ_RING);
+  self->cq_map = self->sq_map;
+
+  if (self->sq_map != MAP_FAILED && !(params.features & IORING_FEAT_SINGLE_MMAP))
+  {
+    self->cq_map = mmap(NULL, self->cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, uring, IORING_OFF_CQ_RING);
+  }
+
+  self->sqes = mmap(NULL, self->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, uring, IORING_OFF_SQES);
+
+  if (self->sq_map == MAP_FAILED || self->cq_map == MAP_FAILED || self->sqes == MAP_FAILED)
+  {
+    ring_buffer_uring_destroy(self);
+    return NULL;
+  }
+
+  self->sq_tail = (uint32_t *)((uint8_t *)self->sq_map + params.sq_off.tail);
+  self->sq_mask = (uint32_t *)((uint8_t *)self->sq_map + params.sq_off.ring_mask);
+  self->sq_array = (uint32_t *)((uint8_t *)self->sq_map + params.sq_off.array);
+  self->cq_head = (uint32_t *)((uint8_t *)self->cq_map + params.cq_off.head);
+  self->cq_tail = (uint32_t *)((uint8_t *)self->cq_map + params.cq_off.tail);
+  self->cq_mask = (uint32_t *)((uint8_t *)self->cq_map + params.cq_off.ring_mask);
+  self->cqes = (struct io_uring_cqe *)((uint8_t *)self->cq_map + params.cq_off.cqes);
+
+  iov.iov_base = ring_buffer_data(ring);
+  iov.iov_len = ring->span;
+
+  self->fixed = 0 == syscall(__NR_io_uring_register, uring, IORING_REGISTER_BUFFERS, &iov, 1);
+
+  return self;
+#else
+  UNUSED(ring);
+  UNUSED(fd);
+
+  return NULL;
+#endif
+}
+
+void ring_buffer_uring_destroy(ring_buffer_uring_t *self)
+{
+#if defined(RING_BUFFER_URING)
+  if (self != NULL)
+  {
+    if (self->sqes != NULL && self->sqes != MAP_FAILED)
+    {
+      munmap(self->sqes, self->sqes_size);
+    }
+
+    if (self->cq_map != NULL && self->cq_map != MAP_FAILED && self->cq_map != self->sq_map)
+    {
+      munmap(self->cq_map, self->cq_size);
+    }
+
+    if (self->sq_map != NULL && self->sq_map != MAP_FAILED)
+    {
+      munmap(self->sq_map, self->sq_size);
+    }
+
+    close(self->uring);
+    free(self);
+    self = NULL;
+  }
+#else
+  UNUSED(self);
+#endif
+}
+
+#if defined(RING_BUFFER_URING)
+/* takes completions in order, releasing what was written */
+static size_t ring_buffer_uring_reap(ring_buffer_uring_t *self)
+{
+  uint32_t head = *self->cq_head;
+  size_t released = 0UL;
+
+  while (head != __atomic_load_n(self->cq_tail, __ATOMIC_ACQUIRE))
+  {
+    const struct io_uring_cqe *cqe = &self->cqes[head & *self->cq_mask];
+
+    if (cqe->res > 0)
+    {
+      ring_buffer_release(self->ring, (size_t)cqe->res);
+      released += (size_t)cqe->res;
+    }
+
+    if (cqe->res < 0 && cqe->res != -ECANCELED && self->failed == 0)
+    {
+      self->failed = -cqe->res;
+    }
+
+    self->inflight--;
+    head++;
+  }
+
+  __atomic_store_n(self->cq_head, head, __ATOMIC_RELEASE);
+
+  return released;
+}
+#endif
+
+ssize_t ring_buffer_uring_flush(ring_buffer_uring_t *self, const int wait)
+{
+#if defined(RING_BUFFER_URING)
+  ring_buffer_t *ring = self->ring;
+  struct iovec iov[2];
+  uint32_t queued = 0U;
+  uint32_t tail;
+  size_t released;
+  int count;
+  int i;
+
+  released = ring_buffer_uring_reap(self);
+
+  if (self->inflight == 0U)
+  {
+    ring->reader.tail = __atomic_load_n(&ring->writer.head, __ATOMIC_ACQUIRE);
+
+    const size_t n = ring->reader.tail - ring->reader.head;
+
+    if (n != 0UL)
+    {
+      count = ring_buffer_iovec(ring, ring->reader.head, n, iov);
+      tail = *self->sq_tail;
+
+      for (i = 0; i < count; i++, tail++)
+      {
+        const uint32_t index = tail & *self->sq_mask;
+        struct io_uring_sqe *sqe = &self->sqes[index];
+
+        memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = self->fixed ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+        sqe->fd = self->fd;
+        sqe->off = (uint64_t)-1;
+        sqe->addr = (uint64_t)(uintptr_t)iov[i].iov_base;
+        sqe->len = (uint32_t)iov[i].iov_len;
+        sqe->flags = i + 1 < count ? IOSQE_IO_LINK : 0;
+        self->sq_array[index] = index;
+      }
+
+      __atomic_store_n(self->sq_tail, tail, __ATOMIC_RELEASE);
+
+      queued = (uint32_t)count;
+      self->inflight = queued;
+    }
+  }
+
+  if (queued != 0U || (wait && self->inflight != 0U))
+  {
+    const uint32_t min = wait && self->inflight != 0U ? 1U : 0U;
+
+    if (0 > syscall(__NR_io_uring_enter, self->uring, queued, min, min != 0U ? IORING_ENTER_GETEVENTS : 0U, NULL, 0))
+    {
+      return (-1);
+    }
+
+    released += ring_buffer_uring_reap(self);
+  }
+
+  if (self->failed != 0 && self->inflight == 0U)
+  {
+    errno = self->failed;
+    self->failed = 0;
+    return (-1);
+  }
+
+  return (ssize_t)released;
+#else
+  UNUSED(self);
+  UNUSED(wait);
+
+  errno = ENOSYS;
+  return (-1);
+#endif
+}
+
+/* exact from either side when the other is idle, a snapshot otherwise */
+size_t ring_buffer_size(const ring_buffer_t *self)
+{
+  const uint64_t read = __atomic_load_n(&self->reader.head, __ATOMIC_ACQUIRE);
+  const uint64_t written = __atomic_load_n(&self->writer.head, __ATOMIC_ACQUIRE);
+
+  return written - read;
+}
+
+size_t ring_buffer_get_cap(const ring_buffer_t *self)
+{
+  return self->cap;
+}
+
+ring_buffer_writer_t *ring_buffer_get_writer(const ring_buffer_t *self)
+{
+  return (ring_buffer_writer_t *)&self->writer;
+}
+
+ring_buffer_reader_t *ring_buffer_get_reader(const ring_buffer_t *self)
+{
+  return (ring_buffer_reader_t *)&self->reader;
+}
+
+uint8_t *ring_buffer_get_data(const ring_buffer_t *self)
+{
+  return ring_buffer_data(self);
+}
+
+/*
+ * Bounded multi-producer/multi-consumer queue of fixed-size slots, after
+ * Dmitry Vyukov's design. Each slot carries a sequence number: slot i is
+ * free for the enqueue at position p when its sequence equals p, and full
+ * for the dequeue at p when it equals p + 1. Producers and consumers claim
+ * positions with a CAS on their own cursor, each on its own cache line.
+ */
+struct mpmc_queue
+{
+  size_t cap;
+  size_t size;
+  size_t stride;
+  uint8_t *slots;
+  uint64_t enqueue_pos __attribute__ ((aligned(CACHE_LINE)));
+  uint64_t dequeue_pos __attribute__ ((aligned(CACHE_LINE)));
+  mpmc_queue_stats_t stats __attribute__ ((aligned(CACHE_LINE)));
+};
+
+mpmc_queue_t *mpmc_queue_create(const size_t cap, const size_t size)
+{
+  mpmc_queue_t *self = NULL;
+  uint64_t i;
+
+  if (0 != posix_memalign((void **)&self, CACHE_LINE, sizeof(*self)))
+  {
+    fprintf(stderr, "%s(): %s\n", __func__, "Could not allocate mpmc queue to the heap");
+    exit(EXIT_FAILURE);
+  }
+
+  memset(self, 0, sizeof(*self));
+
+  self->cap = ring_buffer_round_cap(cap < 2UL ? 2UL : cap);
+  self->size = size;
+  self->stride = (sizeof(uint64_t) + size + sizeof(uint64_t) - 1UL) & ~(sizeof(uint64_t) - 1UL);
+
+  if (0 != posix_memalign((void **)&self->slots, CACHE_LINE, self->cap * self->stride))
+  {
+    fprintf(stderr, "%s(): %s\n", __func__, "Could not allocate mpmc queue slots to the heap");
+    exit(EXIT_FAILURE);
+  }
+
+  for (i = 0UL; i < self->cap; i++)
+  {
+    *(uint64_t *)(self->slots + i * self->stride) = i;
+  }
+
+  return self;
+}
+
+void mpmc_queue_destroy(mpmc_queue_t *self)
+{
+  if (self != NULL)
+  {
+    free(self->slots);
+    free(self);
+    self = NULL;
+  }
+}
+
+static inline uint64_t *always_inline mpmc_queue_slot(const mpmc_queue_t *self, const uint64_t pos)
+{
+  return (uint64_t *)(self->slots + ring_buffer_mask(self->cap, pos) * self->stride);
+}
+
+int mpmc_queue_enqueue(mpmc_queue_t *self, const void *data)
+{
+  uint64_t pos = __atomic_load_n(&self->enqueue_pos, __ATOMIC_RELAXED);
+  uint64_t *slot = NULL;
+
+  for (;;)
+  {
+    slot = mpmc_queue_slot(self, pos);
+
+    const int64_t diff = (int64_t)(__atomic_load_n(slot, __ATOMIC_ACQUIRE) - pos);
+
+    if (diff == 0)
+    {
+      if (__atomic_compare_exchange_n(&self->enqueue_pos, &pos, pos + 1UL, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+      {
+        break;
+      }
+    }
+    else if (diff < 0)
+    {
+      __atomic_fetch_add(&self->stats.full, 1UL, __ATOMIC_RELAXED);
+      return (-1);
+    }
+    else
+    {
+      pos = __atomic_load_n(&self->enqueue_pos, __ATOMIC_RELAXED);
+    }
+
+    __atomic_fetch_add(&self->stats.enqueue_retries, 1UL, __ATOMIC_RELAXED);
+  }
+
+  memcpy(slot + 1, data, self->size);
+  __atomic_store_n(slot, pos + 1UL, __ATOMIC_RELEASE);
+
+  return 0;
+}
+
+int mpmc_queue_dequeue(mpmc_queue_t *self, void *data)
+{
+  uint64_t pos = __atomic_load_n(&self->dequeue_pos, __ATOMIC_RELAXED);
+  uint64_t *slot = NULL;
+
+  for (;;)
+  {
+    slot = mpmc_queue_slot(self, pos);
+
+    const int64_t diff = (int64_t)(__atomic_load_n(slot, __ATOMIC_ACQUIRE) - (pos + 1UL));
+
+    if (diff == 0)
+    {
+      if (__atomic_compare_exchange_n(&self->dequeue_pos, &pos, pos + 1UL, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+      {
+        break;
+      }
+    }
+    else if (diff < 0)
+    {
+      __atomic_fetch_add(&self->stats.empty, 1UL, __ATOMIC_RELAXED);
+      return (-1);
+    }
+    else
+    {
+      pos = __atomic_load_n(&self->dequeue_pos, __ATOMIC_RELAXED);
+    }
+
+    __atomic_fetch_add(&self->stats.dequeue_retries, 1UL, __ATOMIC_RELAXED);
+  }
+
+  memcpy(data, slot + 1, self->size);
+  __atomic_store_n(slot, pos + self->cap, __ATOMIC_RELEASE);
+
+  return 0;
+}
+
+/*
+ * Bulk forms claim a run of consecutive ready slots, up to n, with one
+ * CAS on the cursor; each slot is still handed over by its own sequence
+ * store. They return the count moved, 0 when full or empty.
+ */
+size_t mpmc_queue_enqueue_bulk(mpmc_queue_t *self, const void *data, const size_t n)
+{
+  uint64_t pos = __atomic_load_n(&self->enqueue_pos, __ATOMIC_RELAXED);
+  size_t count;
+  size_t i;
+
+  for (;;)
+  {
+    for (count = 0UL; count < n && count < self->cap; count++)
+    {
+      if (__atomic_load_n(mpmc_queue_slot(self, pos + count), __ATOMIC_ACQUIRE) != pos + count)
+      {
+        break;
+      }
+    }
+
+    if (count == 0UL)
+    {
+      const int64_t diff = (int64_t)(__atomic_load_n(mpmc_queue_slot(self, pos), __ATOMIC_ACQUIRE) - pos);
+
+      if (diff < 0)
+      {
+        __atomic_fetch_add(&self->stats.full, 1UL, __ATOMIC_RELAXED);
+        return 0UL;
+      }
+
+      pos = __atomic_load_n(&self->enqueue_pos, __ATOMIC_RELAXED);
+    }
+    else if (__atomic_compare_exchange_n(&self->enqueue_pos, &pos, pos + count, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    {
+      break;
+    }
+
+    __atomic_fetch_add(&self->stats.enqueue_retries, 1UL, __ATOMIC_RELAXED);
+  }
+
+  for (i = 0UL; i < count; i++)
+  {
+    uint64_t *slot = mpmc_queue_slot(self, pos + i);
+
+    memcpy(slot + 1, (const uint8_t *)data + i * self->size, self->size);
+    __atomic_store_n(slot, pos + i + 1UL, __ATOMIC_RELEASE);
+  }
+
+  return count;
+}
+
+size_t mpmc_queue_dequeue_bulk(mpmc_queue_t *self, void *data, const size_t n)
+{
+  uint64_t pos = __atomic_load_n(&self->dequeue_pos, __ATOMIC_RELAXED);
+  size_t count;
+  size_t i;
+
+  for (;;)
+  {
+    for (count = 0UL; count < n && count < self->cap; count++)
+    {
+      if (__atomic_load_n(mpmc_queue_slot(self, pos + count), __ATOMIC_ACQUIRE) != pos + count + 1UL)
+      {
+        break;
+      }
+    }
+
+    if (count == 0UL)
+    {
+      const int64_t diff = (int64_t)(__atomic_load_n(mpmc_queue_slot(self, pos), __ATOMIC_ACQUIRE) - (pos + 1UL));
+
+      if (diff < 0)
+      {
+        __atomic_fetch_add(&self->stats.empty, 1UL, __ATOMIC_RELAXED);
+        return 0UL;
+      }
+
+      pos = __atomic_load_n(&self->dequeue_pos, __ATOMIC_RELAXED);
+    }
+    else if (__atomic_compare_exchange_n(&self->dequeue_pos, &pos, pos + count, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    {
+      break;
+    }
+
+    __atomic_fetch_add(&self->stats.dequeue_retries, 1UL, __ATOMIC_RELAXED);
+  }
+
+  for (i = 0UL; i < count; i++)
+  {
+    uint64_t *slot = mpmc_queue_slot(self, pos + i);
+
+    memcpy((uint8_t *)data + i * self->size, slot + 1, self->size);
+    __atomic_store_n(slot, pos + i + self->cap, __ATOMIC_RELEASE);
+  }
+
+  return count;
+}
+
+size_t mpmc_queue_size(const mpmc_queue_t *self)
+{
+  const uint64_t read = __atomic_load_n(&self->dequeue_pos, __ATOMIC_ACQUIRE);
+  const uint64_t written = __atomic_load_n(&self->enqueue_pos, __ATOMIC_ACQUIRE);
+
+  return written > read ? written - read : 0UL;
+}
+
+size_t mpmc_queue_get_cap(const mpmc_queue_t *self)
+{
+  return self->cap;
+}
+
+void mpmc_queue_get_stats(const mpmc_queue_t *self, mpmc_queue_stats_t *stats)
+{
+  stats->enqueue_retries = __atomic_load_n(&self->stats.enqueue_retries, __ATOMIC_RELAXED);
+  stats->dequeue_retries = __atomic_load_n(&self->stats.dequeue_retries, __ATOMIC_RELAXED);
+  stats->full = __atomic_load_n(&self->stats.full, __ATOMIC_RELAXED);
+  stats->empty = __atomic_load_n(&self->stats.empty, __ATOMIC_RELAXED);
+}
+
+/*
+ * Disruptor-style broadcast ring: one producer writes each event once into
+ * a slot and every consumer reads it in place. A consumer's seq is the
+ * next event it will process; it may read up to the producer's cursor and
+ * the seq of every consumer it depends on. The producer may reuse a slot
+ * once the slowest consumer has passed it. Both sides cache the limit they
+ * last computed, so the other lines are only read when it runs out.
+ */
+struct broadcast_ring_consumer
+{
+  uint64_t seq;
+  uint64_t limit;
+  uint32_t deps;
+} __attribute__ ((aligned(CACHE_LINE)));
+
+struct broadcast_ring
+{
+  size_t cap;
+  size_t size;
+  size_t stride;
+  size_t count;
+  uint8_t *slots;
+  uint64_t cursor __attribute__ ((aligned(CACHE_LINE)));
+  uint64_t limit;
+  struct broadcast_ring_consumer consumers[BROADCAST_RING_CONSUMERS];
+};
+
+broadcast_ring_t *broadcast_ring_create(const size_t cap, const size_t size)
+{
+  broadcast_ring_t *self = NULL;
+
+  if (0 != posix_memalign((void **)&self, CACHE_LINE, sizeof(*self)))
+  {
+    fprintf(stderr, "%s(): %s\n", __func__, "Could not allocate broadcast ring to the heap");
+    exit(EXIT_FAILURE);
+  }
+
+  memset(self, 0, sizeof(*self));
+
+  self->cap = ring_buffer_round_cap(cap);
+  self->size = size;
+  self->stride = (size + sizeof(uint64_t) - 1UL) & ~(sizeof(uint64_t) - 1UL);
+
+  if (0 != posix_memalign((void **)&self->slots, CACHE_LINE, self->cap * self->stride))
+  {
+    fprintf(stderr, "%s(): %s\n", __func__, "Could not allocate broadcast ring slots to the heap");
+    exit(EXIT_FAILURE);
+  }
+
+  self->limit = self->cap;
+
+  return self;
+}
+
+void broadcast_ring_destroy(broadcast_ring_t *self)
+{
+  if (self != NULL)
+  {
+    free(self->slots);
+    free(self);
+    self = NULL;
+  }
+}
+
+int broadcast_ring_add_consumer(broadcast_ring_t *self, const int *deps, const size_t n)
+{
+  struct broadcast_ring_consumer *consumer = NULL;
+  size_t i;
+
+  if (self->count == BROADCAST_RING_CONSUMERS)
+  {
+    return (-1);
+  }
+
+  consumer = &self->consumers[self->count];
+  consumer->deps = 0U;
+
+  for (i = 0UL; i < n; i++)
+  {
+    if (deps[i] < 0 || (size_t)deps[i] >= self->count)
+    {
+      return (-1);
+    }
+
+    consumer->deps |= 1U << deps[i];
+  }
+
+  consumer->seq = self->cursor;
+  consumer->limit = self->cursor;
+
+  return (int)self->count++;
+}
+
+static inline uint8_t *always_inline broadcast_ring_slot(const broadcast_ring_t *self, const uint64_t seq)
+{
+  return self->slots + ring_buffer_mask(self->cap, seq) * self->stride;
+}
+
+void *broadcast_ring_reserve(broadcast_ring_t *self)
+{
+  size_t i;
+
+  if (self->cursor == self->limit)
+  {
+    uint64_t slowest = self->cursor;
+
+    for (i = 0UL; i < self->count; i++)
+    {
+      const uint64_t seq = __atomic_load_n(&self->consumers[i].seq, __ATOMIC_ACQUIRE);
+
+      slowest = seq < slowest ? seq : slowest;
+    }
+
+    self->limit = slowest + self->cap;
+
+    if (self->cursor == self->limit)
+    {
+      return NULL;
+    }
+  }
+
+  return broadcast_ring_slot(self, self->cursor);
+}
+
+void broadcast_ring_commit(broadcast_ring_t *self)
+{
+  __atomic_store_n(&self->cursor, self->cursor + 1UL, __ATOMIC_RELEASE);
+}
+
+int broadcast_ring_publish(broadcast_ring_t *self, const void *data)
+{
+  void *slot = broadcast_ring_reserve(self);
+
+  if (slot == NULL)
+  {
+    return (-1);
+  }
+
+  memcpy(slot, data, self->size);
+  broadcast_ring_commit(self);
+
+  return 0;
+}
+
+size_t broadcast_ring_available(broadcast_ring_t *self, const int id)
+{
+  struct broadcast_ring_consumer *consumer = &self->consumers[id];
+  uint32_t deps = consumer->deps;
+
+  if (consumer->seq == consumer->limit)
+  {
+    uint64_t limit = __atomic_load_n(&self->cursor, __ATOMIC_ACQUIRE);
+
+    while (deps != 0U)
+    {
+      const uint64_t seq = __atomic_load_n(&self->consumers[__builtin_ctz(deps)].seq, __ATOMIC_ACQUIRE);
+
+      limit = seq < limit ? seq : limit;
+      deps &= deps - 1U;
+    }
+
+    consumer->limit = limit;
+  }
+
+  return (size_t)(consumer->limit - consumer->seq);
+}
+
+const void *broadcast_ring_peek(const broadcast_ring_t *self, const int id, const size_t index)
+{
+  return broadcast_ring_slot(self, self->consumers[id].seq + index);
+}
+
+void broadcast_ring_release(broadcast_ring_t *self, const int id, const size_t n)
+{
+  __atomic_store_n(&self->consumers[id].seq, self->consumers[id].seq + n, __ATOMIC_RELEASE);
+}
+
+size_t broadcast_ring_get_cap(const broadcast_ring_t *self)
+{
+  return self->cap;
+}
+
+/*
+ * Double-ended queue of fixed-size elements stored inline in blocks of
+ * about DEQUE_BLOCK bytes. A map of block pointers is indexed by element
+ * position, so growing at either end allocates a block or remaps the
+ * pointers, and never moves an element. Emptied blocks are freed, keeping
+ * one spare so a queue that oscillates across a block edge does not
+ * allocate each time.
+ */
+#define DEQUE_BLOCK 4096UL
+#define DEQUE_MAP   8UL
+
+struct deque
+{
+  uint8_t **map;
+  size_t map_cap;
+  size_t size;
+  size_t shift;
+  uint64_t begin;
+  size_t count;
+  uint8_t *spare;
+};
+
+deque_t *deque_create(const size_t size)
+{
+  deque_t *self = NULL;
+
+  /* a block holds DEQUE_BLOCK / size elements, which needs size != 0 */
+  if (size == 0UL)
+  {
+    return NULL;
+  }
+
+  self = (deque_t *)calloc(1UL, sizeof(*self));
+  if (self == NULL)
+  {
+    fprintf(stderr, "%s(): %s\n", __func__, "could not allocate deque to the heap");
+    exit(EXIT_FAILURE);
+  }
+
+  self->map = (uint8_t **)calloc(DEQUE_MAP, sizeof(*self->map));
+  if (self->map == NULL)
+  {
+    fprintf(stderr, "%s(): %s\n", __func__, "could not allocate deque.map to the heap");
+    exit(EXIT_FAILURE);
+  }
+
+  self->map_cap = DEQUE_MAP;
+  self->size = size;
+
+  while (((2UL << self->shift) * size) <= DEQUE_BLOCK)
+  {
+    self->shift++;
+  }
+
+  self->begin = (DEQUE_MAP / 2UL) << self->shift;
+
+  return self;
+}
+
+void deque_destroy(deque_t *self)
+{
+  size_t i;
+
+  if (self != NULL)
+  {
+    for (i = 0UL; i < self->map_cap; i++)
+    {
+      free(self->map[i]);
+    }
+
+    free(self->map);
+    free(self->spare);
+    free(self);
+    self = NULL;
+  }
+}
+
+static inline uint8_t *always_inline deque_slot(const deque_t *self, const uint64_t pos)
+{
+  return self->map[pos >> self->shift] + (pos & ((1UL << self->shift) - 1UL)) * self->size;
+}
+
+static void deque_block_acquire(deque_t *self, const uint64_t pos)
+{
+  uint8_t **block = &self->map[pos >> self->shift];
+
+  if (*block != NULL)
+  {
+    return;
+  }
+
+  if (self->spare != NULL)
+  {
+    *block = self->spare;
+    self->spare = NULL;
+    return;
+  }
+
+  *block = (uint8_t *)malloc(self->size << self->shift);
+  if (*block == NULL)
+  {
+    fprintf(stderr, "%s(): %s\n", __func__, "could not allocate deque block to the heap");
+    exit(EXIT_FAILURE);
+  }
+}
+
+static void deque_block_release(deque_t *self, const uint64_t pos)
+{
+  uint8_t **block = &self->map[pos >> self->shift];
+
+  if (self->spare == NULL)
+  {
+    self->spare = *block;
+  }
+  else
+  {
+    free(*block);
+  }
+
+  *block = NULL;
+}
+
+/*
+ * Recentres the blocks in use in a map with room on both sides, doubling
+ * the map when they fill more than half of it.
+ */
+static void deque_remap(deque_t *self)
+{
+  const uint64_t first = self->begin >> self->shift;
+  const size_t used = self->count == 0UL ? 0UL : (size_t)(((self->begin + self->count - 1UL) >> self->shift) - first + 1UL);
+  size_t map_cap = self->map_cap;
+  uint8_t **map = NULL;
+  size_t start;
+
+  while (used + 2UL > map_cap / 2UL)
+  {
+    map_cap *= 2UL;
+  }
+
+  map = (uint8_t **)calloc(map_cap, sizeof(*map));
+  if (map == NULL)
+  {
+    fprintf(stderr, "%s(): %s\n", __func__, "could not allocate deque.map to the heap");
+    exit(EXIT_FAILURE);
+  }
+
+  start = (map_cap - used) / 2UL;
+
+  if (used > 0UL)
+  {
+    memcpy(map + start, self->map + first, used * sizeof(*map));
+  }
+
+  free(self->map);
+
+  self->map = map;
+  self->map_cap = map_cap;
+  self->begin = ((uint64_t)start << self->shift) + (self->begin & ((1UL << self->shift) - 1UL));
+}
+
+int deque_push_back(deque_t *self, const void *data)
+{
+  if (((self->begin + self->count) >> self->shift) >= self->map_cap)
+  {
+    deque_remap(self);
+  }
+
+  const uint64_t pos = self->begin + self->count;
+
+  deque_block_acquire(self, pos);
+  memcpy(deque_slot(self, pos), data, self->size);
+  self->count++;
+
+  return 0;
+}
+
+int deque_push_front(deque_t *self, const void *data)
+{
+  if (self->begin == 0UL)
+  {
+    deque_remap(self);
+  }
+
+  const uint64_t pos = self->begin - 1UL;
+
+  deque_block_acquire(self, pos);
+  memcpy(deque_slot(self, pos), data, self->size);
+  self->begin = pos;
+  self->count++;
+
+  return 0;
+}
+
+int deque_pop_front(deque_t *self, void *data)
+{
+  const uint64_t pos = self->begin;
+
+  if (self->count == 0UL)
+  {
+    return (-1);
+  }
+
+  if (data != NULL)
+  {
+    memcpy(data, deque_slot(self, pos), self->size);
+  }
+
+  self->begin++;
+  self->count--;
+
+  if (self->count == 0UL || (self->begin >> self->shift) != (pos >> self->shift))
+  {
+    deque_block_release(self, pos);
+  }
+
+  return 0;
+}
+
+int deque_pop_back(deque_t *self, void *data)
+{
+  const uint64_t pos = self->begin + self->count - 1UL;
+
+  if (self->count == 0UL)
+  {
+    return (-1);
+  }
+
+  if (data != NULL)
+  {
+    memcpy(data, deque_slot(self, pos), self->size);
+  }
+
+  self->count--;
+
+  if (self->count == 0UL || ((pos - 1UL) >> self->shift) != (pos >> self->shift))
+  {
+    deque_block_release(self, pos);
+  }
+
+  return 0;
+}
+
+void *deque_at(const deque_t *self, const size_t index)
+{
+  if (index >= self->count)
+  {
+    return NULL;
+  }
+
+  return deque_slot(self, self->begin + index);
+}
+
+size_t deque_size(const deque_t *self)
 {
-  return (uint8_t *)self->data;
+  return self->count;
 }
@@ -38,17 +38,21 @@ public:
     return ring_buffer_enqueue(__buffer, &data, sizeof(T));
   }
 
-  void *dequeue(void)
+  int dequeue(T& data)
   {
-    return ring_buffer_dequeue(__buffer, sizeof(T));
+    return ring_buffer_dequeue_into(__buffer, &data, sizeof(T));
   }
-};
 
-void cleanup(void *pointer)
-{
-  free(pointer);
-  pointer = NULL;
-}
+  const T *peek(void)
+  {
+    return static_cast<const T *>(ring_buffer_peek(__buffer, sizeof(T)));
+  }
+
+  void pop(void)
+  {
+    ring_buffer_release(__buffer, sizeof(T));
+  }
+};
 
 int main(void)
 {
@@ -75,11 +79,17 @@ int main(void)
     std::cerr << __func__ << "(): Could not enqueue item into queue" << std::endl;
   }
 
-  int *data = nullptr;
-  while (NULL != (data = (int *)queue.dequeue()))
+  const int *front = queue.peek();
+  if (front != nullptr)
+  {
+    std::cout << *front << std::endl;
+    queue.pop();
+  }
+
+  int data = 0;
+  while (0 == queue.dequeue(data))
   {
-    std::cout << *(int *)data << std::endl;
-    cleanup(data);
+    std::cout << data << std::endl;
   }
 
   return 0;
@@ -13,11 +13,11 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include "bitmap.h"
 #include "graph.h"
 #include "map.h"
 #include "deque.h"
 #include "set.h"
-#include "stack.h"
 
 #include <stdbool.h>
 #include <stddef.h>
@@ -25,13 +25,6 @@
 #include <stdio.h>
 #include <stdlib.h>
 
-struct graph_edge
-{
-  graph_node_t *dest;
-};
-
-typedef struct graph_edge graph_edge_t;
-
 graph_edge_t *graph_edge_create(const graph_node_t *dest)
 {
   graph_edge_t *self = NULL;
@@ -58,14 +51,7 @@ void graph_edge_destroy(graph_edge_t *self)
   }
 }
 
-struct graph_node
-{
-  void *data;
-  size_t size;
-  set_t *edges;
-};
-
-graph_node_t *graph_node_create(const void *data, const size_t size, const size_t max_edges)
+graph_node_t *graph_node_create(const void *data, const size_t size, const uint32_t id, const size_t max_edges)
 {
   graph_node_t *self = NULL;
 
@@ -78,6 +64,7 @@ graph_node_t *graph_node_create(const void *data, const size_t size, const size_
 
   self->data = (void *)data;
   self->size = size;
+  self->id = id;
   self->edges = set_new(max_edges);
 
   return self;
@@ -92,12 +79,10 @@ void graph_node_destroy(graph_node_t *self)
     size_t num_edges = 0UL;
 
     edges = set_getall(self->edges, &num_edges);
-    if (edges == NULL)
-    {
-      return;
-    }
+    /* set_getall reports the size of the list in bytes */
+    num_edges /= sizeof(*edges);
 
-    for (uint64_t i = 0UL; i < num_edges; i++)
+    for (uint64_t i = 0UL; edges != NULL && i < num_edges; i++)
     {
       edge = edges[i];
 
@@ -109,6 +94,8 @@ void graph_node_destroy(graph_node_t *self)
       graph_edge_destroy(edge);
     }
 
+    free(edges);
+
     set_destroy(self->edges);
     self->edges = NULL;
 
@@ -138,6 +125,7 @@ graph_t *graph_create(const size_t max_nodes)
   }
 
   self->nodes = map_new(max_nodes);
+  self->index = deque_create(sizeof(graph_node_t *));
 
   return self;
 }
@@ -146,32 +134,16 @@ void graph_destroy(graph_t *self)
 {
   if (self != NULL)
   {
-    // graph_node_t *node = NULL;
-    // void *tmp = NULL;
+    graph_node_t **node = NULL;
 
-    // for (uint64_t i = 0UL; i < self->nodes->size; i++)
-    // {
-    //   if (self->nodes->buckets[i] == NULL)
-    //   {
-    //     continue;
-    //   }
-
-    //   tmp = bucket_data(self->nodes->buckets[i]);
-    //   if (tmp == NULL)
-    //   {
-    //     continue;
-    //   }
-
-    //   node = *(graph_node_t **)tmp;
-    //   free(tmp);
-
-    //   if (node == NULL)
-    //   {
-    //     continue;
-    //   }
+    for (uint64_t i = 0UL; i < self->num_nodes; i++)
+    {
+      node = deque_at(self->index, i);
+      graph_node_destroy(*node);
+    }
 
-    //   graph_node_destroy(node);
-    // }
+    deque_destroy(self->index);
+    self->index = NULL;
 
     map_destroy(self->nodes);
     self->nodes = NULL;
@@ -184,19 +156,23 @@ void graph_destroy(graph_t *self)
 void graph_bfs(graph_t *self, const void *start_data, const size_t size)
 {
   graph_node_t *node = NULL;
+  uintptr_t *addr = NULL;
 
-  node = map_get(self->nodes, start_data, size, NULL);
-  if (node == NULL)
+  addr = map_get(self->nodes, start_data, size, NULL);
+  if (addr == NULL)
   {
     fprintf(stderr, "%s(): %s\n", __func__, "The start node does not exist in the graph");
     exit(EXIT_FAILURE);
   }
 
-  set_t *visited = NULL;
+  node = (graph_node_t *)*addr;
+  free(addr);
+
+  bitmap_t *visited = NULL;
   ring_buffer_t *queue = NULL;
 
-  visited = set_new(32UL);
-  queue = ring_buffer_create(32UL);
+  visited = bitmap_new();
+  queue = ring_buffer_create_growable(32UL);
 
   if (0 > ring_buffer_enqueue(queue, &node, sizeof(node)))
   {
@@ -204,7 +180,6 @@ void graph_bfs(graph_t *self, const void *start_data, const size_t size)
     exit(EXIT_FAILURE);
   }
 
-  uintptr_t *addr = NULL;
   graph_edge_t **edges = NULL;
   graph_edge_t *edge = NULL;
   graph_node_t *dest = NULL;
@@ -213,31 +188,34 @@ void graph_bfs(graph_t *self, const void *start_data, const size_t size)
 
   while (true)
   {
-    addr = ring_buffer_dequeue(queue, sizeof(node));
-    if (addr == NULL)
+    if (0 > ring_buffer_dequeue_into(queue, &node, sizeof(node)))
     {
       break;
     }
 
-    node = *(graph_node_t **)addr;
     if (node == NULL)
     {
       break;
     }
 
-    if (1 == set_exists(visited, &node, sizeof(node)))
+    if (1 == bitmap_contains(visited, node->id))
     {
       continue;
     }
 
+    bitmap_add(visited, node->id);
+
     num_edges = 0UL;
     edges = set_getall(node->edges, &num_edges);
+    /* a node without edges has an empty list */
     if (edges == NULL)
     {
-      fprintf(stderr, "%s(): %s\n", __func__, "Could not get an edge list from node");
-      exit(EXIT_FAILURE);
+      continue;
     }
 
+    /* set_getall reports the size of the list in bytes */
+    num_edges /= sizeof(*edges);
+
     for (i = 0UL; i < num_edges; i++)
     {
       edge = edges[i];
@@ -249,7 +227,7 @@ void graph_bfs(graph_t *self, const void *start_data, const size_t size)
 
       dest = edge->dest;
 
-      if (1 == set_exists(visited, &dest, sizeof(dest)))
+      if (1 == bitmap_contains(visited, dest->id))
       {
         continue;
       }
@@ -260,36 +238,41 @@ void graph_bfs(graph_t *self, const void *start_data, const size_t size)
         exit(EXIT_FAILURE);
       }
     }
+
+    free(edges);
   }
 
   ring_buffer_destroy(queue);
-  set_destroy(visited);
+  bitmap_destroy(visited);
 }
 
 void graph_dfs(graph_t *self, const void *start_data, const size_t size)
 {
   graph_node_t *node = NULL;
+  uintptr_t *addr = NULL;
 
-  node = map_get(self->nodes, start_data, size, NULL);
-  if (node == NULL)
+  addr = map_get(self->nodes, start_data, size, NULL);
+  if (addr == NULL)
   {
     fprintf(stderr, "%s(): %s\n", __func__, "The start node does not exist in the graph");
     exit(EXIT_FAILURE);
   }
 
-  set_t *visited = NULL;
-  stack_t *stack = NULL;
+  node = (graph_node_t *)*addr;
+  free(addr);
 
-  visited = set_new(32UL);
-  stack = stack_create(32UL);
+  bitmap_t *visited = NULL;
+  deque_t *stack = NULL;
 
-  if (0 > stack_push(stack, &node, sizeof(node)))
+  visited = bitmap_new();
+  stack = deque_create(sizeof(node));
+
+  if (0 > deque_push_back(stack, &node))
   {
     fprintf(stderr, "%s(): %s\n", __func__, "Could not push start node onto node stack");
     exit(EXIT_FAILURE);
   }
 
-  uintptr_t *addr = NULL;
   graph_edge_t **edges = NULL;
   graph_edge_t *edge = NULL;
   graph_node_t *dest = NULL;
@@ -298,31 +281,34 @@ void graph_dfs(graph_t *self, const void *start_data, const size_t size)
 
   while (true)
   {
-    addr = stack_pop(stack, sizeof(node));
-    if (addr == NULL)
+    if (0 > deque_pop_back(stack, &node))
     {
       break;
     }
 
-    node = *(graph_node_t **)addr;
     if (node == NULL)
     {
       break;
     }
 
-    if (1 == set_exists(visited, &node, sizeof(node)))
+    if (1 == bitmap_contains(visited, node->id))
     {
       continue;
     }
 
+    bitmap_add(visited, node->id);
+
     num_edges = 0UL;
     edges = set_getall(node->edges, &num_edges);
+    /* a node without edges has an empty list */
     if (edges == NULL)
     {
-      fprintf(stderr, "%s(): %s\n", __func__, "Could not get an edge list from node");
-      exit(EXIT_FAILURE);
+      continue;
     }
 
+    /* set_getall reports the size of the list in bytes */
+    num_edges /= sizeof(*edges);
+
     for (i = 0UL; i < num_edges; i++)
     {
       edge = edges[i];
@@ -334,21 +320,23 @@ void graph_dfs(graph_t *self, const void *start_data, const size_t size)
 
       dest = edge->dest;
 
-      if (1 == set_exists(visited, &dest, sizeof(dest)))
+      if (1 == bitmap_contains(visited, dest->id))
       {
         continue;
       }
 
-      if (0 > stack_push(stack, &dest, sizeof(dest)))
+      if (0 > deque_push_back(stack, &dest))
       {
         fprintf(stderr, "%s(): %s\n", __func__, "Could not push destination node onto node stack");
         exit(EXIT_FAILURE);
       }
     }
+
+    free(edges);
   }
 
-  stack_destroy(stack);
-  set_destroy(visited);
+  deque_destroy(stack);
+  bitmap_destroy(visited);
 }
 
 static graph_node_t *graph_add_node(graph_t *self, const void *data, const size_t size)
@@ -360,7 +348,13 @@ static graph_node_t *graph_add_node(graph_t *self, const void *data, const size_
 
   if (addr == NULL)
   {
-    node = graph_node_create(data, size, 16);
+    node = graph_node_create(data, size, self->num_nodes++, 16);
+
+    if (0 > deque_push_back(self->index, &node))
+    {
+      fprintf(stderr, "%s(): %s\n", __func__, "Could not append node to the node index");
+      exit(EXIT_FAILURE);
+    }
 
     if (0 > map_set(self->nodes, data, size, &node, sizeof(node)))
     {
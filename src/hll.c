@@ -0,0 +1,358 @@
+/*
+ * Copyright (C) 2025 Da'Jour J. Christophe. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "internal/hash.h"
+#include "common.h"
+#include "hll.h"
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HLL_MIN_PRECISION 4U
+#define HLL_MAX_PRECISION 18U
+#define HLL_BATCH         256UL
+
+/*
+ * Sparse entries pack the register index above an 8-bit rank and are
+ * kept sorted by index. registers is NULL until the sketch goes dense.
+ */
+struct hll
+{
+  uint32_t  precision;
+  uint32_t *sparse;
+  size_t    sparse_size;
+  size_t    sparse_cap;
+  uint8_t  *registers;
+};
+
+hll_t *hll_new(const unsigned int precision)
+{
+  hll_t *self = NULL;
+
+  if (precision < HLL_MIN_PRECISION || precision > HLL_MAX_PRECISION)
+  {
+    return NULL;
+  }
+
+  self = (hll_t *)calloc(1UL, sizeof(*self));
+  if (self == NULL)
+  {
+    fprintf(stderr, "%s(): %s\n", __func__, "could not allocate hyperloglog to the heap");
+    exit(EXIT_FAILURE);
+  }
+
+  self->precision = precision;
+  self->sparse_cap = 16UL;
+
+  self->sparse = (uint32_t *)calloc(self->sparse_cap, sizeof(*self->sparse));
+  if (self->sparse == NULL)
+  {
+    fprintf(stderr, "%s(): %s\n", __func__, "could not allocate hyperloglog.sparse to the heap");
+    exit(EXIT_FAILURE);
+  }
+
+  return self;
+}
+
+void hll_destroy(hll_t *self)
+{
+  if (self != NULL)
+  {
+    if (self->sparse != NULL)
+    {
+      free(self->sparse);
+      self->sparse = NULL;
+    }
+
+    if (self->registers != NULL)
+    {
+      free(self->registers);
+      self->registers = NULL;
+    }
+
+    free(self);
+    self = NULL;
+  }
+}
+
+static inline uint32_t always_inline hll_index(const uint64_t hash, const uint32_t precision)
+{
+  return (uint32_t)(hash >> (64U - precision));
+}
+
+/*
+ * Position of the first set bit after the index bits. The guard bit caps
+ * the rank at 64 - precision + 1 and keeps clz defined.
+ */
+static inline uint8_t always_inline hll_rank(const uint64_t hash, const uint32_t precision)
+{
+  const uint64_t bits = (hash << precision) | (1ULL << (precision - 1U));
+
+  return (uint8_t)(__builtin_clzll(bits) + 1);
+}
+
+static void hll_densify(hll_t *self)
+{
+  const size_t m = 1UL << self->precision;
+  size_t i;
+
+  self->registers = (uint8_t *)calloc(m, sizeof(*self->registers));
+  if (self->registers == NULL)
+  {
+    fprintf(stderr, "%s(): %s\n", __func__, "could not allocate hyperloglog.registers to the heap");
+    exit(EXIT_FAILURE);
+  }
+
+  for (i = 0UL; i < self->sparse_size; i++)
+  {
+    self->registers[self->sparse[i] >> 8] = (uint8_t)self->sparse[i];
+  }
+
+  free(self->sparse);
+  self->sparse = NULL;
+  self->sparse_size = 0UL;
+  self->sparse_cap = 0UL;
+}
+
+static void hll_sparse_set(hll_t *self, const uint32_t index, const uint8_t rank)
+{
+  size_t lo = 0UL;
+  size_t hi = self->sparse_size;
+
+  while (lo < hi)
+  {
+    const size_t mid = lo + ((hi - lo) >> 1);
+
+    if ((self->sparse[mid] >> 8) < index)
+    {
+      lo = mid + 1UL;
+    }
+    else
+    {
+      hi = mid;
+    }
+  }
+
+  if (lo < self->sparse_size && (self->sparse[lo] >> 8) == index)
+  {
+    if ((uint8_t)self->sparse[lo] < rank)
+    {
+      self->sparse[lo] = (index << 8) | rank;
+    }
+
+    return;
+  }
+
+  if (self->sparse_size * sizeof(*self->sparse) >= (1UL << self->precision))
+  {
+    hll_densify(self);
+
+    if (self->registers[index] < rank)
+    {
+      self->registers[index] = rank;
+    }
+
+    return;
+  }
+
+  if (self->sparse_size == self->sparse_cap)
+  {
+    uint32_t *old = self->sparse;
+
+    self->sparse_cap *= 2UL;
+    self->sparse = (uint32_t *)realloc(old, self->sparse_cap * sizeof(*self->sparse));
+    if (self->sparse == NULL)
+    {
+      fprintf(stderr, "%s(): %s\n", __func__, "could not reallocate hyperloglog.sparse to the heap");
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  memmove(self->sparse + lo + 1UL, self->sparse + lo, (self->sparse_size - lo) * sizeof(*self->sparse));
+  self->sparse[lo] = (index << 8) | rank;
+  self->sparse_size++;
+}
+
+void hll_add_hash(hll_t *self, const uint64_t hash)
+{
+  const uint32_t index = hll_index(hash, self->precision);
+  const uint8_t rank = hll_rank(hash, self->precision);
+
+  if (self->registers == NULL)
+  {
+    hll_sparse_set(self, index, rank);
+    return;
+  }
+
+  if (self->registers[index] < rank)
+  {
+    self->registers[index] = rank;
+  }
+}
+
+/*
+ * Dense updates run in two passes: index and rank for a whole block
+ * first, which vectorizes, then the scattered register maxima.
+ */
+void hll_add_hashes(hll_t *self, const uint64_t *hashes, const size_t n)
+{
+  uint32_t index[HLL_BATCH];
+  uint8_t rank[HLL_BATCH];
+  size_t i = 0UL;
+  size_t j;
+
+  while (i < n && self->registers == NULL)
+  {
+    hll_add_hash(self, hashes[i++]);
+  }
+
+  while (i < n)
+  {
+    const size_t count = n - i < HLL_BATCH ? n - i : HLL_BATCH;
+
+    for (j = 0UL; j < count; j++)
+    {
+      index[j] = hll_index(hashes[i + j], self->precision);
+      rank[j] = hll_rank(hashes[i + j], self->precision);
+    }
+
+    for (j = 0UL; j < count; j++)
+    {
+      if (self->registers[index[j]] < rank[j])
+      {
+        self->registers[index[j]] = rank[j];
+      }
+    }
+
+    i += count;
+  }
+}
+
+#define SEED 2
+
+void hll_add(hll_t *self, const void *key, const size_t keylen)
+{
+  hll_add_hash(self, __hash__(key, keylen, SEED));
+}
+
+uint64_t hll_count(const hll_t *self)
+{
+  const size_t m = 1UL << self->precision;
+  uint64_t histogram[64] = {0};
+  double sum = 0.0;
+  double alpha;
+  size_t i;
+
+  if (self->registers != NULL)
+  {
+    for (i = 0UL; i < m; i++)
+    {
+      histogram[self->registers[i]]++;
+    }
+  }
+  else
+  {
+    histogram[0] = m - self->sparse_size;
+
+    for (i = 0UL; i < self->sparse_size; i++)
+    {
+      histogram[(uint8_t)self->sparse[i]]++;
+    }
+  }
+
+  for (i = 0UL; i < 64UL; i++)
+  {
+    sum += ldexp((double)histogram[i], -(int)i);
+  }
+
+  switch (m)
+  {
+    case 16UL: alpha = 0.673; break;
+    case 32UL: alpha = 0.697; break;
+    case 64UL: alpha = 0.709; break;
+    default:   alpha = 0.7213 / (1.0 + 1.079 / (double)m); break;
+  }
+
+  double estimate = alpha * (double)m * (double)m / sum;
+
+  if (estimate <= 2.5 * (double)m && histogram[0] > 0UL)
+  {
+    estimate = (double)m * log((double)m / (double)histogram[0]);
+  }
+
+  return (uint64_t)(estimate + 0.5);
+}
+
+int hll_merge(hll_t *self, const hll_t *other)
+{
+  const size_t m = 1UL << self->precision;
+  size_t i;
+
+  if (self->precision != other->precision)
+  {
+    return (-1);
+  }
+
+  if (other->registers == NULL)
+  {
+    for (i = 0UL; i < other->sparse_size; i++)
+    {
+      const uint32_t index = other->sparse[i] >> 8;
+      const uint8_t rank = (uint8_t)other->sparse[i];
+
+      if (self->registers == NULL)
+      {
+        hll_sparse_set(self, index, rank);
+      }
+      else if (self->registers[index] < rank)
+      {
+        self->registers[index] = rank;
+      }
+    }
+
+    return 0;
+  }
+
+  if (self->registers == NULL)
+  {
+    hll_densify(self);
+  }
+
+  for (i = 0UL; i < m; i++)
+  {
+    self->registers[i] = self->registers[i] > other->registers[i] ? self->registers[i] : other->registers[i];
+  }
+
+  return 0;
+}
+
+int hll_is_sparse(const hll_t *self)
+{
+  return self->registers == NULL;
+}
+
+size_t hll_memory(const hll_t *self)
+{
+  if (self->registers != NULL)
+  {
+    return sizeof(*self) + (1UL << self->precision);
+  }
+
+  return sizeof(*self) + self->sparse_cap * sizeof(*self->sparse);
+}
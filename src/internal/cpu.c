@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2025 Da'Jour J. Christophe. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "internal/cpu.h"
+
+unsigned int cpu_features = 0U;
+
+unsigned int cpu_detect(void)
+{
+  unsigned int features = 0U;
+
+#if defined(CPU_X86)
+  __builtin_cpu_init();
+
+  if (__builtin_cpu_supports("sse2"))
+  {
+    features |= CPU_SSE2;
+  }
+
+  if (__builtin_cpu_supports("ssse3"))
+  {
+    features |= CPU_SSSE3;
+  }
+
+  if (__builtin_cpu_supports("popcnt"))
+  {
+    features |= CPU_POPCNT;
+  }
+
+  if (__builtin_cpu_supports("avx2"))
+  {
+    features |= CPU_AVX2;
+  }
+
+  if (__builtin_cpu_supports("bmi2"))
+  {
+    features |= CPU_BMI2;
+  }
+
+  if (__builtin_cpu_supports("sse4.2"))
+  {
+    features |= CPU_SSE42;
+  }
+
+  if (__builtin_cpu_supports("aes"))
+  {
+    features |= CPU_AES;
+  }
+
+  if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq"))
+  {
+    features |= CPU_AVX512;
+  }
+#endif
+
+  return features;
+}
+
+static void __attribute__ ((constructor)) cpu_init(void)
+{
+  cpu_features = cpu_detect();
+}
+
+void cpu_restrict(const unsigned int mask)
+{
+  cpu_features = cpu_detect() & mask;
+}
@@ -21,136 +21,1101 @@
 //
 // BSD 2-Clause License (https://www.opensource.org/licenses/bsd-license.php)
 //
-// xxHash3
+// xxHash3 (XXH3-64, XXH3-128)
 //-----------------------------------------------------------------------------
+#include "internal/cpu.h"
+#include "internal/hash.h"
+#include "common.h"
+
 #include <stddef.h>
 #include <stdint.h>
 #include <string.h>
 
-#define XXH_PRIME_1 11400714785074694791ULL
-#define XXH_PRIME_2 14029467366897019727ULL
-#define XXH_PRIME_3 1609587929392839161ULL
-#define XXH_PRIME_4 9650029242287828579ULL
-#define XXH_PRIME_5 2870177450012600261ULL
+#if defined(CPU_X86)
+#include <immintrin.h>
+#endif
+
+#define XXH_PRIME32_1 0x9E3779B1U
+#define XXH_PRIME32_2 0x85EBCA77U
+#define XXH_PRIME32_3 0xC2B2AE3DU
+
+#define XXH_PRIME64_1 0x9E3779B185EBCA87ULL
+#define XXH_PRIME64_2 0xC2B2AE3D27D4EB4FULL
+#define XXH_PRIME64_3 0x165667B19E3779F9ULL
+#define XXH_PRIME64_4 0x85EBCA77C2B2AE63ULL
+#define XXH_PRIME64_5 0x27D4EB2F165667C5ULL
+
+#define XXH_PRIME_MX1 0x165667919E3779F9ULL
+#define XXH_PRIME_MX2 0x9FB21C651E98DF25ULL
 
-static uint64_t XXH_read64(const void *memptr)
+#define XXH_SECRET_SIZE     192UL
+#define XXH_SECRET_SIZE_MIN 136UL
+#define XXH_STRIPE_LEN      64UL
+#define XXH_SECRET_CONSUME  8UL
+#define XXH_ACC_NB          8UL
+#define XXH_MIDSIZE_MAX     240UL
+
+static const uint8_t XXH_kSecret[XXH_SECRET_SIZE] __attribute__ ((aligned(64))) = {
+  0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+  0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+  0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+  0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+  0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+  0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+  0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+  0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+  0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+  0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+  0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+  0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+};
+
+static inline uint64_t XXH_read64(const void *memptr)
 {
   uint64_t val;
   memcpy(&val, memptr, sizeof(val));
   return val;
 }
 
-static uint32_t XXH_read32(const void *memptr)
+static inline uint32_t XXH_read32(const void *memptr)
 {
   uint32_t val;
   memcpy(&val, memptr, sizeof(val));
   return val;
 }
 
-static uint64_t XXH_rotl64(uint64_t x, int r)
+static inline void XXH_write64(void *memptr, const uint64_t val)
+{
+  memcpy(memptr, &val, sizeof(val));
+}
+
+static inline uint64_t XXH_rotl64(const uint64_t x, const int r)
 {
   return (x << r) | (x >> (64 - r));
 }
 
+static inline uint64_t XXH_mult128_fold64(const uint64_t lhs, const uint64_t rhs)
+{
+#if defined(__SIZEOF_INT128__)
+  const __uint128_t product = (__uint128_t)lhs * rhs;
+
+  return (uint64_t)product ^ (uint64_t)(product >> 64);
+#else
+  const uint64_t lo_lo = (lhs & 0xFFFFFFFFULL) * (rhs & 0xFFFFFFFFULL);
+  const uint64_t hi_lo = (lhs >> 32) * (rhs & 0xFFFFFFFFULL);
+  const uint64_t lo_hi = (lhs & 0xFFFFFFFFULL) * (rhs >> 32);
+  const uint64_t hi_hi = (lhs >> 32) * (rhs >> 32);
+  const uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xFFFFFFFFULL) + lo_hi;
+  const uint64_t upper = (hi_lo >> 32) + (cross >> 32) + hi_hi;
+  const uint64_t lower = (cross << 32) | (lo_lo & 0xFFFFFFFFULL);
+
+  return lower ^ upper;
+#endif
+}
+
+static inline uint64_t XXH64_avalanche(uint64_t h64)
+{
+  h64 ^= h64 >> 33;
+  h64 *= XXH_PRIME64_2;
+  h64 ^= h64 >> 29;
+  h64 *= XXH_PRIME64_3;
+  h64 ^= h64 >> 32;
+  return h64;
+}
+
+static inline uint64_t XXH3_avalanche(uint64_t h64)
+{
+  h64 ^= h64 >> 37;
+  h64 *= XXH_PRIME_MX1;
+  h64 ^= h64 >> 32;
+  return h64;
+}
+
+static inline uint64_t XXH3_rrmxmx(uint64_t h64, const uint64_t len)
+{
+  h64 ^= XXH_rotl64(h64, 49) ^ XXH_rotl64(h64, 24);
+  h64 *= XXH_PRIME_MX2;
+  h64 ^= (h64 >> 35) + len;
+  h64 *= XXH_PRIME_MX2;
+  h64 ^= h64 >> 28;
+  return h64;
+}
+
+//-----------------------------------------------------------------------------
+// Short inputs: 0-16 bytes are a handful of loads, a multiply and a mix.
+//-----------------------------------------------------------------------------
+static inline uint64_t XXH3_len_1to3(const uint8_t *p, const size_t len, const uint8_t *secret, const uint64_t seed)
+{
+  const uint32_t combined = ((uint32_t)p[0] << 16) | ((uint32_t)p[len >> 1] << 24)
+                          | ((uint32_t)p[len - 1]) | ((uint32_t)len << 8);
+  const uint64_t bitflip = (XXH_read32(secret) ^ XXH_read32(secret + 4)) + seed;
+
+  return XXH64_avalanche((uint64_t)combined ^ bitflip);
+}
+
+static inline uint64_t XXH3_len_4to8(const uint8_t *p, const size_t len, const uint8_t *secret, uint64_t seed)
+{
+  seed ^= (uint64_t)__builtin_bswap32((uint32_t)seed) << 32;
+
+  const uint64_t bitflip = (XXH_read64(secret + 8) ^ XXH_read64(secret + 16)) - seed;
+  const uint64_t input = XXH_read32(p + len - 4) + ((uint64_t)XXH_read32(p) << 32);
+
+  return XXH3_rrmxmx(input ^ bitflip, len);
+}
+
+static inline uint64_t XXH3_len_9to16(const uint8_t *p, const size_t len, const uint8_t *secret, const uint64_t seed)
+{
+  const uint64_t bitflip1 = (XXH_read64(secret + 24) ^ XXH_read64(secret + 32)) + seed;
+  const uint64_t bitflip2 = (XXH_read64(secret + 40) ^ XXH_read64(secret + 48)) - seed;
+  const uint64_t lo = XXH_read64(p) ^ bitflip1;
+  const uint64_t hi = XXH_read64(p + len - 8) ^ bitflip2;
+  const uint64_t acc = len + __builtin_bswap64(lo) + hi + XXH_mult128_fold64(lo, hi);
+
+  return XXH3_avalanche(acc);
+}
+
+static inline uint64_t XXH3_len_0to16(const uint8_t *p, const size_t len, const uint8_t *secret, const uint64_t seed)
+{
+  if (len > 8)
+  {
+    return XXH3_len_9to16(p, len, secret, seed);
+  }
+
+  if (len >= 4)
+  {
+    return XXH3_len_4to8(p, len, secret, seed);
+  }
+
+  if (len > 0)
+  {
+    return XXH3_len_1to3(p, len, secret, seed);
+  }
+
+  return XXH64_avalanche(seed ^ (XXH_read64(secret + 56) ^ XXH_read64(secret + 64)));
+}
+
+static inline uint64_t XXH3_mix16B(const uint8_t *p, const uint8_t *secret, const uint64_t seed)
+{
+  return XXH_mult128_fold64(XXH_read64(p) ^ (XXH_read64(secret) + seed),
+                            XXH_read64(p + 8) ^ (XXH_read64(secret + 8) - seed));
+}
+
+static inline uint64_t XXH3_len_17to128(const uint8_t *p, const size_t len, const uint8_t *secret, const uint64_t seed)
+{
+  uint64_t acc = len * XXH_PRIME64_1;
+
+  if (len > 32)
+  {
+    if (len > 64)
+    {
+      if (len > 96)
+      {
+        acc += XXH3_mix16B(p + 48, secret + 96, seed);
+        acc += XXH3_mix16B(p + len - 64, secret + 112, seed);
+      }
+
+      acc += XXH3_mix16B(p + 32, secret + 64, seed);
+      acc += XXH3_mix16B(p + len - 48, secret + 80, seed);
+    }
+
+    acc += XXH3_mix16B(p + 16, secret + 32, seed);
+    acc += XXH3_mix16B(p + len - 32, secret + 48, seed);
+  }
+
+  acc += XXH3_mix16B(p, secret, seed);
+  acc += XXH3_mix16B(p + len - 16, secret + 16, seed);
+
+  return XXH3_avalanche(acc);
+}
+
+static uint64_t XXH3_len_129to240(const uint8_t *p, const size_t len, const uint8_t *secret, const uint64_t seed)
+{
+  const size_t rounds = len / 16;
+  uint64_t acc = len * XXH_PRIME64_1;
+  size_t i;
+
+  for (i = 0; i < 8; i++)
+  {
+    acc += XXH3_mix16B(p + 16 * i, secret + 16 * i, seed);
+  }
+
+  acc = XXH3_avalanche(acc);
+
+  for (i = 8; i < rounds; i++)
+  {
+    acc += XXH3_mix16B(p + 16 * i, secret + 16 * (i - 8) + 3, seed);
+  }
+
+  acc += XXH3_mix16B(p + len - 16, secret + XXH_SECRET_SIZE_MIN - 17, seed);
+
+  return XXH3_avalanche(acc);
+}
+
+//-----------------------------------------------------------------------------
+// Long inputs: eight 64-bit lanes consume 64-byte stripes, sliding 8 bytes
+// along the secret per stripe and scrambling once per 1 KiB block. The
+// accumulate/scramble pair is the whole hot loop, so it is vectorized.
+// The accumulators may sit in a caller's heap-allocated state, so they are
+// only ever loaded and stored unaligned.
+//-----------------------------------------------------------------------------
+static inline void XXH3_accumulate_512_scalar(uint64_t *restrict acc, const uint8_t *restrict p, const uint8_t *restrict secret)
+{
+  size_t i;
+
+  for (i = 0; i < XXH_ACC_NB; i++)
+  {
+    const uint64_t data = XXH_read64(p + 8 * i);
+    const uint64_t key = data ^ XXH_read64(secret + 8 * i);
+
+    acc[i ^ 1] += data;
+    acc[i] += (key & 0xFFFFFFFFULL) * (key >> 32);
+  }
+}
+
+static inline void XXH3_scramble_scalar(uint64_t *restrict acc, const uint8_t *restrict secret)
+{
+  size_t i;
+
+  for (i = 0; i < XXH_ACC_NB; i++)
+  {
+    uint64_t a = acc[i];
+
+    a ^= a >> 47;
+    a ^= XXH_read64(secret + 8 * i);
+    a *= XXH_PRIME32_1;
+    acc[i] = a;
+  }
+}
+
+#if defined(CPU_X86)
+static inline cpu_target("sse2") void XXH3_accumulate_512_sse2(uint64_t *restrict acc, const uint8_t *restrict p, const uint8_t *restrict secret)
+{
+  size_t i;
+
+  for (i = 0; i < 4; i++)
+  {
+    const __m128i data = _mm_loadu_si128((const __m128i *)(const void *)(p + 16 * i));
+    const __m128i key = _mm_xor_si128(data, _mm_loadu_si128((const __m128i *)(const void *)(secret + 16 * i)));
+    const __m128i key_lo = _mm_shuffle_epi32(key, _MM_SHUFFLE(0, 3, 0, 1));
+    const __m128i product = _mm_mul_epu32(key, key_lo);
+    const __m128i swap = _mm_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));
+    const __m128i sum = _mm_add_epi64(_mm_loadu_si128((const __m128i *)(void *)(acc + 2 * i)), swap);
+
+    _mm_storeu_si128((__m128i *)(void *)(acc + 2 * i), _mm_add_epi64(product, sum));
+  }
+}
+
+static inline cpu_target("sse2") void XXH3_scramble_sse2(uint64_t *restrict acc, const uint8_t *restrict secret)
+{
+  const __m128i prime = _mm_set1_epi32((int)XXH_PRIME32_1);
+  size_t i;
+
+  for (i = 0; i < 4; i++)
+  {
+    __m128i a = _mm_loadu_si128((const __m128i *)(void *)(acc + 2 * i));
+
+    a = _mm_xor_si128(a, _mm_srli_epi64(a, 47));
+    a = _mm_xor_si128(a, _mm_loadu_si128((const __m128i *)(const void *)(secret + 16 * i)));
+
+    const __m128i lo = _mm_mul_epu32(a, prime);
+    const __m128i hi = _mm_mul_epu32(_mm_srli_epi64(a, 32), prime);
+
+    _mm_storeu_si128((__m128i *)(void *)(acc + 2 * i), _mm_add_epi64(lo, _mm_slli_epi64(hi, 32)));
+  }
+}
+
+static inline cpu_target("avx2") void XXH3_accumulate_512_avx2(uint64_t *restrict acc, const uint8_t *restrict p, const uint8_t *restrict secret)
+{
+  size_t i;
+
+  for (i = 0; i < 2; i++)
+  {
+    const __m256i data = _mm256_loadu_si256((const __m256i *)(const void *)(p + 32 * i));
+    const __m256i key = _mm256_xor_si256(data, _mm256_loadu_si256((const __m256i *)(const void *)(secret + 32 * i)));
+    const __m256i key_lo = _mm256_shuffle_epi32(key, _MM_SHUFFLE(0, 3, 0, 1));
+    const __m256i product = _mm256_mul_epu32(key, key_lo);
+    const __m256i swap = _mm256_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));
+    const __m256i sum = _mm256_add_epi64(_mm256_loadu_si256((const __m256i *)(void *)(acc + 4 * i)), swap);
+
+    _mm256_storeu_si256((__m256i *)(void *)(acc + 4 * i), _mm256_add_epi64(product, sum));
+  }
+}
+
+static inline cpu_target("avx2") void XXH3_scramble_avx2(uint64_t *restrict acc, const uint8_t *restrict secret)
+{
+  const __m256i prime = _mm256_set1_epi32((int)XXH_PRIME32_1);
+  size_t i;
+
+  for (i = 0; i < 2; i++)
+  {
+    __m256i a = _mm256_loadu_si256((const __m256i *)(void *)(acc + 4 * i));
+
+    a = _mm256_xor_si256(a, _mm256_srli_epi64(a, 47));
+    a = _mm256_xor_si256(a, _mm256_loadu_si256((const __m256i *)(const void *)(secret + 32 * i)));
+
+    const __m256i lo = _mm256_mul_epu32(a, prime);
+    const __m256i hi = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), prime);
+
+    _mm256_storeu_si256((__m256i *)(void *)(acc + 4 * i), _mm256_add_epi64(lo, _mm256_slli_epi64(hi, 32)));
+  }
+}
+
+static inline cpu_target("avx512f") void XXH3_accumulate_512_avx512(uint64_t *restrict acc, const uint8_t *restrict p, const uint8_t *restrict secret)
+{
+  const __m512i data = _mm512_loadu_si512((const void *)p);
+  const __m512i key = _mm512_xor_si512(data, _mm512_loadu_si512((const void *)secret));
+  const __m512i key_lo = _mm512_shuffle_epi32(key, (_MM_PERM_ENUM)_MM_SHUFFLE(0, 3, 0, 1));
+  const __m512i product = _mm512_mul_epu32(key, key_lo);
+  const __m512i swap = _mm512_shuffle_epi32(data, (_MM_PERM_ENUM)_MM_SHUFFLE(1, 0, 3, 2));
+  const __m512i sum = _mm512_add_epi64(_mm512_loadu_si512((const void *)acc), swap);
+
+  _mm512_storeu_si512((void *)acc, _mm512_add_epi64(product, sum));
+}
+
+static inline cpu_target("avx512f") void XXH3_scramble_avx512(uint64_t *restrict acc, const uint8_t *restrict secret)
+{
+  const __m512i prime = _mm512_set1_epi32((int)XXH_PRIME32_1);
+  __m512i a = _mm512_loadu_si512((const void *)acc);
+
+  a = _mm512_xor_si512(a, _mm512_srli_epi64(a, 47));
+  a = _mm512_xor_si512(a, _mm512_loadu_si512((const void *)secret));
+
+  const __m512i lo = _mm512_mul_epu32(a, prime);
+  const __m512i hi = _mm512_mul_epu32(_mm512_srli_epi64(a, 32), prime);
+
+  _mm512_storeu_si512((void *)acc, _mm512_add_epi64(lo, _mm512_slli_epi64(hi, 32)));
+}
+#endif
+
+static uint64_t XXH3_merge_accs(const uint64_t *acc, const uint8_t *secret, const uint64_t start)
+{
+  uint64_t result = start;
+  size_t i;
+
+  for (i = 0; i < 4; i++)
+  {
+    result += XXH_mult128_fold64(acc[2 * i] ^ XXH_read64(secret + 16 * i),
+                                 acc[2 * i + 1] ^ XXH_read64(secret + 16 * i + 8));
+  }
+
+  return XXH3_avalanche(result);
+}
+
+static inline void XXH3_init_acc(uint64_t *acc)
+{
+  acc[0] = XXH_PRIME32_3;
+  acc[1] = XXH_PRIME64_1;
+  acc[2] = XXH_PRIME64_2;
+  acc[3] = XXH_PRIME64_3;
+  acc[4] = XXH_PRIME64_4;
+  acc[5] = XXH_PRIME32_2;
+  acc[6] = XXH_PRIME64_5;
+  acc[7] = XXH_PRIME32_1;
+}
+
+typedef void (*XXH3_accumulate_512_t)(uint64_t *restrict acc, const uint8_t *restrict p, const uint8_t *restrict secret);
+typedef void (*XXH3_scramble_t)(uint64_t *restrict acc, const uint8_t *restrict secret);
+
+/*
+ * The loops are written once and stamped out per instruction set below;
+ * with the kernels passed as constants they inline into each variant.
+ */
+static inline always_inline void XXH3_accumulate_with(uint64_t *restrict acc, const uint8_t *restrict p, const uint8_t *restrict secret,
+                                                      const size_t stripes, const XXH3_accumulate_512_t accumulate_512)
+{
+  size_t n;
+
+  for (n = 0; n < stripes; n++)
+  {
+    accumulate_512(acc, p + n * XXH_STRIPE_LEN, secret + n * XXH_SECRET_CONSUME);
+  }
+}
+
+static inline always_inline void XXH3_hash_long_with(uint64_t *restrict acc, const uint8_t *restrict p, const size_t len,
+                                                     const uint8_t *restrict secret, const XXH3_accumulate_512_t accumulate_512,
+                                                     const XXH3_scramble_t scramble)
+{
+  const size_t stripes_per_block = (XXH_SECRET_SIZE - XXH_STRIPE_LEN) / XXH_SECRET_CONSUME;
+  const size_t block_len = XXH_STRIPE_LEN * stripes_per_block;
+  const size_t blocks = (len - 1) / block_len;
+  size_t n;
+
+  XXH3_init_acc(acc);
+
+  for (n = 0; n < blocks; n++)
+  {
+    XXH3_accumulate_with(acc, p + n * block_len, secret, stripes_per_block, accumulate_512);
+    scramble(acc, secret + XXH_SECRET_SIZE - XXH_STRIPE_LEN);
+  }
+
+  const size_t stripes = ((len - 1) - block_len * blocks) / XXH_STRIPE_LEN;
+
+  XXH3_accumulate_with(acc, p + blocks * block_len, secret, stripes, accumulate_512);
+  accumulate_512(acc, p + len - XXH_STRIPE_LEN, secret + XXH_SECRET_SIZE - XXH_STRIPE_LEN - 7);
+}
+
+static void XXH3_hash_long_scalar(uint64_t *restrict acc, const uint8_t *restrict p, const size_t len, const uint8_t *restrict secret)
+{
+  XXH3_hash_long_with(acc, p, len, secret, XXH3_accumulate_512_scalar, XXH3_scramble_scalar);
+}
+
+static void XXH3_accumulate_scalar(uint64_t *restrict acc, const uint8_t *restrict p, const uint8_t *restrict secret, const size_t stripes)
+{
+  XXH3_accumulate_with(acc, p, secret, stripes, XXH3_accumulate_512_scalar);
+}
+
+#if defined(CPU_X86)
+static cpu_target("sse2") void XXH3_hash_long_sse2(uint64_t *restrict acc, const uint8_t *restrict p, const size_t len, const uint8_t *restrict secret)
+{
+  XXH3_hash_long_with(acc, p, len, secret, XXH3_accumulate_512_sse2, XXH3_scramble_sse2);
+}
+
+static cpu_target("sse2") void XXH3_accumulate_sse2(uint64_t *restrict acc, const uint8_t *restrict p, const uint8_t *restrict secret, const size_t stripes)
+{
+  XXH3_accumulate_with(acc, p, secret, stripes, XXH3_accumulate_512_sse2);
+}
+
+static cpu_target("avx2") void XXH3_hash_long_avx2(uint64_t *restrict acc, const uint8_t *restrict p, const size_t len, const uint8_t *restrict secret)
+{
+  XXH3_hash_long_with(acc, p, len, secret, XXH3_accumulate_512_avx2, XXH3_scramble_avx2);
+}
+
+static cpu_target("avx2") void XXH3_accumulate_avx2(uint64_t *restrict acc, const uint8_t *restrict p, const uint8_t *restrict secret, const size_t stripes)
+{
+  XXH3_accumulate_with(acc, p, secret, stripes, XXH3_accumulate_512_avx2);
+}
+
+static cpu_target("avx512f") void XXH3_hash_long_avx512(uint64_t *restrict acc, const uint8_t *restrict p, const size_t len, const uint8_t *restrict secret)
+{
+  XXH3_hash_long_with(acc, p, len, secret, XXH3_accumulate_512_avx512, XXH3_scramble_avx512);
+}
+
+static cpu_target("avx512f") void XXH3_accumulate_avx512(uint64_t *restrict acc, const uint8_t *restrict p, const uint8_t *restrict secret, const size_t stripes)
+{
+  XXH3_accumulate_with(acc, p, secret, stripes, XXH3_accumulate_512_avx512);
+}
+#endif
+
+static void XXH3_hash_long(uint64_t *restrict acc, const uint8_t *restrict p, const size_t len, const uint8_t *restrict secret)
+{
+#if defined(CPU_X86)
+  if (cpu_has(CPU_AVX512))
+  {
+    XXH3_hash_long_avx512(acc, p, len, secret);
+    return;
+  }
+
+  if (cpu_has(CPU_AVX2))
+  {
+    XXH3_hash_long_avx2(acc, p, len, secret);
+    return;
+  }
+
+  if (cpu_has(CPU_SSE2))
+  {
+    XXH3_hash_long_sse2(acc, p, len, secret);
+    return;
+  }
+#endif
+
+  XXH3_hash_long_scalar(acc, p, len, secret);
+}
+
+/* the streaming path works a few stripes at a time and dispatches per call */
+static void XXH3_accumulate(uint64_t *restrict acc, const uint8_t *restrict p, const uint8_t *restrict secret, const size_t stripes)
+{
+#if defined(CPU_X86)
+  if (cpu_has(CPU_AVX512))
+  {
+    XXH3_accumulate_avx512(acc, p, secret, stripes);
+    return;
+  }
+
+  if (cpu_has(CPU_AVX2))
+  {
+    XXH3_accumulate_avx2(acc, p, secret, stripes);
+    return;
+  }
+
+  if (cpu_has(CPU_SSE2))
+  {
+    XXH3_accumulate_sse2(acc, p, secret, stripes);
+    return;
+  }
+#endif
+
+  XXH3_accumulate_scalar(acc, p, secret, stripes);
+}
+
+static void XXH3_scramble(uint64_t *restrict acc, const uint8_t *restrict secret)
+{
+#if defined(CPU_X86)
+  if (cpu_has(CPU_AVX512))
+  {
+    XXH3_scramble_avx512(acc, secret);
+    return;
+  }
+
+  if (cpu_has(CPU_AVX2))
+  {
+    XXH3_scramble_avx2(acc, secret);
+    return;
+  }
+
+  if (cpu_has(CPU_SSE2))
+  {
+    XXH3_scramble_sse2(acc, secret);
+    return;
+  }
+#endif
+
+  XXH3_scramble_scalar(acc, secret);
+}
+
+/* a seeded long hash runs over a secret with the seed folded in */
+static void XXH3_init_secret(uint8_t *custom, const uint64_t seed)
+{
+  size_t i;
+
+  for (i = 0; i < XXH_SECRET_SIZE / 16; i++)
+  {
+    XXH_write64(custom + 16 * i, XXH_read64(XXH_kSecret + 16 * i) + seed);
+    XXH_write64(custom + 16 * i + 8, XXH_read64(XXH_kSecret + 16 * i + 8) - seed);
+  }
+}
+
+static const uint8_t *XXH3_secret(uint8_t *custom, const uint64_t seed)
+{
+  if (seed == 0)
+  {
+    return XXH_kSecret;
+  }
+
+  XXH3_init_secret(custom, seed);
+
+  return custom;
+}
+
 uint64_t xxh3(const void *data, size_t len, uint64_t seed)
 {
   const uint8_t *p = (const uint8_t *)data;
-  const uint8_t * const end = p + len;
-  uint64_t h64;
 
-  if (len >= 32)
+  if (len <= 16)
   {
-    const uint8_t * const limit = end - 32;
-    uint64_t v1 = seed + XXH_PRIME_1 + XXH_PRIME_2;
-    uint64_t v2 = seed + XXH_PRIME_2;
-    uint64_t v3 = seed + 0;
-    uint64_t v4 = seed - XXH_PRIME_1;
+    return XXH3_len_0to16(p, len, XXH_kSecret, seed);
+  }
 
-    do
+  if (len <= 128)
+  {
+    return XXH3_len_17to128(p, len, XXH_kSecret, seed);
+  }
+
+  if (len <= XXH_MIDSIZE_MAX)
+  {
+    return XXH3_len_129to240(p, len, XXH_kSecret, seed);
+  }
+
+  uint64_t acc[XXH_ACC_NB] __attribute__ ((aligned(64)));
+  uint8_t custom[XXH_SECRET_SIZE] __attribute__ ((aligned(64)));
+  const uint8_t *secret = XXH3_secret(custom, seed);
+
+  XXH3_hash_long(acc, p, len, secret);
+
+  return XXH3_merge_accs(acc, secret + 11, (uint64_t)len * XXH_PRIME64_1);
+}
+
+//-----------------------------------------------------------------------------
+// XXH3-128: the same secret and stripe kernels, with both halves of each
+// 64x64 product kept and a second merge of the accumulators.
+//-----------------------------------------------------------------------------
+static inline xxh128_t XXH_mult64to128(const uint64_t lhs, const uint64_t rhs)
+{
+  xxh128_t r;
+
+#if defined(__SIZEOF_INT128__)
+  const __uint128_t product = (__uint128_t)lhs * rhs;
+
+  r.low64 = (uint64_t)product;
+  r.high64 = (uint64_t)(product >> 64);
+#else
+  const uint64_t lo_lo = (lhs & 0xFFFFFFFFULL) * (rhs & 0xFFFFFFFFULL);
+  const uint64_t hi_lo = (lhs >> 32) * (rhs & 0xFFFFFFFFULL);
+  const uint64_t lo_hi = (lhs & 0xFFFFFFFFULL) * (rhs >> 32);
+  const uint64_t hi_hi = (lhs >> 32) * (rhs >> 32);
+  const uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xFFFFFFFFULL) + lo_hi;
+
+  r.high64 = (hi_lo >> 32) + (cross >> 32) + hi_hi;
+  r.low64 = (cross << 32) | (lo_lo & 0xFFFFFFFFULL);
+#endif
+
+  return r;
+}
+
+static inline xxh128_t XXH3_128_len_1to3(const uint8_t *p, const size_t len, const uint8_t *secret, const uint64_t seed)
+{
+  const uint32_t combinedl = ((uint32_t)p[0] << 16) | ((uint32_t)p[len >> 1] << 24)
+                           | ((uint32_t)p[len - 1]) | ((uint32_t)len << 8);
+  const uint32_t swapped = __builtin_bswap32(combinedl);
+  const uint32_t combinedh = (swapped << 13) | (swapped >> 19);
+  const uint64_t bitflipl = (XXH_read32(secret) ^ XXH_read32(secret + 4)) + seed;
+  const uint64_t bitfliph = (XXH_read32(secret + 8) ^ XXH_read32(secret + 12)) - seed;
+  xxh128_t h;
+
+  h.low64 = XXH64_avalanche((uint64_t)combinedl ^ bitflipl);
+  h.high64 = XXH64_avalanche((uint64_t)combinedh ^ bitfliph);
+
+  return h;
+}
+
+static inline xxh128_t XXH3_128_len_4to8(const uint8_t *p, const size_t len, const uint8_t *secret, uint64_t seed)
+{
+  seed ^= (uint64_t)__builtin_bswap32((uint32_t)seed) << 32;
+
+  const uint64_t input = XXH_read32(p) + ((uint64_t)XXH_read32(p + len - 4) << 32);
+  const uint64_t bitflip = (XXH_read64(secret + 16) ^ XXH_read64(secret + 24)) + seed;
+  xxh128_t m = XXH_mult64to128(input ^ bitflip, XXH_PRIME64_1 + (len << 2));
+
+  m.high64 += m.low64 << 1;
+  m.low64 ^= m.high64 >> 3;
+  m.low64 ^= m.low64 >> 35;
+  m.low64 *= XXH_PRIME_MX2;
+  m.low64 ^= m.low64 >> 28;
+  m.high64 = XXH3_avalanche(m.high64);
+
+  return m;
+}
+
+static inline xxh128_t XXH3_128_len_9to16(const uint8_t *p, const size_t len, const uint8_t *secret, const uint64_t seed)
+{
+  const uint64_t bitflipl = (XXH_read64(secret + 32) ^ XXH_read64(secret + 40)) - seed;
+  const uint64_t bitfliph = (XXH_read64(secret + 48) ^ XXH_read64(secret + 56)) + seed;
+  const uint64_t lo = XXH_read64(p);
+  uint64_t hi = XXH_read64(p + len - 8);
+  xxh128_t m = XXH_mult64to128(lo ^ hi ^ bitflipl, XXH_PRIME64_1);
+  xxh128_t h;
+
+  m.low64 += (uint64_t)(len - 1) << 54;
+  hi ^= bitfliph;
+  m.high64 += hi + (hi & 0xFFFFFFFFULL) * (XXH_PRIME32_2 - 1);
+  m.low64 ^= __builtin_bswap64(m.high64);
+
+  h = XXH_mult64to128(m.low64, XXH_PRIME64_2);
+  h.high64 += m.high64 * XXH_PRIME64_2;
+  h.low64 = XXH3_avalanche(h.low64);
+  h.high64 = XXH3_avalanche(h.high64);
+
+  return h;
+}
+
+static inline xxh128_t XXH3_128_len_0to16(const uint8_t *p, const size_t len, const uint8_t *secret, const uint64_t seed)
+{
+  xxh128_t h;
+
+  if (len > 8)
+  {
+    return XXH3_128_len_9to16(p, len, secret, seed);
+  }
+
+  if (len >= 4)
+  {
+    return XXH3_128_len_4to8(p, len, secret, seed);
+  }
+
+  if (len > 0)
+  {
+    return XXH3_128_len_1to3(p, len, secret, seed);
+  }
+
+  h.low64 = XXH64_avalanche(seed ^ XXH_read64(secret + 64) ^ XXH_read64(secret + 72));
+  h.high64 = XXH64_avalanche(seed ^ XXH_read64(secret + 80) ^ XXH_read64(secret + 88));
+
+  return h;
+}
+
+static inline void XXH3_128_mix32B(xxh128_t *acc, const uint8_t *p1, const uint8_t *p2, const uint8_t *secret, const uint64_t seed)
+{
+  acc->low64 += XXH3_mix16B(p1, secret, seed);
+  acc->low64 ^= XXH_read64(p2) + XXH_read64(p2 + 8);
+  acc->high64 += XXH3_mix16B(p2, secret + 16, seed);
+  acc->high64 ^= XXH_read64(p1) + XXH_read64(p1 + 8);
+}
+
+static inline xxh128_t XXH3_128_finish(const xxh128_t acc, const size_t len, const uint64_t seed)
+{
+  xxh128_t h;
+
+  h.low64 = XXH3_avalanche(acc.low64 + acc.high64);
+  h.high64 = 0 - XXH3_avalanche(acc.low64 * XXH_PRIME64_1 + acc.high64 * XXH_PRIME64_4
+                              + ((uint64_t)len - seed) * XXH_PRIME64_2);
+
+  return h;
+}
+
+static inline xxh128_t XXH3_128_len_17to128(const uint8_t *p, const size_t len, const uint8_t *secret, const uint64_t seed)
+{
+  xxh128_t acc;
+
+  acc.low64 = len * XXH_PRIME64_1;
+  acc.high64 = 0;
+
+  if (len > 32)
+  {
+    if (len > 64)
+    {
+      if (len > 96)
+      {
+        XXH3_128_mix32B(&acc, p + 48, p + len - 64, secret + 96, seed);
+      }
+
+      XXH3_128_mix32B(&acc, p + 32, p + len - 48, secret + 64, seed);
+    }
+
+    XXH3_128_mix32B(&acc, p + 16, p + len - 32, secret + 32, seed);
+  }
+
+  XXH3_128_mix32B(&acc, p, p + len - 16, secret, seed);
+
+  return XXH3_128_finish(acc, len, seed);
+}
+
+static xxh128_t XXH3_128_len_129to240(const uint8_t *p, const size_t len, const uint8_t *secret, const uint64_t seed)
+{
+  const size_t rounds = len / 32;
+  xxh128_t acc;
+  size_t i;
+
+  acc.low64 = len * XXH_PRIME64_1;
+  acc.high64 = 0;
+
+  for (i = 0; i < 4; i++)
+  {
+    XXH3_128_mix32B(&acc, p + 32 * i, p + 32 * i + 16, secret + 32 * i, seed);
+  }
+
+  acc.low64 = XXH3_avalanche(acc.low64);
+  acc.high64 = XXH3_avalanche(acc.high64);
+
+  for (i = 4; i < rounds; i++)
+  {
+    XXH3_128_mix32B(&acc, p + 32 * i, p + 32 * i + 16, secret + 32 * (i - 4) + 3, seed);
+  }
+
+  XXH3_128_mix32B(&acc, p + len - 16, p + len - 32, secret + XXH_SECRET_SIZE_MIN - 17 - 16, 0 - seed);
+
+  return XXH3_128_finish(acc, len, seed);
+}
+
+xxh128_t xxh3_128(const void *data, size_t len, uint64_t seed)
+{
+  const uint8_t *p = (const uint8_t *)data;
+  xxh128_t h;
+
+  if (len <= 16)
+  {
+    return XXH3_128_len_0to16(p, len, XXH_kSecret, seed);
+  }
+
+  if (len <= 128)
+  {
+    return XXH3_128_len_17to128(p, len, XXH_kSecret, seed);
+  }
+
+  if (len <= XXH_MIDSIZE_MAX)
+  {
+    return XXH3_128_len_129to240(p, len, XXH_kSecret, seed);
+  }
+
+  uint64_t acc[XXH_ACC_NB] __attribute__ ((aligned(64)));
+  uint8_t custom[XXH_SECRET_SIZE] __attribute__ ((aligned(64)));
+  const uint8_t *secret = XXH3_secret(custom, seed);
+
+  XXH3_hash_long(acc, p, len, secret);
+
+  h.low64 = XXH3_merge_accs(acc, secret + 11, (uint64_t)len * XXH_PRIME64_1);
+  h.high64 = XXH3_merge_accs(acc, secret + XXH_SECRET_SIZE - XXH_STRIPE_LEN - 11, ~((uint64_t)len * XXH_PRIME64_2));
+
+  return h;
+}
+
+//-----------------------------------------------------------------------------
+// Batches: n keys of one length at a fixed stride. Keys of 4-8 bytes take
+// a single rrmxmx round each, which runs a vector of keys at a time with
+// the keys gathered straight into the lanes.
+//-----------------------------------------------------------------------------
+#if defined(CPU_X86)
+static cpu_target("avx512f,avx512dq") size_t XXH3_batch_4to8_avx512(const uint8_t *p, const size_t stride, const size_t len,
+                                                                    const size_t n, const uint64_t bitflip, uint64_t *out)
+{
+  const __m512i prime = _mm512_set1_epi64((long long)XXH_PRIME_MX2);
+  const long long k = (long long)stride;
+  const __m512i step = _mm512_set1_epi64((long long)(8 * stride));
+  const __m512i key = _mm512_set1_epi64((long long)bitflip);
+  const __m512i length = _mm512_set1_epi64((long long)len);
+  __m512i offset = _mm512_setr_epi64(0, k, 2 * k, 3 * k, 4 * k, 5 * k, 6 * k, 7 * k);
+  size_t i;
+
+  for (i = 0; i + 8 <= n; i += 8)
+  {
+    __m512i h;
+
+    if (len == 8 && stride == 8)
     {
-      v1 += XXH_read64(p) * XXH_PRIME_2;
-      v1 = XXH_rotl64(v1, 31);
-      v1 *= XXH_PRIME_1;
-
-      v2 += XXH_read64(p + 8) * XXH_PRIME_2;
-      v2 = XXH_rotl64(v2, 31);
-      v2 *= XXH_PRIME_1;
-
-      v3 += XXH_read64(p + 16) * XXH_PRIME_2;
-      v3 = XXH_rotl64(v3, 31);
-      v3 *= XXH_PRIME_1;
-
-      v4 += XXH_read64(p + 24) * XXH_PRIME_2;
-      v4 = XXH_rotl64(v4, 31);
-      v4 *= XXH_PRIME_1;
-
-      p += 32;
-    } while (p <= limit);
-
-    h64 = XXH_rotl64(v1,  1) + XXH_rotl64(v2,  7)
-        + XXH_rotl64(v3, 12) + XXH_rotl64(v4, 18);
-
-    v1 *= XXH_PRIME_2;
-    v1 = XXH_rotl64(v1, 31);
-    v1 *= XXH_PRIME_1;
-    h64 ^= v1;
-    h64 = h64 * XXH_PRIME_1 + XXH_PRIME_4;
-
-    v2 *= XXH_PRIME_2;
-    v2 = XXH_rotl64(v2, 31);
-    v2 *= XXH_PRIME_1;
-    h64 ^= v2;
-    h64 = h64 * XXH_PRIME_1 + XXH_PRIME_4;
-
-    v3 *= XXH_PRIME_2;
-    v3 = XXH_rotl64(v3, 31);
-    v3 *= XXH_PRIME_1;
-    h64 ^= v3;
-    h64 = h64 * XXH_PRIME_1 + XXH_PRIME_4;
-
-    v4 *= XXH_PRIME_2;
-    v4 = XXH_rotl64(v4, 31);
-    v4 *= XXH_PRIME_1;
-    h64 ^= v4;
-    h64 = h64 * XXH_PRIME_1 + XXH_PRIME_4;
+      /* packed 8-byte keys: one load, then swap the halves of each lane */
+      h = _mm512_shuffle_epi32(_mm512_loadu_si512((const void *)(p + 8 * i)), (_MM_PERM_ENUM)_MM_SHUFFLE(2, 3, 0, 1));
+    }
+    else
+    {
+      const __m512i lo = _mm512_cvtepu32_epi64(_mm512_i64gather_epi32(offset, (const void *)(p + len - 4), 1));
+      const __m512i hi = _mm512_cvtepu32_epi64(_mm512_i64gather_epi32(offset, (const void *)p, 1));
+
+      h = _mm512_add_epi64(lo, _mm512_slli_epi64(hi, 32));
+      offset = _mm512_add_epi64(offset, step);
+    }
+
+    h = _mm512_xor_si512(h, key);
+
+    h = _mm512_xor_si512(h, _mm512_xor_si512(_mm512_rol_epi64(h, 49), _mm512_rol_epi64(h, 24)));
+    h = _mm512_mullo_epi64(h, prime);
+    h = _mm512_xor_si512(h, _mm512_add_epi64(_mm512_srli_epi64(h, 35), length));
+    h = _mm512_mullo_epi64(h, prime);
+    h = _mm512_xor_si512(h, _mm512_srli_epi64(h, 28));
+
+    _mm512_storeu_si512((void *)(out + i), h);
+  }
+
+  return i;
+}
+
+static inline cpu_target("avx2") __m256i XXH_mul64_256(const __m256i a, const uint64_t c)
+{
+  const __m256i lo = _mm256_set1_epi64x((long long)(c & 0xFFFFFFFFULL));
+  const __m256i hi = _mm256_set1_epi64x((long long)(c >> 32));
+  const __m256i cross = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(a, 32), lo), _mm256_mul_epu32(a, hi));
+
+  return _mm256_add_epi64(_mm256_mul_epu32(a, lo), _mm256_slli_epi64(cross, 32));
+}
+
+static inline cpu_target("avx2") __m256i XXH_rotl64_256(const __m256i a, const int r)
+{
+  return _mm256_or_si256(_mm256_slli_epi64(a, r), _mm256_srli_epi64(a, 64 - r));
+}
+
+static cpu_target("avx2") size_t XXH3_batch_4to8_avx2(const uint8_t *p, const size_t stride, const size_t len,
+                                                       const size_t n, const uint64_t bitflip, uint64_t *out)
+{
+  const __m256i step = _mm256_set1_epi64x((long long)(4 * stride));
+  const __m256i key = _mm256_set1_epi64x((long long)bitflip);
+  const __m256i length = _mm256_set1_epi64x((long long)len);
+  __m256i offset = _mm256_setr_epi64x(0, (long long)stride, (long long)(2 * stride), (long long)(3 * stride));
+  size_t i;
+
+  for (i = 0; i + 4 <= n; i += 4)
+  {
+    __m256i h;
+
+    if (len == 8 && stride == 8)
+    {
+      /* packed 8-byte keys: one load, then swap the halves of each lane */
+      h = _mm256_shuffle_epi32(_mm256_loadu_si256((const __m256i *)(const void *)(p + 8 * i)), _MM_SHUFFLE(2, 3, 0, 1));
+    }
+    else
+    {
+      const __m256i lo = _mm256_cvtepu32_epi64(_mm256_i64gather_epi32((const int *)(const void *)(p + len - 4), offset, 1));
+      const __m256i hi = _mm256_cvtepu32_epi64(_mm256_i64gather_epi32((const int *)(const void *)p, offset, 1));
+
+      h = _mm256_add_epi64(lo, _mm256_slli_epi64(hi, 32));
+      offset = _mm256_add_epi64(offset, step);
+    }
+
+    h = _mm256_xor_si256(h, key);
+
+    h = _mm256_xor_si256(h, _mm256_xor_si256(XXH_rotl64_256(h, 49), XXH_rotl64_256(h, 24)));
+    h = XXH_mul64_256(h, XXH_PRIME_MX2);
+    h = _mm256_xor_si256(h, _mm256_add_epi64(_mm256_srli_epi64(h, 35), length));
+    h = XXH_mul64_256(h, XXH_PRIME_MX2);
+    h = _mm256_xor_si256(h, _mm256_srli_epi64(h, 28));
+
+    _mm256_storeu_si256((__m256i *)(void *)(out + i), h);
+  }
+
+  return i;
+}
+#endif
+
+void xxh3_batch(const void *keys, size_t stride, size_t len, size_t n, uint64_t seed, uint64_t *out)
+{
+  const uint8_t *p = (const uint8_t *)keys;
+  size_t i = 0;
+
+#if defined(CPU_X86)
+  if (len >= 4 && len <= 8)
+  {
+    const uint64_t mixed = seed ^ ((uint64_t)__builtin_bswap32((uint32_t)seed) << 32);
+    const uint64_t bitflip = (XXH_read64(XXH_kSecret + 8) ^ XXH_read64(XXH_kSecret + 16)) - mixed;
+
+    if (cpu_has(CPU_AVX512))
+    {
+      i = XXH3_batch_4to8_avx512(p, stride, len, n, bitflip, out);
+    }
+    else if (cpu_has(CPU_AVX2))
+    {
+      i = XXH3_batch_4to8_avx2(p, stride, len, n, bitflip, out);
+    }
+  }
+#endif
+
+  for (; i < n; i++)
+  {
+    out[i] = xxh3(p + i * stride, len, seed);
+  }
+}
+
+//-----------------------------------------------------------------------------
+// Streaming: whole stripes are accumulated as they arrive and the tail is
+// held back, so the digest sees exactly what the one-shot functions see.
+// The buffer must cover the 240-byte short-input range, and the stripe
+// before the tail is kept at its end for the final overlapping stripe.
+//-----------------------------------------------------------------------------
+#define XXH3_BUFFER_STRIPES (XXH3_BUFFER_SIZE / XXH_STRIPE_LEN)
+#define XXH3_STRIPES_PER_BLOCK ((XXH_SECRET_SIZE - XXH_STRIPE_LEN) / XXH_SECRET_CONSUME)
+
+void xxh3_reset(xxh3_state_t *state, uint64_t seed)
+{
+  XXH3_init_acc(state->acc);
+
+  if (seed == 0)
+  {
+    memcpy(state->secret, XXH_kSecret, XXH_SECRET_SIZE);
   }
   else
   {
-    h64 = seed + XXH_PRIME_5;
+    XXH3_init_secret(state->secret, seed);
   }
 
-  h64 += (uint64_t)len;
+  state->seed = seed;
+  state->total_len = 0;
+  state->buffered = 0;
+  state->stripes = 0;
+}
+
+static void XXH3_consume_stripes(uint64_t *restrict acc, size_t *stripes_so_far, const uint8_t *restrict p,
+                                 const size_t stripes, const uint8_t *restrict secret)
+{
+  if (XXH3_STRIPES_PER_BLOCK - *stripes_so_far <= stripes)
+  {
+    const size_t to_end = XXH3_STRIPES_PER_BLOCK - *stripes_so_far;
+    const size_t after_end = stripes - to_end;
 
-  while (p + 8 <= end)
+    XXH3_accumulate(acc, p, secret + *stripes_so_far * XXH_SECRET_CONSUME, to_end);
+    XXH3_scramble(acc, secret + XXH_SECRET_SIZE - XXH_STRIPE_LEN);
+    XXH3_accumulate(acc, p + to_end * XXH_STRIPE_LEN, secret, after_end);
+    *stripes_so_far = after_end;
+  }
+  else
   {
-    uint64_t k1 = XXH_read64(p);
-    k1 *= XXH_PRIME_2;
-    k1 = XXH_rotl64(k1, 31);
-    k1 *= XXH_PRIME_1;
-    h64 ^= k1;
-    h64 = XXH_rotl64(h64, 27) * XXH_PRIME_1 + XXH_PRIME_4;
-    p += 8;
+    XXH3_accumulate(acc, p, secret + *stripes_so_far * XXH_SECRET_CONSUME, stripes);
+    *stripes_so_far += stripes;
   }
+}
+
+void xxh3_update(xxh3_state_t *state, const void *data, size_t len)
+{
+  const uint8_t *p = (const uint8_t *)data;
+  const uint8_t * const end = p + len;
 
-  if (p + 4 <= end)
+  state->total_len += len;
+
+  if (state->buffered + len <= XXH3_BUFFER_SIZE)
   {
-    h64 ^= (uint64_t)(XXH_read32(p)) * XXH_PRIME_1;
-    h64 = XXH_rotl64(h64, 23) * XXH_PRIME_2 + XXH_PRIME_3;
-    p += 4;
+    if (len > 0)
+    {
+      memcpy(state->buffer + state->buffered, p, len);
+      state->buffered += len;
+    }
+
+    return;
   }
 
-  while (p < end)
+  if (state->buffered > 0)
   {
-    h64 ^= (*p) * XXH_PRIME_5;
-    h64 = XXH_rotl64(h64, 11) * XXH_PRIME_1;
-    p++;
+    const size_t fill = XXH3_BUFFER_SIZE - state->buffered;
+
+    memcpy(state->buffer + state->buffered, p, fill);
+    p += fill;
+
+    XXH3_consume_stripes(state->acc, &state->stripes, state->buffer, XXH3_BUFFER_STRIPES, state->secret);
+    state->buffered = 0;
   }
 
-  h64 ^= h64 >> 33;
-  h64 *= XXH_PRIME_2;
-  h64 ^= h64 >> 29;
-  h64 *= XXH_PRIME_3;
-  h64 ^= h64 >> 32;
+  /* at least one byte is always left over for the digest */
+  if ((size_t)(end - p) > XXH3_BUFFER_SIZE)
+  {
+    do
+    {
+      XXH3_consume_stripes(state->acc, &state->stripes, p, XXH3_BUFFER_STRIPES, state->secret);
+      p += XXH3_BUFFER_SIZE;
+    } while ((size_t)(end - p) > XXH3_BUFFER_SIZE);
 
-  return h64;
+    memcpy(state->buffer + XXH3_BUFFER_SIZE - XXH_STRIPE_LEN, p - XXH_STRIPE_LEN, XXH_STRIPE_LEN);
+  }
+
+  memcpy(state->buffer, p, (size_t)(end - p));
+  state->buffered = (size_t)(end - p);
+}
+
+static void XXH3_digest_long(const xxh3_state_t *state, uint64_t *acc)
+{
+  memcpy(acc, state->acc, sizeof(state->acc));
+
+  if (state->buffered >= XXH_STRIPE_LEN)
+  {
+    const size_t stripes = (state->buffered - 1) / XXH_STRIPE_LEN;
+    size_t stripes_so_far = state->stripes;
+
+    XXH3_consume_stripes(acc, &stripes_so_far, state->buffer, stripes, state->secret);
+    XXH3_accumulate(acc, state->buffer + state->buffered - XXH_STRIPE_LEN,
+                    state->secret + XXH_SECRET_SIZE - XXH_STRIPE_LEN - 7, 1);
+  }
+  else
+  {
+    uint8_t last[XXH_STRIPE_LEN];
+    const size_t catchup = XXH_STRIPE_LEN - state->buffered;
+
+    memcpy(last, state->buffer + XXH3_BUFFER_SIZE - catchup, catchup);
+    memcpy(last + catchup, state->buffer, state->buffered);
+    XXH3_accumulate(acc, last, state->secret + XXH_SECRET_SIZE - XXH_STRIPE_LEN - 7, 1);
+  }
+}
+
+uint64_t xxh3_digest(const xxh3_state_t *state)
+{
+  uint64_t acc[XXH_ACC_NB] __attribute__ ((aligned(64)));
+
+  if (state->total_len <= XXH_MIDSIZE_MAX)
+  {
+    return xxh3(state->buffer, (size_t)state->total_len, state->seed);
+  }
+
+  XXH3_digest_long(state, acc);
+
+  return XXH3_merge_accs(acc, state->secret + 11, state->total_len * XXH_PRIME64_1);
+}
+
+xxh128_t xxh3_128_digest(const xxh3_state_t *state)
+{
+  uint64_t acc[XXH_ACC_NB] __attribute__ ((aligned(64)));
+  xxh128_t h;
+
+  if (state->total_len <= XXH_MIDSIZE_MAX)
+  {
+    return xxh3_128(state->buffer, (size_t)state->total_len, state->seed);
+  }
+
+  XXH3_digest_long(state, acc);
+
+  h.low64 = XXH3_merge_accs(acc, state->secret + 11, state->total_len * XXH_PRIME64_1);
+  h.high64 = XXH3_merge_accs(acc, state->secret + XXH_SECRET_SIZE - XXH_STRIPE_LEN - 11,
+                             ~(state->total_len * XXH_PRIME64_2));
+
+  return h;
 }
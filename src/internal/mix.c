@@ -0,0 +1,349 @@
+/*
+ * Copyright (C) 2025 Da'Jour J. Christophe. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "internal/cpu.h"
+#include "internal/hash.h"
+#include "common.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#define MIX_K0 0x243F6A8885A308D3ULL
+#define MIX_K1 0x13198A2E03707344ULL
+#define MIX_K2 0xA4093822299F31D0ULL
+#define MIX_K3 0x082EFA98EC4E6C89ULL
+
+#define MIX_M  0x9E3779B97F4A7C15ULL
+
+static const uint8_t aes_sbox[256] = {
+  0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
+  0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0, 0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0,
+  0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f, 0xf7, 0xcc, 0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15,
+  0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a, 0x07, 0x12, 0x80, 0xe2, 0xeb, 0x27, 0xb2, 0x75,
+  0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0, 0x52, 0x3b, 0xd6, 0xb3, 0x29, 0xe3, 0x2f, 0x84,
+  0x53, 0xd1, 0x00, 0xed, 0x20, 0xfc, 0xb1, 0x5b, 0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58, 0xcf,
+  0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85, 0x45, 0xf9, 0x02, 0x7f, 0x50, 0x3c, 0x9f, 0xa8,
+  0x51, 0xa3, 0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5, 0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2,
+  0xcd, 0x0c, 0x13, 0xec, 0x5f, 0x97, 0x44, 0x17, 0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73,
+  0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88, 0x46, 0xee, 0xb8, 0x14, 0xde, 0x5e, 0x0b, 0xdb,
+  0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c, 0xc2, 0xd3, 0xac, 0x62, 0x91, 0x95, 0xe4, 0x79,
+  0xe7, 0xc8, 0x37, 0x6d, 0x8d, 0xd5, 0x4e, 0xa9, 0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a, 0xae, 0x08,
+  0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6, 0xe8, 0xdd, 0x74, 0x1f, 0x4b, 0xbd, 0x8b, 0x8a,
+  0x70, 0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e, 0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e,
+  0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf,
+  0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16,
+};
+
+static const uint32_t crc32c_table[256] = {
+  0x00000000U, 0xf26b8303U, 0xe13b70f7U, 0x1350f3f4U, 0xc79a971fU, 0x35f1141cU, 0x26a1e7e8U, 0xd4ca64ebU,
+  0x8ad958cfU, 0x78b2dbccU, 0x6be22838U, 0x9989ab3bU, 0x4d43cfd0U, 0xbf284cd3U, 0xac78bf27U, 0x5e133c24U,
+  0x105ec76fU, 0xe235446cU, 0xf165b798U, 0x030e349bU, 0xd7c45070U, 0x25afd373U, 0x36ff2087U, 0xc494a384U,
+  0x9a879fa0U, 0x68ec1ca3U, 0x7bbcef57U, 0x89d76c54U, 0x5d1d08bfU, 0xaf768bbcU, 0xbc267848U, 0x4e4dfb4bU,
+  0x20bd8edeU, 0xd2d60dddU, 0xc186fe29U, 0x33ed7d2aU, 0xe72719c1U, 0x154c9ac2U, 0x061c6936U, 0xf477ea35U,
+  0xaa64d611U, 0x580f5512U, 0x4b5fa6e6U, 0xb93425e5U, 0x6dfe410eU, 0x9f95c20dU, 0x8cc531f9U, 0x7eaeb2faU,
+  0x30e349b1U, 0xc288cab2U, 0xd1d83946U, 0x23b3ba45U, 0xf779deaeU, 0x05125dadU, 0x1642ae59U, 0xe4292d5aU,
+  0xba3a117eU, 0x4851927dU, 0x5b016189U, 0xa96ae28aU, 0x7da08661U, 0x8fcb0562U, 0x9c9bf696U, 0x6ef07595U,
+  0x417b1dbcU, 0xb3109ebfU, 0xa0406d4bU, 0x522bee48U, 0x86e18aa3U, 0x748a09a0U, 0x67dafa54U, 0x95b17957U,
+  0xcba24573U, 0x39c9c670U, 0x2a993584U, 0xd8f2b687U, 0x0c38d26cU, 0xfe53516fU, 0xed03a29bU, 0x1f682198U,
+  0x5125dad3U, 0xa34e59d0U, 0xb01eaa24U, 0x42752927U, 0x96bf4dccU, 0x64d4cecfU, 0x77843d3bU, 0x85efbe38U,
+  0xdbfc821cU, 0x2997011fU, 0x3ac7f2ebU, 0xc8ac71e8U, 0x1c661503U, 0xee0d9600U, 0xfd5d65f4U, 0x0f36e6f7U,
+  0x61c69362U, 0x93ad1061U, 0x80fde395U, 0x72966096U, 0xa65c047dU, 0x5437877eU, 0x4767748aU, 0xb50cf789U,
+  0xeb1fcbadU, 0x197448aeU, 0x0a24bb5aU, 0xf84f3859U, 0x2c855cb2U, 0xdeeedfb1U, 0xcdbe2c45U, 0x3fd5af46U,
+  0x7198540dU, 0x83f3d70eU, 0x90a324faU, 0x62c8a7f9U, 0xb602c312U, 0x44694011U, 0x5739b3e5U, 0xa55230e6U,
+  0xfb410cc2U, 0x092a8fc1U, 0x1a7a7c35U, 0xe811ff36U, 0x3cdb9bddU, 0xceb018deU, 0xdde0eb2aU, 0x2f8b6829U,
+  0x82f63b78U, 0x709db87bU, 0x63cd4b8fU, 0x91a6c88cU, 0x456cac67U, 0xb7072f64U, 0xa457dc90U, 0x563c5f93U,
+  0x082f63b7U, 0xfa44e0b4U, 0xe9141340U, 0x1b7f9043U, 0xcfb5f4a8U, 0x3dde77abU, 0x2e8e845fU, 0xdce5075cU,
+  0x92a8fc17U, 0x60c37f14U, 0x73938ce0U, 0x81f80fe3U, 0x55326b08U, 0xa759e80bU, 0xb4091bffU, 0x466298fcU,
+  0x1871a4d8U, 0xea1a27dbU, 0xf94ad42fU, 0x0b21572cU, 0xdfeb33c7U, 0x2d80b0c4U, 0x3ed04330U, 0xccbbc033U,
+  0xa24bb5a6U, 0x502036a5U, 0x4370c551U, 0xb11b4652U, 0x65d122b9U, 0x97baa1baU, 0x84ea524eU, 0x7681d14dU,
+  0x2892ed69U, 0xdaf96e6aU, 0xc9a99d9eU, 0x3bc21e9dU, 0xef087a76U, 0x1d63f975U, 0x0e330a81U, 0xfc588982U,
+  0xb21572c9U, 0x407ef1caU, 0x532e023eU, 0xa145813dU, 0x758fe5d6U, 0x87e466d5U, 0x94b49521U, 0x66df1622U,
+  0x38cc2a06U, 0xcaa7a905U, 0xd9f75af1U, 0x2b9cd9f2U, 0xff56bd19U, 0x0d3d3e1aU, 0x1e6dcdeeU, 0xec064eedU,
+  0xc38d26c4U, 0x31e6a5c7U, 0x22b65633U, 0xd0ddd530U, 0x0417b1dbU, 0xf67c32d8U, 0xe52cc12cU, 0x1747422fU,
+  0x49547e0bU, 0xbb3ffd08U, 0xa86f0efcU, 0x5a048dffU, 0x8ecee914U, 0x7ca56a17U, 0x6ff599e3U, 0x9d9e1ae0U,
+  0xd3d3e1abU, 0x21b862a8U, 0x32e8915cU, 0xc083125fU, 0x144976b4U, 0xe622f5b7U, 0xf5720643U, 0x07198540U,
+  0x590ab964U, 0xab613a67U, 0xb831c993U, 0x4a5a4a90U, 0x9e902e7bU, 0x6cfbad78U, 0x7fab5e8cU, 0x8dc0dd8fU,
+  0xe330a81aU, 0x115b2b19U, 0x020bd8edU, 0xf0605beeU, 0x24aa3f05U, 0xd6c1bc06U, 0xc5914ff2U, 0x37faccf1U,
+  0x69e9f0d5U, 0x9b8273d6U, 0x88d28022U, 0x7ab90321U, 0xae7367caU, 0x5c18e4c9U, 0x4f48173dU, 0xbd23943eU,
+  0xf36e6f75U, 0x0105ec76U, 0x12551f82U, 0xe03e9c81U, 0x34f4f86aU, 0xc69f7b69U, 0xd5cf889dU, 0x27a40b9eU,
+  0x79b737baU, 0x8bdcb4b9U, 0x988c474dU, 0x6ae7c44eU, 0xbe2da0a5U, 0x4c4623a6U, 0x5f16d052U, 0xad7d5351U,
+};
+
+static inline uint64_t mix_read64(const void *p)
+{
+  uint64_t val;
+  memcpy(&val, p, sizeof(val));
+  return val;
+}
+
+static inline uint32_t mix_read32(const void *p)
+{
+  uint32_t val;
+  memcpy(&val, p, sizeof(val));
+  return val;
+}
+
+/*
+ * Packs a key of at most 16 bytes into two words with overlapping loads,
+ * the way xxh3 reads its short inputs. The length is mixed in separately.
+ */
+static inline void mix_load(const uint8_t *p, const size_t len, uint64_t *a, uint64_t *b)
+{
+  if (len >= 8)
+  {
+    *a = mix_read64(p);
+    *b = mix_read64(p + len - 8);
+  }
+  else if (len >= 4)
+  {
+    *a = mix_read32(p);
+    *b = mix_read32(p + len - 4);
+  }
+  else if (len > 0)
+  {
+    *a = (uint64_t)p[0] | ((uint64_t)p[len >> 1] << 8) | ((uint64_t)p[len - 1] << 16);
+    *b = *a;
+  }
+  else
+  {
+    *a = 0;
+    *b = 0;
+  }
+}
+
+static inline uint64_t mix_fmix64(uint64_t h)
+{
+  h ^= h >> 33;
+  h *= 0xFF51AFD7ED558CCDULL;
+  h ^= h >> 33;
+  h *= 0xC4CEB9FE1A85EC53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+static inline uint32_t crc32c_u64_scalar(uint32_t crc, uint64_t v)
+{
+  int i;
+
+  for (i = 0; i < 8; i++)
+  {
+    crc = crc32c_table[(crc ^ (uint32_t)v) & 0xFFU] ^ (crc >> 8);
+    v >>= 8;
+  }
+
+  return crc;
+}
+
+typedef uint32_t (*crc32c_u64_t)(uint32_t crc, uint64_t v);
+
+/*
+ * CRC32C is linear, so the second lane multiplies its input first;
+ * otherwise two lanes fed the same word would differ by a constant. The
+ * final mixer is a bijection and supplies the avalanche.
+ */
+static inline always_inline uint64_t crc32c_mix_with(const uint8_t *p, const size_t len, const uint64_t seed,
+                                                     const crc32c_u64_t crc)
+{
+  uint64_t h1 = (uint32_t)seed;
+  uint64_t h2 = (uint32_t)(seed >> 32) ^ (uint32_t)MIX_K0;
+  uint64_t a, b;
+  size_t rem = len;
+
+  if (len > 16)
+  {
+    while (rem > 16)
+    {
+      h1 = crc((uint32_t)h1, mix_read64(p));
+      h2 = crc((uint32_t)h2, mix_read64(p + 8) * MIX_M);
+      p += 16;
+      rem -= 16;
+    }
+
+    a = mix_read64(p + rem - 16);
+    b = mix_read64(p + rem - 8);
+  }
+  else
+  {
+    mix_load(p, len, &a, &b);
+  }
+
+  h1 = crc((uint32_t)h1, a);
+  h2 = crc((uint32_t)h2, b * MIX_M);
+
+  return mix_fmix64(((h2 << 32) | h1) ^ ((uint64_t)len * MIX_K1));
+}
+
+static uint64_t crc32c_mix_scalar(const void *data, const size_t len, const uint64_t seed)
+{
+  return crc32c_mix_with(data, len, seed, crc32c_u64_scalar);
+}
+
+#if defined(__x86_64__)
+static inline cpu_target("sse4.2") uint32_t crc32c_u64_sse42(uint32_t crc, uint64_t v)
+{
+  return (uint32_t)_mm_crc32_u64(crc, v);
+}
+
+static cpu_target("sse4.2") uint64_t crc32c_mix_sse42(const void *data, const size_t len, const uint64_t seed)
+{
+  return crc32c_mix_with(data, len, seed, crc32c_u64_sse42);
+}
+#endif
+
+uint64_t crc32c_mix(const void *data, size_t len, uint64_t seed)
+{
+#if defined(__x86_64__)
+  if (cpu_has(CPU_SSE42))
+  {
+    return crc32c_mix_sse42(data, len, seed);
+  }
+#endif
+
+  return crc32c_mix_scalar(data, len, seed);
+}
+
+/* the AES-NI aesenc instruction: ShiftRows, SubBytes, MixColumns, AddRoundKey */
+static inline uint8_t aes_xtime(const uint8_t x)
+{
+  return (uint8_t)((x << 1) ^ ((x >> 7) * 0x1B));
+}
+
+static void aes_round_scalar(uint64_t s[2], const uint64_t k[2])
+{
+  uint8_t in[16], t[16], out[16];
+  int c, r;
+
+  memcpy(in, s, 16);
+
+  for (c = 0; c < 4; c++)
+  {
+    for (r = 0; r < 4; r++)
+    {
+      t[c * 4 + r] = aes_sbox[in[((c + r) & 3) * 4 + r]];
+    }
+  }
+
+  for (c = 0; c < 4; c++)
+  {
+    const uint8_t a0 = t[c * 4 + 0], a1 = t[c * 4 + 1];
+    const uint8_t a2 = t[c * 4 + 2], a3 = t[c * 4 + 3];
+
+    out[c * 4 + 0] = aes_xtime(a0) ^ aes_xtime(a1) ^ a1 ^ a2 ^ a3;
+    out[c * 4 + 1] = a0 ^ aes_xtime(a1) ^ aes_xtime(a2) ^ a2 ^ a3;
+    out[c * 4 + 2] = a0 ^ a1 ^ aes_xtime(a2) ^ aes_xtime(a3) ^ a3;
+    out[c * 4 + 3] = aes_xtime(a0) ^ a0 ^ a1 ^ a2 ^ aes_xtime(a3);
+  }
+
+  memcpy(s, out, 16);
+
+  s[0] ^= k[0];
+  s[1] ^= k[1];
+}
+
+/*
+ * One round per 16-byte block, then three more so the last block reaches
+ * every output bit. The 64-bit result folds both halves of the state.
+ */
+static uint64_t aes_mix_scalar(const void *data, const size_t len, const uint64_t seed)
+{
+  const uint8_t *p = data;
+  const uint64_t k0[2] = {MIX_K0 ^ seed, MIX_K1};
+  const uint64_t k1[2] = {MIX_K2 + seed, MIX_K3};
+  uint64_t s[2] = {k0[0] ^ (uint64_t)len, k0[1]};
+  uint64_t a, b;
+  size_t rem = len;
+
+  if (len > 16)
+  {
+    while (rem > 16)
+    {
+      s[0] ^= mix_read64(p);
+      s[1] ^= mix_read64(p + 8);
+      aes_round_scalar(s, k1);
+      p += 16;
+      rem -= 16;
+    }
+
+    a = mix_read64(p + rem - 16);
+    b = mix_read64(p + rem - 8);
+  }
+  else
+  {
+    mix_load(p, len, &a, &b);
+  }
+
+  s[0] ^= a;
+  s[1] ^= b;
+  aes_round_scalar(s, k1);
+  aes_round_scalar(s, k0);
+  aes_round_scalar(s, k1);
+  aes_round_scalar(s, k0);
+
+  return s[0] ^ s[1];
+}
+
+#if defined(__x86_64__)
+static cpu_target("aes,sse2") uint64_t aes_mix_aesni(const void *data, const size_t len, const uint64_t seed)
+{
+  const uint8_t *p = data;
+  const __m128i k0 = _mm_set_epi64x((long long)MIX_K1, (long long)(MIX_K0 ^ seed));
+  const __m128i k1 = _mm_set_epi64x((long long)MIX_K3, (long long)(MIX_K2 + seed));
+  __m128i s = _mm_xor_si128(k0, _mm_set_epi64x(0, (long long)len));
+  uint64_t a, b;
+  size_t rem = len;
+  __m128i block;
+
+  if (len > 16)
+  {
+    while (rem > 16)
+    {
+      s = _mm_aesenc_si128(_mm_xor_si128(s, _mm_loadu_si128((const __m128i *)p)), k1);
+      p += 16;
+      rem -= 16;
+    }
+
+    block = _mm_loadu_si128((const __m128i *)(p + rem - 16));
+  }
+  else
+  {
+    mix_load(p, len, &a, &b);
+    block = _mm_set_epi64x((long long)b, (long long)a);
+  }
+
+  s = _mm_aesenc_si128(_mm_xor_si128(s, block), k1);
+  s = _mm_aesenc_si128(s, k0);
+  s = _mm_aesenc_si128(s, k1);
+  s = _mm_aesenc_si128(s, k0);
+
+  return (uint64_t)_mm_cvtsi128_si64(s) ^ (uint64_t)_mm_cvtsi128_si64(_mm_unpackhi_epi64(s, s));
+}
+#endif
+
+uint64_t aes_mix(const void *data, size_t len, uint64_t seed)
+{
+#if defined(__x86_64__)
+  if (cpu_has(CPU_AES))
+  {
+    return aes_mix_aesni(data, len, seed);
+  }
+#endif
+
+  return aes_mix_scalar(data, len, seed);
+}
@@ -0,0 +1,163 @@
+/*
+ * Copyright (C) 2025 Da'Jour J. Christophe. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "internal/hash.h"
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+struct tree
+{
+  const uint8_t *data;
+         size_t  len;
+         size_t  leaves;
+       uint64_t  seed;
+       xxh128_t *digests;
+         size_t  next;
+};
+
+/* workers claim leaves one at a time, so a slow page fault does not stall the rest */
+static void *tree_worker(void *arg)
+{
+  struct tree *self = (struct tree *)arg;
+  size_t i;
+
+  while ((i = __atomic_fetch_add(&self->next, 1UL, __ATOMIC_RELAXED)) < self->leaves)
+  {
+    const size_t offset = i * XXH3_TREE_LEAF;
+    const size_t len = self->len - offset < XXH3_TREE_LEAF ? self->len - offset : XXH3_TREE_LEAF;
+
+    self->digests[i] = xxh3_128(self->data + offset, len, self->seed);
+  }
+
+  return NULL;
+}
+
+uint64_t xxh3_tree(const void *data, size_t len, uint64_t seed, unsigned int threads)
+{
+  struct tree self;
+  pthread_t *workers = NULL;
+  unsigned int started = 0U;
+  unsigned int i;
+  uint64_t hash;
+
+  self.data = (const uint8_t *)data;
+  self.len = len;
+  self.leaves = len == 0UL ? 1UL : (len + XXH3_TREE_LEAF - 1UL) / XXH3_TREE_LEAF;
+  self.seed = seed;
+  self.next = 0UL;
+
+  self.digests = (xxh128_t *)malloc(self.leaves * sizeof(*self.digests));
+  if (self.digests == NULL)
+  {
+    fprintf(stderr, "%s(): %s\n", __func__, "could not allocate tree.digests to the heap");
+    exit(EXIT_FAILURE);
+  }
+
+  if (threads == 0U)
+  {
+    const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    threads = cpus > 0L ? (unsigned int)cpus : 1U;
+  }
+
+  if ((size_t)threads > self.leaves)
+  {
+    threads = (unsigned int)self.leaves;
+  }
+
+  if (threads > 1U)
+  {
+    workers = (pthread_t *)malloc((threads - 1U) * sizeof(*workers));
+    if (workers == NULL)
+    {
+      fprintf(stderr, "%s(): %s\n", __func__, "could not allocate tree workers to the heap");
+      exit(EXIT_FAILURE);
+    }
+
+    /* a worker that fails to start only leaves more leaves to the rest */
+    for (i = 0U; i < threads - 1U; i++)
+    {
+      if (0 == pthread_create(&workers[started], NULL, tree_worker, &self))
+      {
+        started++;
+      }
+    }
+  }
+
+  tree_worker(&self);
+
+  for (i = 0U; i < started; i++)
+  {
+    pthread_join(workers[i], NULL);
+  }
+
+  hash = xxh3(self.digests, self.leaves * sizeof(*self.digests), seed);
+
+  free(workers);
+  free(self.digests);
+
+  return hash;
+}
+
+int xxh3_tree_file(const char *path, uint64_t seed, unsigned int threads, uint64_t *out)
+{
+  struct stat st;
+  void *data = NULL;
+  int fd;
+
+  fd = open(path, O_RDONLY);
+  if (fd < 0)
+  {
+    return (-1);
+  }
+
+  if (0 != fstat(fd, &st) || !S_ISREG(st.st_mode))
+  {
+    close(fd);
+    return (-1);
+  }
+
+  if (st.st_size == 0)
+  {
+    close(fd);
+    *out = xxh3_tree(NULL, 0UL, seed, threads);
+    return 0;
+  }
+
+  data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+
+  if (data == MAP_FAILED)
+  {
+    return (-1);
+  }
+
+  posix_madvise(data, (size_t)st.st_size, POSIX_MADV_WILLNEED);
+
+  *out = xxh3_tree(data, (size_t)st.st_size, seed, threads);
+
+  munmap(data, (size_t)st.st_size);
+
+  return 0;
+}
@@ -26,6 +26,7 @@
 struct bucket
 {
   size_t   keylen;
+  xxh128_t hash;
   size_t   size;
   uint8_t *key;
   uint8_t *data;
@@ -45,7 +46,8 @@ static bucket_t unused *bucket_empty(void)
   return self;
 }
 
-static bucket_t *bucket_new(const void *key, const size_t keylen, const void *data, const size_t size)
+static bucket_t *bucket_new(const void *key, const size_t keylen, const void *data, const size_t size,
+                            const xxh128_t hash)
 {
   bucket_t *self = NULL;
 
@@ -56,6 +58,8 @@ static bucket_t *bucket_new(const void *key, const size_t keylen, const void *da
     exit(EXIT_FAILURE);
   }
 
+  self->hash = hash;
+
   if (key != NULL && keylen > 0UL)
   {
     self->key = (uint8_t *)calloc(keylen, sizeof(*self->key));
@@ -119,6 +123,8 @@ static void bucket_update(bucket_t *self, const void *data, const size_t size)
       fprintf(stderr, "%s(): %s\n", __func__, "could not re- allocate bucket.data to the heap");
       exit(EXIT_FAILURE);
     }
+
+    self->size = size;
   }
 
   memcpy(self->data, data, size);
@@ -145,9 +151,15 @@ static size_t bucket_size(bucket_t *self)
   return self->size;
 }
 
-static int bucket_haskey(bucket_t *self, const void *key, const size_t keylen)
+static int bucket_haskey(bucket_t *self, const void *key, const size_t keylen,
+                         const xxh128_t hash, const int identity)
 {
-  return self->keylen == keylen && memcmp(self->key, key, keylen) == 0;
+  if (self->hash.low64 != hash.low64 || self->hash.high64 != hash.high64)
+  {
+    return 0;
+  }
+
+  return identity || (self->keylen == keylen && memcmp(self->key, key, keylen) == 0);
 }
 
 map_t *map_new(const size_t size)
@@ -169,6 +181,7 @@ map_t *map_new(const size_t size)
   }
 
   self->size = size;
+  self->hash = xxh3;
 
   return self;
 }
@@ -195,6 +208,9 @@ void map_destroy(map_t *self)
       self->buckets = NULL;
     }
 
+    bloom_destroy(self->filter);
+    self->filter = NULL;
+
     free(self);
     self = NULL;
   }
@@ -202,13 +218,41 @@ void map_destroy(map_t *self)
 
 #define SEED 2
 
+/*
+ * In identity mode buckets are keyed by the full 128-bit hash and key
+ * bytes are never compared. Otherwise the high half stays zero and the
+ * stored hash only screens out mismatches before memcmp.
+ */
+static inline xxh128_t map_hash(const map_t *self, const void *key, const size_t keylen)
+{
+  xxh128_t hash = {0, 0};
+
+  if (self->identity)
+  {
+    return __hash128__(key, keylen, SEED);
+  }
+
+  hash.low64 = self->hash(key, keylen, SEED);
+
+  return hash;
+}
+
 void *map_get(map_t *self, const void *key, const size_t keylen, size_t *size)
 {
-  const uint64_t key_hashed = __hash__(key, keylen, SEED);
+  const xxh128_t hash = map_hash(self, key, keylen);
+  const uint64_t key_hashed = hash.low64;
   uint64_t i;
   uint64_t j;
 
-  *size = 0UL;
+  if (size != NULL)
+  {
+    *size = 0UL;
+  }
+
+  if (self->filter != NULL && 0 == bloom_contains_hash(self->filter, key_hashed))
+  {
+    return NULL;
+  }
 
   for (i = 0UL; i < self->size; i++)
   {
@@ -219,7 +263,7 @@ void *map_get(map_t *self, const void *key, const size_t keylen, size_t *size)
       return NULL;
     }
 
-    if (0 == bucket_haskey(self->buckets[j], key, keylen))
+    if (0 == bucket_haskey(self->buckets[j], key, keylen, hash, self->identity))
     {
       continue;
     }
@@ -235,12 +279,17 @@ void *map_get(map_t *self, const void *key, const size_t keylen, size_t *size)
   return NULL;
 }
 
-int map_exists(map_t *self, const void *key, const size_t keylen)
+static int map_exists_hash(map_t *self, const void *key, const size_t keylen, const xxh128_t hash)
 {
-  const uint64_t key_hashed = __hash__(key, keylen, SEED);
+  const uint64_t key_hashed = hash.low64;
   uint64_t i;
   uint64_t j;
 
+  if (self->filter != NULL && 0 == bloom_contains_hash(self->filter, key_hashed))
+  {
+    return 0;
+  }
+
   for (i = 0UL; i < self->size; i++)
   {
     j = (key_hashed + i) % self->size;
@@ -250,7 +299,7 @@ int map_exists(map_t *self, const void *key, const size_t keylen)
       return 0;
     }
 
-    if (0 == bucket_haskey(self->buckets[j], key, keylen))
+    if (0 == bucket_haskey(self->buckets[j], key, keylen, hash, self->identity))
     {
       continue;
     }
@@ -261,10 +310,10 @@ int map_exists(map_t *self, const void *key, const size_t keylen)
   return 0;
 }
 
-int map_set(map_t *self, const void *key,  const size_t keylen,
-                         const void *data, const size_t datalen)
+static int map_set_hash(map_t *self, const void *key,  const size_t keylen,
+                                    const void *data, const size_t datalen, const xxh128_t hash)
 {
-  const uint64_t key_hashed = __hash__(key, keylen, SEED);
+  const uint64_t key_hashed = hash.low64;
   uint64_t i;
   uint64_t j;
 
@@ -274,7 +323,7 @@ int map_set(map_t *self, const void *key,  const size_t keylen,
 
     if (self->buckets[j] != NULL)
     {
-      if (1 == bucket_haskey(self->buckets[j], key, keylen))
+      if (1 == bucket_haskey(self->buckets[j], key, keylen, hash, self->identity))
       {
         bucket_update(self->buckets[j], data, datalen);
         return 0;
@@ -283,19 +332,132 @@ int map_set(map_t *self, const void *key,  const size_t keylen,
       continue;
     }
 
-    self->buckets[j] = bucket_new(key, keylen, data, datalen);
+    self->buckets[j] = bucket_new(key, keylen, data, datalen, hash);
+
+    if (self->filter != NULL)
+    {
+      bloom_add_hash(self->filter, key_hashed);
+    }
+
     return 0;
   }
 
   return (-1);
 }
 
+int map_exists(map_t *self, const void *key, const size_t keylen)
+{
+  return map_exists_hash(self, key, keylen, map_hash(self, key, keylen));
+}
+
+int map_set(map_t *self, const void *key,  const size_t keylen,
+                         const void *data, const size_t datalen)
+{
+  return map_set_hash(self, key, keylen, data, datalen, map_hash(self, key, keylen));
+}
+
+#define MAP_BATCH 64UL
+
+/*
+ * Hashes a block of keys, with xxh3_batch() when the table uses xxh3,
+ * and prefetches each home bucket before probing, so the lookups overlap
+ * their cache misses.
+ * Identity mode needs 128-bit hashes and falls back to one key at a time.
+ */
+static size_t map_batch_hash(map_t *self, const uint8_t *keys, const size_t keylen, const size_t n, uint64_t *hashes)
+{
+  const size_t count = n < MAP_BATCH ? n : MAP_BATCH;
+  size_t k;
+
+  if (self->hash == xxh3)
+  {
+    xxh3_batch(keys, keylen, keylen, count, SEED, hashes);
+  }
+  else
+  {
+    for (k = 0UL; k < count; k++)
+    {
+      hashes[k] = self->hash(keys + k * keylen, keylen, SEED);
+    }
+  }
+
+  for (k = 0UL; k < count && self->size > 0UL; k++)
+  {
+    __builtin_prefetch(&self->buckets[hashes[k] % self->size]);
+  }
+
+  return count;
+}
+
+int map_set_batch(map_t *self, const void *keys, const size_t keylen,
+                               const void *data, const size_t datalen, const size_t n)
+{
+  const uint8_t *key = (const uint8_t *)keys;
+  const uint8_t *value = (const uint8_t *)data;
+  uint64_t hashes[MAP_BATCH];
+  int ret = 0;
+  size_t i;
+  size_t k;
+
+  for (i = 0UL; i < n; )
+  {
+    const size_t count = self->identity ? 1UL : map_batch_hash(self, key + i * keylen, keylen, n - i, hashes);
+
+    for (k = 0UL; k < count; k++, i++)
+    {
+      const xxh128_t hash = self->identity ? map_hash(self, key + i * keylen, keylen) : (xxh128_t){hashes[k], 0};
+
+      if (0 > map_set_hash(self, key + i * keylen, keylen, value + i * datalen, datalen, hash))
+      {
+        ret = (-1);
+      }
+    }
+  }
+
+  return ret;
+}
+
+size_t map_exists_batch(map_t *self, const void *keys, const size_t keylen, const size_t n, int *found)
+{
+  const uint8_t *key = (const uint8_t *)keys;
+  uint64_t hashes[MAP_BATCH];
+  size_t total = 0UL;
+  size_t i;
+  size_t k;
+
+  for (i = 0UL; i < n; )
+  {
+    const size_t count = self->identity ? 1UL : map_batch_hash(self, key + i * keylen, keylen, n - i, hashes);
+
+    for (k = 0UL; k < count; k++, i++)
+    {
+      const xxh128_t hash = self->identity ? map_hash(self, key + i * keylen, keylen) : (xxh128_t){hashes[k], 0};
+      const int exists = map_exists_hash(self, key + i * keylen, keylen, hash);
+
+      if (found != NULL)
+      {
+        found[i] = exists;
+      }
+
+      total += (size_t)exists;
+    }
+  }
+
+  return total;
+}
+
 int map_del(map_t *self, const void *key, const size_t keylen)
 {
-  const uint64_t key_hashed = __hash__(key, keylen, SEED);
+  const xxh128_t hash = map_hash(self, key, keylen);
+  const uint64_t key_hashed = hash.low64;
   uint64_t i;
   uint64_t j;
 
+  if (self->filter != NULL && 0 == bloom_contains_hash(self->filter, key_hashed))
+  {
+    return (-1);
+  }
+
   for (i = 0UL; i < self->size; i++)
   {
     j = (key_hashed + i) % self->size;
@@ -305,7 +467,7 @@ int map_del(map_t *self, const void *key, const size_t keylen)
       return (-1);
     }
 
-    if (0 == bucket_haskey(self->buckets[j], key, keylen))
+    if (0 == bucket_haskey(self->buckets[j], key, keylen, hash, self->identity))
     {
       continue;
     }
@@ -316,3 +478,114 @@ int map_del(map_t *self, const void *key, const size_t keylen)
 
   return (-1);
 }
+
+int map_enable_filter(map_t *self, const double fpp)
+{
+  bloom_t *filter = bloom_new(self->size, fpp);
+
+  /* keep the current filter when the new one cannot be built */
+  if (filter == NULL)
+  {
+    return (-1);
+  }
+
+  bloom_destroy(self->filter);
+  self->filter = filter;
+
+  map_compact(self);
+
+  return 0;
+}
+
+void map_enable_identity(map_t *self)
+{
+  uint64_t i;
+
+  self->identity = 1;
+
+  for (i = 0UL; i < self->size; i++)
+  {
+    if (self->buckets[i] != NULL)
+    {
+      self->buckets[i]->hash = __hash128__(self->buckets[i]->key, self->buckets[i]->keylen, SEED);
+    }
+  }
+
+  map_compact(self);
+}
+
+void map_use_hash(map_t *self, const hash_fn_t fn)
+{
+  uint64_t i;
+
+  self->hash = fn;
+
+  if (self->identity)
+  {
+    return;
+  }
+
+  for (i = 0UL; i < self->size; i++)
+  {
+    if (self->buckets[i] != NULL)
+    {
+      self->buckets[i]->hash.low64 = fn(self->buckets[i]->key, self->buckets[i]->keylen, SEED);
+    }
+  }
+
+  map_compact(self);
+}
+
+/*
+ * Reinserts every entry into a fresh bucket array, which closes the holes
+ * map_del leaves in probe chains, and rebuilds the filter so it stops
+ * answering for deleted keys.
+ */
+void map_compact(map_t *self)
+{
+  bucket_t **buckets = self->buckets;
+  uint64_t key_hashed;
+  uint64_t i;
+  uint64_t j;
+  uint64_t k;
+
+  self->buckets = (bucket_t **)calloc(self->size, sizeof(*self->buckets));
+  if (self->buckets == NULL)
+  {
+    fprintf(stderr, "%s(): %s\n", __func__, "could not allocate map.buckets to the heap");
+    exit(EXIT_FAILURE);
+  }
+
+  if (self->filter != NULL)
+  {
+    bloom_clear(self->filter);
+  }
+
+  for (i = 0UL; i < self->size; i++)
+  {
+    if (buckets[i] == NULL)
+    {
+      continue;
+    }
+
+    key_hashed = buckets[i]->hash.low64;
+
+    for (k = 0UL; k < self->size; k++)
+    {
+      j = (key_hashed + k) % self->size;
+
+      if (self->buckets[j] == NULL)
+      {
+        self->buckets[j] = buckets[i];
+        break;
+      }
+    }
+
+    if (self->filter != NULL)
+    {
+      bloom_add_hash(self->filter, key_hashed);
+    }
+  }
+
+  free(buckets);
+}
@@ -13,6 +13,7 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include "internal/cpu.h"
 #include "internal/hash.h"
 #include "common.h"
 #include "set.h"
@@ -23,9 +24,14 @@
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(CPU_X86)
+#include <immintrin.h>
+#endif
+
 struct bucket
 {
   size_t   keylen;
+  xxh128_t hash;
   uint8_t *key;
 };
 
@@ -43,7 +49,7 @@ static bucket_t unused *bucket_empty(void)
   return self;
 }
 
-static bucket_t *bucket_new(const void *key, const size_t keylen)
+static bucket_t *bucket_new(const void *key, const size_t keylen, const xxh128_t hash)
 {
   bucket_t *self = NULL;
 
@@ -54,6 +60,8 @@ static bucket_t *bucket_new(const void *key, const size_t keylen)
     exit(EXIT_FAILURE);
   }
 
+  self->hash = hash;
+
   if (key != NULL && keylen > 0UL)
   {
     self->key = (uint8_t *)calloc(keylen, sizeof(*self->key));
@@ -102,9 +110,15 @@ static void *bucket_key(bucket_t *self, size_t *size)
   return key;
 }
 
-static int bucket_haskey(bucket_t *self, const void *key, const size_t keylen)
+static int bucket_haskey(bucket_t *self, const void *key, const size_t keylen,
+                         const xxh128_t hash, const int identity)
 {
-  return self->keylen == keylen && memcmp(self->key, key, keylen) == 0;
+  if (self->hash.low64 != hash.low64 || self->hash.high64 != hash.high64)
+  {
+    return 0;
+  }
+
+  return identity || (self->keylen == keylen && memcmp(self->key, key, keylen) == 0);
 }
 
 set_t *set_new(const size_t size)
@@ -126,6 +140,7 @@ set_t *set_new(const size_t size)
   }
 
   self->size = size;
+  self->hash = xxh3;
 
   return self;
 }
@@ -152,6 +167,9 @@ void set_destroy(set_t *self)
       self->buckets = NULL;
     }
 
+    bloom_destroy(self->filter);
+    self->filter = NULL;
+
     free(self);
     self = NULL;
   }
@@ -159,12 +177,37 @@ void set_destroy(set_t *self)
 
 #define SEED 2
 
+/*
+ * In identity mode buckets are keyed by the full 128-bit hash and key
+ * bytes are never compared. Otherwise the high half stays zero and the
+ * stored hash only screens out mismatches before memcmp.
+ */
+static inline xxh128_t set_hash(const set_t *self, const void *key, const size_t keylen)
+{
+  xxh128_t hash = {0, 0};
+
+  if (self->identity)
+  {
+    return __hash128__(key, keylen, SEED);
+  }
+
+  hash.low64 = self->hash(key, keylen, SEED);
+
+  return hash;
+}
+
 void *set_get(set_t *self, const void *key, const size_t keylen, size_t *size)
 {
-  const uint64_t key_hashed = __hash__(key, keylen, SEED);
+  const xxh128_t hash = set_hash(self, key, keylen);
+  const uint64_t key_hashed = hash.low64;
   uint64_t i;
   uint64_t j;
 
+  if (self->filter != NULL && 0 == bloom_contains_hash(self->filter, key_hashed))
+  {
+    return NULL;
+  }
+
   for (i = 0UL; i < self->size; i++)
   {
     j = (key_hashed + i) % self->size;
@@ -174,7 +217,7 @@ void *set_get(set_t *self, const void *key, const size_t keylen, size_t *size)
       return NULL;
     }
 
-    if (0 == bucket_haskey(self->buckets[j], key, keylen))
+    if (0 == bucket_haskey(self->buckets[j], key, keylen, hash, self->identity))
     {
       continue;
     }
@@ -242,10 +285,16 @@ void *set_getall(set_t *self, size_t *overall_size)
 
 int set_exists(set_t *self, const void *key, const size_t keylen)
 {
-  const uint64_t key_hashed = __hash__(key, keylen, SEED);
+  const xxh128_t hash = set_hash(self, key, keylen);
+  const uint64_t key_hashed = hash.low64;
   uint64_t i;
   uint64_t j;
 
+  if (self->filter != NULL && 0 == bloom_contains_hash(self->filter, key_hashed))
+  {
+    return 0;
+  }
+
   for (i = 0UL; i < self->size; i++)
   {
     j = (key_hashed + i) % self->size;
@@ -255,7 +304,7 @@ int set_exists(set_t *self, const void *key, const size_t keylen)
       return 0;
     }
 
-    if (0 == bucket_haskey(self->buckets[j], key, keylen))
+    if (0 == bucket_haskey(self->buckets[j], key, keylen, hash, self->identity))
     {
       continue;
     }
@@ -268,7 +317,8 @@ int set_exists(set_t *self, const void *key, const size_t keylen)
 
 int set_add(set_t *self, const void *key, const size_t keylen)
 {
-  const uint64_t key_hashed = __hash__(key, keylen, SEED);
+  const xxh128_t hash = set_hash(self, key, keylen);
+  const uint64_t key_hashed = hash.low64;
   uint64_t i;
   uint64_t j;
 
@@ -278,7 +328,7 @@ int set_add(set_t *self, const void *key, const size_t keylen)
 
     if (self->buckets[j] != NULL)
     {
-      if (1 == bucket_haskey(self->buckets[j], key, keylen))
+      if (1 == bucket_haskey(self->buckets[j], key, keylen, hash, self->identity))
       {
         return 0;
       }
@@ -286,7 +336,13 @@ int set_add(set_t *self, const void *key, const size_t keylen)
       continue;
     }
 
-    self->buckets[j] = bucket_new(key, keylen);
+    self->buckets[j] = bucket_new(key, keylen, hash);
+
+    if (self->filter != NULL)
+    {
+      bloom_add_hash(self->filter, key_hashed);
+    }
+
     return 0;
   }
 
@@ -295,10 +351,16 @@ int set_add(set_t *self, const void *key, const size_t keylen)
 
 int set_remove(set_t *self, const void *key, const size_t keylen)
 {
-  const uint64_t key_hashed = __hash__(key, keylen, SEED);
+  const xxh128_t hash = set_hash(self, key, keylen);
+  const uint64_t key_hashed = hash.low64;
   uint64_t i;
   uint64_t j;
 
+  if (self->filter != NULL && 0 == bloom_contains_hash(self->filter, key_hashed))
+  {
+    return (-1);
+  }
+
   for (i = 0UL; i < self->size; i++)
   {
     j = (key_hashed + i) % self->size;
@@ -308,7 +370,7 @@ int set_remove(set_t *self, const void *key, const size_t keylen)
       return (-1);
     }
 
-    if (0 == bucket_haskey(self->buckets[j], key, keylen))
+    if (0 == bucket_haskey(self->buckets[j], key, keylen, hash, self->identity))
     {
       continue;
     }
@@ -319,3 +381,454 @@ int set_remove(set_t *self, const void *key, const size_t keylen)
 
   return (-1);
 }
+
+int set_enable_filter(set_t *self, const double fpp)
+{
+  bloom_t *filter = bloom_new(self->size, fpp);
+
+  /* keep the current filter when the new one cannot be built */
+  if (filter == NULL)
+  {
+    return (-1);
+  }
+
+  bloom_destroy(self->filter);
+  self->filter = filter;
+
+  set_compact(self);
+
+  return 0;
+}
+
+void set_enable_identity(set_t *self)
+{
+  uint64_t i;
+
+  self->identity = 1;
+
+  for (i = 0UL; i < self->size; i++)
+  {
+    if (self->buckets[i] != NULL)
+    {
+      self->buckets[i]->hash = __hash128__(self->buckets[i]->key, self->buckets[i]->keylen, SEED);
+    }
+  }
+
+  set_compact(self);
+}
+
+void set_use_hash(set_t *self, const hash_fn_t fn)
+{
+  uint64_t i;
+
+  self->hash = fn;
+
+  if (self->identity)
+  {
+    return;
+  }
+
+  for (i = 0UL; i < self->size; i++)
+  {
+    if (self->buckets[i] != NULL)
+    {
+      self->buckets[i]->hash.low64 = fn(self->buckets[i]->key, self->buckets[i]->keylen, SEED);
+    }
+  }
+
+  set_compact(self);
+}
+
+/*
+ * Reinserts every key into a fresh bucket array, which closes the holes
+ * set_remove leaves in probe chains, and rebuilds the filter so it stops
+ * answering for removed keys.
+ */
+void set_compact(set_t *self)
+{
+  bucket_t **buckets = self->buckets;
+  uint64_t key_hashed;
+  uint64_t i;
+  uint64_t j;
+  uint64_t k;
+
+  self->buckets = (bucket_t **)calloc(self->size, sizeof(*self->buckets));
+  if (self->buckets == NULL)
+  {
+    fprintf(stderr, "%s(): %s\n", __func__, "could not allocate set.buckets to the heap");
+    exit(EXIT_FAILURE);
+  }
+
+  if (self->filter != NULL)
+  {
+    bloom_clear(self->filter);
+  }
+
+  for (i = 0UL; i < self->size; i++)
+  {
+    if (buckets[i] == NULL)
+    {
+      continue;
+    }
+
+    key_hashed = buckets[i]->hash.low64;
+
+    for (k = 0UL; k < self->size; k++)
+    {
+      j = (key_hashed + k) % self->size;
+
+      if (self->buckets[j] == NULL)
+      {
+        self->buckets[j] = buckets[i];
+        break;
+      }
+    }
+
+    if (self->filter != NULL)
+    {
+      bloom_add_hash(self->filter, key_hashed);
+    }
+  }
+
+  free(buckets);
+}
+
+static void set_add_all(set_t *self, set_t *other)
+{
+  uint64_t i;
+
+  for (i = 0UL; i < other->size; i++)
+  {
+    if (other->buckets[i] == NULL)
+    {
+      continue;
+    }
+
+    if (0 > set_add(self, other->buckets[i]->key, other->buckets[i]->keylen))
+    {
+      fprintf(stderr, "%s(): %s\n", __func__, "could not add key to the set");
+      exit(EXIT_FAILURE);
+    }
+  }
+}
+
+set_t *set_union(set_t *a, set_t *b)
+{
+  set_t *self = set_new(a->size + b->size);
+
+  self->identity = a->identity;
+  self->hash = a->hash;
+
+  set_add_all(self, a);
+  set_add_all(self, b);
+
+  return self;
+}
+
+set_t *set_intersect(set_t *a, set_t *b)
+{
+  set_t *small = a->size <= b->size ? a : b;
+  set_t *large = a->size <= b->size ? b : a;
+  set_t *self = set_new(small->size);
+  bucket_t *bucket = NULL;
+  uint64_t i;
+
+  self->identity = a->identity;
+  self->hash = a->hash;
+
+  for (i = 0UL; i < small->size; i++)
+  {
+    bucket = small->buckets[i];
+
+    if (bucket == NULL || 0 == set_exists(large, bucket->key, bucket->keylen))
+    {
+      continue;
+    }
+
+    set_add(self, bucket->key, bucket->keylen);
+  }
+
+  return self;
+}
+
+set_t *set_difference(set_t *a, set_t *b)
+{
+  set_t *self = set_new(a->size);
+  bucket_t *bucket = NULL;
+  uint64_t i;
+
+  self->identity = a->identity;
+  self->hash = a->hash;
+
+  for (i = 0UL; i < a->size; i++)
+  {
+    bucket = a->buckets[i];
+
+    if (bucket == NULL || 1 == set_exists(b, bucket->key, bucket->keylen))
+    {
+      continue;
+    }
+
+    set_add(self, bucket->key, bucket->keylen);
+  }
+
+  return self;
+}
+
+int set_is_subset(set_t *a, set_t *b)
+{
+  bucket_t *bucket = NULL;
+  uint64_t i;
+
+  for (i = 0UL; i < a->size; i++)
+  {
+    bucket = a->buckets[i];
+
+    if (bucket == NULL)
+    {
+      continue;
+    }
+
+    if (0 == set_exists(b, bucket->key, bucket->keylen))
+    {
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
+size_t set_union_u32(const uint32_t *a, const size_t na,
+                     const uint32_t *b, const size_t nb, uint32_t *out)
+{
+  size_t i = 0UL;
+  size_t j = 0UL;
+  size_t k = 0UL;
+
+  while (i < na && j < nb)
+  {
+    const uint32_t x = a[i];
+    const uint32_t y = b[j];
+
+    out[k++] = x <= y ? x : y;
+    i += x <= y;
+    j += y <= x;
+  }
+
+  while (i < na)
+  {
+    out[k++] = a[i++];
+  }
+
+  while (j < nb)
+  {
+    out[k++] = b[j++];
+  }
+
+  return k;
+}
+
+#if defined(CPU_X86)
+/*
+ * Compare an 8-lane block of a against every rotation of an 8-lane block
+ * of b, then pack the matching lanes of a to the front with a permute
+ * built from the match mask.
+ */
+static cpu_target("avx2,bmi2,popcnt") size_t set_intersect_u32_avx2(const uint32_t *a, const size_t na, size_t *pi,
+                                                                   const uint32_t *b, const size_t nb, size_t *pj,
+                                                                   uint32_t *out, size_t k)
+{
+  const __m256i rotate = _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 0);
+  const size_t limit = na < nb ? na : nb;
+  size_t i = *pi;
+  size_t j = *pj;
+
+  while (i + 8UL <= na && j + 8UL <= nb && k + 8UL <= limit)
+  {
+    const __m256i va = _mm256_loadu_si256((const __m256i *)(a + i));
+    __m256i vb = _mm256_loadu_si256((const __m256i *)(b + j));
+    __m256i cmp = _mm256_cmpeq_epi32(va, vb);
+    int r;
+
+    for (r = 1; r < 8; r++)
+    {
+      vb = _mm256_permutevar8x32_epi32(vb, rotate);
+      cmp = _mm256_or_si256(cmp, _mm256_cmpeq_epi32(va, vb));
+    }
+
+    const uint32_t mask = (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(cmp));
+    const uint64_t lanes = _pdep_u64(mask, 0x0101010101010101ULL) * 0xFFU;
+    const uint64_t index = _pext_u64(0x0706050403020100ULL, lanes);
+    const __m256i shuffle = _mm256_cvtepu8_epi32(_mm_cvtsi64_si128((long long)index));
+
+    _mm256_storeu_si256((__m256i *)(out + k), _mm256_permutevar8x32_epi32(va, shuffle));
+    k += (size_t)__builtin_popcount(mask);
+
+    const uint32_t amax = a[i + 7UL];
+    const uint32_t bmax = b[j + 7UL];
+
+    i += amax <= bmax ? 8UL : 0UL;
+    j += bmax <= amax ? 8UL : 0UL;
+  }
+
+  *pi = i;
+  *pj = j;
+
+  return k;
+}
+
+static const uint8_t set_u32_shuffle[16][16] = {
+  { 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+  { 0x00, 0x01, 0x02, 0x03, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+  { 0x04, 0x05, 0x06, 0x07, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+  { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+  { 0x08, 0x09, 0x0a, 0x0b, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+  { 0x00, 0x01, 0x02, 0x03, 0x08, 0x09, 0x0a, 0x0b, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+  { 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+  { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x80, 0x80, 0x80, 0x80 },
+  { 0x0c, 0x0d, 0x0e, 0x0f, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+  { 0x00, 0x01, 0x02, 0x03, 0x0c, 0x0d, 0x0e, 0x0f, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+  { 0x04, 0x05, 0x06, 0x07, 0x0c, 0x0d, 0x0e, 0x0f, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+  { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x0c, 0x0d, 0x0e, 0x0f, 0x80, 0x80, 0x80, 0x80 },
+  { 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+  { 0x00, 0x01, 0x02, 0x03, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x80, 0x80, 0x80, 0x80 },
+  { 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x80, 0x80, 0x80, 0x80 },
+  { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f },
+};
+
+static cpu_target("ssse3") size_t set_intersect_u32_sse(const uint32_t *a, const size_t na, size_t *pi,
+                                                        const uint32_t *b, const size_t nb, size_t *pj,
+                                                        uint32_t *out, size_t k)
+{
+  const size_t limit = na < nb ? na : nb;
+  size_t i = *pi;
+  size_t j = *pj;
+
+  while (i + 4UL <= na && j + 4UL <= nb && k + 4UL <= limit)
+  {
+    const __m128i va = _mm_loadu_si128((const __m128i *)(a + i));
+    const __m128i vb = _mm_loadu_si128((const __m128i *)(b + j));
+
+    __m128i cmp = _mm_cmpeq_epi32(va, vb);
+    cmp = _mm_or_si128(cmp, _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(0, 3, 2, 1))));
+    cmp = _mm_or_si128(cmp, _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(1, 0, 3, 2))));
+    cmp = _mm_or_si128(cmp, _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(2, 1, 0, 3))));
+
+    const int mask = _mm_movemask_ps(_mm_castsi128_ps(cmp));
+    const __m128i shuffle = _mm_loadu_si128((const __m128i *)set_u32_shuffle[mask]);
+
+    _mm_storeu_si128((__m128i *)(out + k), _mm_shuffle_epi8(va, shuffle));
+    k += (size_t)__builtin_popcount((unsigned int)mask);
+
+    const uint32_t amax = a[i + 3UL];
+    const uint32_t bmax = b[j + 3UL];
+
+    i += amax <= bmax ? 4UL : 0UL;
+    j += bmax <= amax ? 4UL : 0UL;
+  }
+
+  *pi = i;
+  *pj = j;
+
+  return k;
+}
+#endif
+
+size_t set_intersect_u32(const uint32_t *a, const size_t na,
+                         const uint32_t *b, const size_t nb, uint32_t *out)
+{
+  size_t i = 0UL;
+  size_t j = 0UL;
+  size_t k = 0UL;
+
+  /*
+   * The vector kernels store a full block at out + k, so they stop once a
+   * block would run past min(na, nb) and the scalar merge takes the rest.
+   */
+#if defined(CPU_X86)
+  if (cpu_has(CPU_AVX2 | CPU_BMI2 | CPU_POPCNT))
+  {
+    k = set_intersect_u32_avx2(a, na, &i, b, nb, &j, out, k);
+  }
+
+  if (cpu_has(CPU_SSSE3))
+  {
+    k = set_intersect_u32_sse(a, na, &i, b, nb, &j, out, k);
+  }
+#endif
+
+  while (i < na && j < nb)
+  {
+    const uint32_t x = a[i];
+    const uint32_t y = b[j];
+
+    if (x == y)
+    {
+      out[k++] = x;
+    }
+
+    i += x <= y;
+    j += y <= x;
+  }
+
+  return k;
+}
+
+size_t set_difference_u32(const uint32_t *a, const size_t na,
+                          const uint32_t *b, const size_t nb, uint32_t *out)
+{
+  size_t i = 0UL;
+  size_t j = 0UL;
+  size_t k = 0UL;
+
+  while (i < na && j < nb)
+  {
+    const uint32_t x = a[i];
+    const uint32_t y = b[j];
+
+    if (x < y)
+    {
+      out[k++] = x;
+    }
+
+    i += x <= y;
+    j += y <= x;
+  }
+
+  while (i < na)
+  {
+    out[k++] = a[i++];
+  }
+
+  return k;
+}
+
+int set_is_subset_u32(const uint32_t *a, const size_t na,
+                      const uint32_t *b, const size_t nb)
+{
+  size_t i = 0UL;
+  size_t j = 0UL;
+
+  if (na > nb)
+  {
+    return 0;
+  }
+
+  while (i < na)
+  {
+    while (j < nb && b[j] < a[i])
+    {
+      j++;
+    }
+
+    if (j == nb || b[j] != a[i])
+    {
+      return 0;
+    }
+
+    i++;
+    j++;
+  }
+
+  return 1;
+}
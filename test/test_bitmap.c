@@ -0,0 +1,204 @@
+/*
+ * Copyright (C) 2025 Da'Jour J. Christophe. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <setjmp.h>
+
+#include "cmocka.h"
+
+#include "bitmap.h"
+#include "common.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static void test_bitmap_create_destroy(void **state)
+{
+  UNUSED(state);
+
+  bitmap_t *b = bitmap_new();
+  assert_non_null(b);
+  assert_int_equal(bitmap_cardinality(b), 0);
+
+  bitmap_destroy(b);
+}
+
+static void test_bitmap_add_contains_remove(void **state)
+{
+  UNUSED(state);
+
+  bitmap_t *b = bitmap_new();
+
+  assert_int_equal(bitmap_add(b, 7), 0);
+  assert_int_equal(bitmap_add(b, 7), 0);
+  assert_int_equal(bitmap_add(b, 70000), 0);
+  assert_int_equal(bitmap_add(b, 0xFFFFFFFFU), 0);
+  assert_int_equal(bitmap_cardinality(b), 3);
+
+  assert_int_equal(bitmap_contains(b, 7), 1);
+  assert_int_equal(bitmap_contains(b, 8), 0);
+  assert_int_equal(bitmap_contains(b, 70000), 1);
+  assert_int_equal(bitmap_contains(b, 0xFFFFFFFFU), 1);
+
+  assert_int_equal(bitmap_remove(b, 7), 0);
+  assert_int_equal(bitmap_remove(b, 7), -1);
+  assert_int_equal(bitmap_contains(b, 7), 0);
+  assert_int_equal(bitmap_cardinality(b), 2);
+
+  bitmap_destroy(b);
+}
+
+static void test_bitmap_dense_chunk(void **state)
+{
+  UNUSED(state);
+
+  bitmap_t *b = bitmap_new();
+  uint32_t i;
+
+  for (i = 0; i < 10000; i++)
+  {
+    bitmap_add(b, i * 2);
+  }
+
+  assert_int_equal(bitmap_cardinality(b), 10000);
+  assert_int_equal(bitmap_contains(b, 4000), 1);
+  assert_int_equal(bitmap_contains(b, 4001), 0);
+
+  for (i = 0; i < 10000; i += 2)
+  {
+    assert_int_equal(bitmap_remove(b, i * 2), 0);
+  }
+
+  assert_int_equal(bitmap_cardinality(b), 5000);
+  assert_int_equal(bitmap_contains(b, 4), 0);
+  assert_int_equal(bitmap_contains(b, 6), 1);
+
+  bitmap_destroy(b);
+}
+
+static void test_bitmap_operations(void **state)
+{
+  UNUSED(state);
+
+  bitmap_t *a = bitmap_new();
+  bitmap_t *b = bitmap_new();
+  uint32_t i;
+
+  for (i = 0; i < 200000; i += 2)
+  {
+    bitmap_add(a, i);
+  }
+
+  for (i = 0; i < 200000; i += 3)
+  {
+    bitmap_add(b, i);
+  }
+
+  bitmap_t *n = bitmap_and(a, b);
+  bitmap_t *u = bitmap_or(a, b);
+  bitmap_t *x = bitmap_xor(a, b);
+
+  uint64_t both = 0;
+  uint64_t either = 0;
+
+  for (i = 0; i < 200000; i++)
+  {
+    const int in_a = (i % 2) == 0;
+    const int in_b = (i % 3) == 0;
+
+    both += (in_a && in_b);
+    either += (in_a || in_b);
+
+    assert_int_equal(bitmap_contains(n, i), in_a && in_b);
+    assert_int_equal(bitmap_contains(u, i), in_a || in_b);
+    assert_int_equal(bitmap_contains(x, i), in_a != in_b);
+  }
+
+  assert_int_equal(bitmap_cardinality(n), both);
+  assert_int_equal(bitmap_cardinality(u), either);
+  assert_int_equal(bitmap_cardinality(x), either - both);
+
+  bitmap_destroy(x);
+  bitmap_destroy(u);
+  bitmap_destroy(n);
+  bitmap_destroy(b);
+  bitmap_destroy(a);
+}
+
+static void test_bitmap_run_optimize(void **state)
+{
+  UNUSED(state);
+
+  bitmap_t *b = bitmap_new();
+  uint32_t i;
+
+  for (i = 1000; i < 60000; i++)
+  {
+    bitmap_add(b, i);
+  }
+
+  const size_t before = bitmap_memory(b);
+  bitmap_run_optimize(b);
+  assert_true(bitmap_memory(b) < before);
+
+  assert_int_equal(bitmap_cardinality(b), 59000);
+  assert_int_equal(bitmap_contains(b, 999), 0);
+  assert_int_equal(bitmap_contains(b, 1000), 1);
+  assert_int_equal(bitmap_contains(b, 59999), 1);
+  assert_int_equal(bitmap_contains(b, 60000), 0);
+
+  assert_int_equal(bitmap_add(b, 70000), 0);
+  assert_int_equal(bitmap_remove(b, 30000), 0);
+  assert_int_equal(bitmap_contains(b, 30000), 0);
+  assert_int_equal(bitmap_cardinality(b), 59000);
+
+  bitmap_destroy(b);
+}
+
+static void test_bitmap_to_array(void **state)
+{
+  UNUSED(state);
+
+  bitmap_t *b = bitmap_new();
+  const uint32_t values[] = {3, 65535, 65536, 1u << 20, 0xFFFFFFF0U};
+  uint32_t out[5] = {0};
+  size_t i;
+
+  for (i = 5; i > 0; i--)
+  {
+    bitmap_add(b, values[i - 1]);
+  }
+
+  assert_int_equal(bitmap_to_array(b, out), 5);
+  assert_memory_equal(out, values, sizeof(values));
+
+  bitmap_destroy(b);
+}
+
+int main(void)
+{
+  const struct CMUnitTest tests[] = {
+    cmocka_unit_test(test_bitmap_create_destroy),
+    cmocka_unit_test(test_bitmap_add_contains_remove),
+    cmocka_unit_test(test_bitmap_dense_chunk),
+    cmocka_unit_test(test_bitmap_operations),
+    cmocka_unit_test(test_bitmap_run_optimize),
+    cmocka_unit_test(test_bitmap_to_array),
+  };
+
+  return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,247 @@
+/*
+ * Copyright (C) 2025 Da'Jour J. Christophe. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <setjmp.h>
+
+#include "cmocka.h"
+
+#include "bloom.h"
+#include "common.h"
+#include "map.h"
+#include "set.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void test_bloom_create_destroy(void **state)
+{
+  UNUSED(state);
+
+  bloom_t *b = bloom_new(1000, 0.01);
+  assert_non_null(b);
+  assert_true(bloom_memory(b) > 0);
+
+  bloom_destroy(b);
+}
+
+static void test_bloom_bad_fpp(void **state)
+{
+  UNUSED(state);
+
+  assert_null(bloom_new(1000, 0.0));
+  assert_null(bloom_new(1000, 1.0));
+  assert_null(bloom_new(1000, -0.5));
+  assert_null(bloom_new(1000, 2.0));
+  assert_null(bloom_new(1000, NAN));
+}
+
+static void test_bloom_no_false_negatives(void **state)
+{
+  UNUSED(state);
+
+  bloom_t *b = bloom_new(10000, 0.01);
+  uint64_t i;
+
+  for (i = 0; i < 10000; i++)
+  {
+    bloom_add(b, &i, sizeof(i));
+  }
+
+  for (i = 0; i < 10000; i++)
+  {
+    assert_int_equal(bloom_contains(b, &i, sizeof(i)), 1);
+  }
+
+  bloom_destroy(b);
+}
+
+static void test_bloom_false_positive_rate(void **state)
+{
+  UNUSED(state);
+
+  bloom_t *b = bloom_new(10000, 0.01);
+  uint64_t positives = 0;
+  uint64_t i;
+
+  for (i = 0; i < 10000; i++)
+  {
+    bloom_add(b, &i, sizeof(i));
+  }
+
+  for (i = 10000; i < 110000; i++)
+  {
+    positives += (uint64_t)bloom_contains(b, &i, sizeof(i));
+  }
+
+  assert_true(positives < 2000);
+
+  bloom_clear(b);
+
+  for (i = 0; i < 10000; i++)
+  {
+    assert_int_equal(bloom_contains(b, &i, sizeof(i)), 0);
+  }
+
+  bloom_destroy(b);
+}
+
+static void test_bloom_set_filter(void **state)
+{
+  UNUSED(state);
+
+  set_t *s = set_new(64);
+  uint32_t i;
+
+  for (i = 0; i < 16; i++)
+  {
+    assert_int_equal(set_add(s, &i, sizeof(i)), 0);
+  }
+
+  assert_int_equal(set_enable_filter(s, 0.01), 0);
+  assert_non_null(s->filter);
+
+  for (i = 16; i < 32; i++)
+  {
+    assert_int_equal(set_add(s, &i, sizeof(i)), 0);
+  }
+
+  for (i = 0; i < 32; i++)
+  {
+    assert_int_equal(set_exists(s, &i, sizeof(i)), 1);
+  }
+
+  for (i = 32; i < 64; i++)
+  {
+    assert_int_equal(set_exists(s, &i, sizeof(i)), 0);
+  }
+
+  for (i = 0; i < 32; i += 2)
+  {
+    assert_int_equal(set_remove(s, &i, sizeof(i)), 0);
+    set_compact(s);
+  }
+
+  for (i = 0; i < 32; i++)
+  {
+    assert_int_equal(set_exists(s, &i, sizeof(i)), (int)(i % 2));
+  }
+
+  set_destroy(s);
+}
+
+static void test_bloom_bad_filter(void **state)
+{
+  UNUSED(state);
+
+  set_t *s = set_new(64);
+  map_t *m = map_new(64);
+  const bloom_t *filter = NULL;
+  uint32_t i;
+
+  for (i = 0; i < 32; i++)
+  {
+    assert_int_equal(set_add(s, &i, sizeof(i)), 0);
+    assert_int_equal(map_set(m, &i, sizeof(i), &i, sizeof(i)), 0);
+  }
+
+  assert_int_equal(set_enable_filter(s, 0.01), 0);
+  assert_int_equal(map_enable_filter(m, 0.01), 0);
+
+  /* a rejected rate leaves the working filter in place */
+  filter = s->filter;
+  assert_int_equal(set_enable_filter(s, 0.0), -1);
+  assert_true(s->filter == filter);
+
+  filter = m->filter;
+  assert_int_equal(map_enable_filter(m, 0.0), -1);
+  assert_true(m->filter == filter);
+
+  for (i = 0; i < 32; i++)
+  {
+    assert_int_equal(set_exists(s, &i, sizeof(i)), 1);
+    assert_int_equal(map_exists(m, &i, sizeof(i)), 1);
+  }
+
+  for (i = 32; i < 64; i++)
+  {
+    assert_int_equal(set_exists(s, &i, sizeof(i)), 0);
+    assert_int_equal(map_exists(m, &i, sizeof(i)), 0);
+  }
+
+  map_destroy(m);
+  set_destroy(s);
+}
+
+static void test_bloom_map_filter(void **state)
+{
+  UNUSED(state);
+
+  map_t *m = map_new(64);
+  uint32_t i;
+
+  assert_int_equal(map_enable_filter(m, 0.01), 0);
+
+  for (i = 0; i < 32; i++)
+  {
+    const uint32_t value = i * 10;
+    assert_int_equal(map_set(m, &i, sizeof(i), &value, sizeof(value)), 0);
+  }
+
+  for (i = 0; i < 32; i++)
+  {
+    size_t size = 0;
+    uint32_t *value = map_get(m, &i, sizeof(i), &size);
+    assert_non_null(value);
+    assert_int_equal(*value, i * 10);
+    free(value);
+  }
+
+  for (i = 32; i < 64; i++)
+  {
+    assert_int_equal(map_exists(m, &i, sizeof(i)), 0);
+  }
+
+  for (i = 0; i < 32; i += 2)
+  {
+    assert_int_equal(map_del(m, &i, sizeof(i)), 0);
+    map_compact(m);
+  }
+
+  for (i = 0; i < 32; i++)
+  {
+    assert_int_equal(map_exists(m, &i, sizeof(i)), (int)(i % 2));
+  }
+
+  map_destroy(m);
+}
+
+int main(void)
+{
+  const struct CMUnitTest tests[] = {
+    cmocka_unit_test(test_bloom_create_destroy),
+    cmocka_unit_test(test_bloom_bad_fpp),
+    cmocka_unit_test(test_bloom_no_false_negatives),
+    cmocka_unit_test(test_bloom_false_positive_rate),
+    cmocka_unit_test(test_bloom_set_filter),
+    cmocka_unit_test(test_bloom_bad_filter),
+    cmocka_unit_test(test_bloom_map_filter),
+  };
+
+  return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2025 Da'Jour J. Christophe. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <setjmp.h>
+
+#include "cmocka.h"
+
+#include "cms.h"
+#include "common.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static void test_cms_create_destroy(void **state)
+{
+  UNUSED(state);
+
+  cms_t *c = cms_new(1000, 4);
+  assert_non_null(c);
+  assert_int_equal(cms_total(c), 0);
+  assert_true(cms_memory(c) >= sizeof(uint32_t) * 1024 * 4);
+  cms_destroy(c);
+
+  assert_null(cms_new(0, 4));
+  assert_null(cms_new(1000, 0));
+  assert_null(cms_new(1000, CMS_MAX_DEPTH + 1));
+
+  c = cms_new_with_error(0.001, 0.01);
+  assert_non_null(c);
+  cms_destroy(c);
+
+  assert_null(cms_new_with_error(0.0, 0.01));
+
+  /* ln(1 / delta) rows, so delta must stay above e^-16 */
+  c = cms_new_with_error(0.01, 2e-7);
+  assert_non_null(c);
+  cms_destroy(c);
+  assert_null(cms_new_with_error(0.01, 1e-8));
+}
+
+static void test_cms_estimate(void **state)
+{
+  UNUSED(state);
+
+  const double epsilon = 0.001;
+  cms_t *c = cms_new_with_error(epsilon, 0.001);
+  uint64_t i;
+  uint64_t errors = 0;
+
+  /* key i appears (i % 10) + 1 times */
+  for (i = 0; i < 20000; i++)
+  {
+    assert_true(cms_add(c, &i, sizeof(i), (uint32_t)(i % 10) + 1) >= (i % 10) + 1);
+  }
+
+  const uint64_t total = cms_total(c);
+
+  for (i = 0; i < 20000; i++)
+  {
+    const uint32_t estimate = cms_estimate(c, &i, sizeof(i));
+
+    assert_true(estimate >= (i % 10) + 1);
+
+    if (estimate - ((i % 10) + 1) > epsilon * (double)total)
+    {
+      errors++;
+    }
+  }
+
+  assert_true(errors < 200);
+
+  cms_destroy(c);
+}
+
+static void test_cms_saturate(void **state)
+{
+  UNUSED(state);
+
+  cms_t *c = cms_new(64, 2);
+
+  cms_add_hash(c, 42, UINT32_MAX - 1);
+  assert_int_equal(cms_add_hash(c, 42, 10), UINT32_MAX);
+  assert_int_equal(cms_estimate_hash(c, 42), UINT32_MAX);
+
+  cms_destroy(c);
+}
+
+static void test_cms_merge(void **state)
+{
+  UNUSED(state);
+
+  cms_t *a = cms_new(4096, 4);
+  cms_t *b = cms_new(4096, 4);
+  cms_t *c = cms_new(4096, 5);
+  uint64_t i;
+
+  for (i = 0; i < 100; i++)
+  {
+    cms_add(a, &i, sizeof(i), 3);
+    cms_add(b, &i, sizeof(i), 4);
+  }
+
+  assert_int_equal(cms_merge(a, b), 0);
+  assert_int_equal(cms_total(a), 700);
+
+  for (i = 0; i < 100; i++)
+  {
+    assert_true(cms_estimate(a, &i, sizeof(i)) >= 7);
+  }
+
+  assert_int_equal(cms_merge(a, c), -1);
+
+  cms_destroy(a);
+  cms_destroy(b);
+  cms_destroy(c);
+}
+
+int main(void)
+{
+  const struct CMUnitTest tests[] = {
+    cmocka_unit_test(test_cms_create_destroy),
+    cmocka_unit_test(test_cms_estimate),
+    cmocka_unit_test(test_cms_saturate),
+    cmocka_unit_test(test_cms_merge),
+  };
+
+  return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,146 @@
+/*
+ * Copyright (C) 2025 Da'Jour J. Christophe. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <setjmp.h>
+
+#include "cmocka.h"
+
+#include "common.h"
+#include "cuckoo.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static void test_cuckoo_create_destroy(void **state)
+{
+  UNUSED(state);
+
+  cuckoo_t *c = cuckoo_new(1000, 12);
+  assert_non_null(c);
+  assert_int_equal(cuckoo_count(c), 0);
+  cuckoo_destroy(c);
+
+  assert_null(cuckoo_new(1000, 10));
+}
+
+static void test_cuckoo_add_contains_remove(void **state)
+{
+  UNUSED(state);
+
+  const unsigned int widths[] = {8, 12, 16};
+  size_t w;
+  uint64_t i;
+
+  for (w = 0; w < 3; w++)
+  {
+    cuckoo_t *c = cuckoo_new(10000, widths[w]);
+
+    for (i = 0; i < 9000; i++)
+    {
+      assert_int_equal(cuckoo_add(c, &i, sizeof(i)), 0);
+    }
+
+    assert_int_equal(cuckoo_count(c), 9000);
+
+    for (i = 0; i < 9000; i++)
+    {
+      assert_int_equal(cuckoo_contains(c, &i, sizeof(i)), 1);
+    }
+
+    for (i = 0; i < 9000; i += 2)
+    {
+      assert_int_equal(cuckoo_remove(c, &i, sizeof(i)), 0);
+    }
+
+    assert_int_equal(cuckoo_count(c), 4500);
+
+    for (i = 1; i < 9000; i += 2)
+    {
+      assert_int_equal(cuckoo_contains(c, &i, sizeof(i)), 1);
+    }
+
+    cuckoo_destroy(c);
+  }
+}
+
+static void test_cuckoo_false_positive_rate(void **state)
+{
+  UNUSED(state);
+
+  cuckoo_t *c = cuckoo_new(10000, 12);
+  uint64_t positives = 0;
+  uint64_t i;
+
+  for (i = 0; i < 9000; i++)
+  {
+    cuckoo_add(c, &i, sizeof(i));
+  }
+
+  for (i = 100000; i < 200000; i++)
+  {
+    positives += (uint64_t)cuckoo_contains(c, &i, sizeof(i));
+  }
+
+  const double expected = cuckoo_false_positive_rate(c);
+  assert_true(expected > 0.0 && expected < 0.01);
+  assert_true((double)positives / 100000.0 < 2.0 * expected);
+
+  cuckoo_destroy(c);
+}
+
+static void test_cuckoo_full(void **state)
+{
+  UNUSED(state);
+
+  cuckoo_t *c = cuckoo_new(64, 8);
+  uint64_t added = 0;
+  uint64_t i;
+
+  for (i = 0; i < 1000; i++)
+  {
+    if (0 > cuckoo_add(c, &i, sizeof(i)))
+    {
+      break;
+    }
+    added++;
+  }
+
+  assert_true(added < 1000);
+
+  for (i = 0; i < added; i++)
+  {
+    assert_int_equal(cuckoo_contains(c, &i, sizeof(i)), 1);
+  }
+
+  assert_int_equal(cuckoo_remove(c, &(uint64_t){0}, sizeof(uint64_t)), 0);
+  assert_int_equal(cuckoo_count(c), added - 1);
+
+  cuckoo_destroy(c);
+}
+
+int main(void)
+{
+  const struct CMUnitTest tests[] = {
+    cmocka_unit_test(test_cuckoo_create_destroy),
+    cmocka_unit_test(test_cuckoo_add_contains_remove),
+    cmocka_unit_test(test_cuckoo_false_positive_rate),
+    cmocka_unit_test(test_cuckoo_full),
+  };
+
+  return cmocka_run_group_tests(tests, NULL, NULL);
+}
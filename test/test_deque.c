@@ -13,6 +13,8 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdarg.h>
 #include <stddef.h>
 #include <stdint.h>
@@ -23,8 +25,17 @@
 #include "common.h"
 #include "deque.h"
 
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
 
 #define RING_BUFFER_CAPACITY 32UL
 
@@ -147,12 +158,1207 @@ static void ring_buffer_dequeue_test(void unused **state)
   ring_buffer_destroy(buffer);
 }
 
+static void ring_buffer_wrap_test(void unused **state)
+{
+  ring_buffer_t *buffer = NULL;
+  uint8_t record[12];
+  uint8_t *item = NULL;
+  uint64_t i;
+
+  buffer = ring_buffer_create(RING_BUFFER_CAPACITY);
+
+  assert_int_equal(0, ring_buffer_enqueue(buffer, record, sizeof(record)));
+  assert_int_equal(0, ring_buffer_enqueue(buffer, record, sizeof(record)));
+  assert_int_equal(-1, ring_buffer_enqueue(buffer, record, sizeof(record)));
+  free(ring_buffer_dequeue(buffer, sizeof(record)));
+  free(ring_buffer_dequeue(buffer, sizeof(record)));
+
+  /* 12-byte records in a 32-byte ring straddle the end every few rounds */
+  for (i = 0; i < 100; i++)
+  {
+    memset(record, (int)i, sizeof(record));
+    assert_int_equal(0, ring_buffer_enqueue(buffer, record, sizeof(record)));
+
+    item = ring_buffer_dequeue(buffer, sizeof(record));
+    assert_non_null(item);
+    assert_memory_equal(record, item, sizeof(record));
+    free(item);
+  }
+
+  assert_int_equal(0UL, ring_buffer_size(buffer));
+
+  ring_buffer_destroy(buffer);
+}
+
+static void ring_buffer_zero_copy_test(void unused **state)
+{
+  ring_buffer_t *buffer = NULL;
+  uint32_t *slot = NULL;
+  const uint32_t *front = NULL;
+  uint32_t item = 0U;
+  uint8_t record[16] = {0};
+
+  buffer = ring_buffer_create(RING_BUFFER_CAPACITY);
+
+  assert_null(ring_buffer_peek(buffer, sizeof(uint32_t)));
+  assert_int_equal(-1, ring_buffer_dequeue_into(buffer, &item, sizeof(item)));
+
+  slot = ring_buffer_reserve(buffer, sizeof(*slot));
+  assert_true((uint8_t *)slot == ring_buffer_get_data(buffer));
+  *slot = 55U;
+  assert_int_equal(0UL, ring_buffer_size(buffer));
+  ring_buffer_commit(buffer, sizeof(*slot));
+  assert_int_equal(sizeof(uint32_t), ring_buffer_size(buffer));
+
+  assert_int_equal(0, ring_buffer_enqueue(buffer, &(uint32_t){56U}, sizeof(uint32_t)));
+
+  front = ring_buffer_peek(buffer, sizeof(*front));
+  assert_non_null(front);
+  assert_int_equal(*front, 55U);
+  ring_buffer_release(buffer, sizeof(*front));
+
+  assert_int_equal(0, ring_buffer_dequeue_into(buffer, &item, sizeof(item)));
+  assert_int_equal(item, 56U);
+  assert_int_equal(0UL, ring_buffer_size(buffer));
+
+  /* at offset 8 a 12-byte record fits, at offset 20 a 16-byte one would wrap */
+  assert_non_null(ring_buffer_reserve(buffer, 12UL));
+  ring_buffer_commit(buffer, 12UL);
+  assert_null(ring_buffer_reserve(buffer, sizeof(record)));
+  assert_int_equal(0, ring_buffer_enqueue(buffer, record, sizeof(record)));
+
+  assert_non_null(ring_buffer_peek(buffer, 12UL));
+  ring_buffer_release(buffer, 12UL);
+  assert_null(ring_buffer_peek(buffer, sizeof(record)));
+  assert_int_equal(0, ring_buffer_dequeue_into(buffer, record, sizeof(record)));
+  assert_int_equal(0UL, ring_buffer_size(buffer));
+
+  ring_buffer_destroy(buffer);
+}
+
+static void ring_buffer_bulk_test(void unused **state)
+{
+  ring_buffer_t *buffer = NULL;
+  uint32_t in[10];
+  uint32_t out[10];
+  uint32_t i;
+
+  buffer = ring_buffer_create(RING_BUFFER_CAPACITY);
+
+  for (i = 0U; i < 10U; i++)
+  {
+    in[i] = i;
+  }
+
+  assert_int_equal(ring_buffer_enqueue_bulk(buffer, in, sizeof(*in), 10UL), 8UL);
+  assert_int_equal(ring_buffer_enqueue_bulk(buffer, in, sizeof(*in), 10UL), 0UL);
+  assert_int_equal(ring_buffer_dequeue_bulk(buffer, out, sizeof(*out), 3UL), 3UL);
+  assert_memory_equal(in, out, 3 * sizeof(*in));
+
+  /* the second batch wraps past the end and is copied in two pieces */
+  assert_int_equal(ring_buffer_enqueue_bulk(buffer, in + 8, sizeof(*in), 2UL), 2UL);
+  assert_int_equal(ring_buffer_dequeue_bulk(buffer, out, sizeof(*out), 10UL), 7UL);
+  assert_memory_equal(in + 3, out, 7 * sizeof(*in));
+  assert_int_equal(ring_buffer_dequeue_bulk(buffer, out, sizeof(*out), 10UL), 0UL);
+
+  ring_buffer_destroy(buffer);
+}
+
+static void ring_buffer_mirrored_test(void unused **state)
+{
+  ring_buffer_t *buffer = NULL;
+  uint8_t record[100];
+  uint8_t out[100];
+  uint8_t *slot = NULL;
+  const uint8_t *front = NULL;
+  size_t cap;
+  uint64_t i;
+
+  buffer = ring_buffer_create_mirrored(RING_BUFFER_CAPACITY);
+  assert_non_null(buffer);
+
+  cap = ring_buffer_get_cap(buffer);
+  assert_true(cap >= 4096UL);
+  assert_int_equal(cap & (cap - 1), 0UL);
+
+  /* the second mapping shows the same bytes */
+  ring_buffer_get_data(buffer)[cap + 7] = 42U;
+  assert_int_equal(ring_buffer_get_data(buffer)[7], 42U);
+  ring_buffer_get_data(buffer)[7] = 0U;
+
+  /* 100-byte records straddle the end every few dozen rounds */
+  for (i = 0; i < 1000; i++)
+  {
+    memset(record, (int)i, sizeof(record));
+
+    if (i & 1)
+    {
+      slot = ring_buffer_reserve(buffer, sizeof(record));
+      assert_non_null(slot);
+      memcpy(slot, record, sizeof(record));
+      ring_buffer_commit(buffer, sizeof(record));
+
+      front = ring_buffer_peek(buffer, sizeof(record));
+      assert_non_null(front);
+      assert_memory_equal(front, record, sizeof(record));
+      ring_buffer_release(buffer, sizeof(record));
+    }
+    else
+    {
+      assert_int_equal(0, ring_buffer_enqueue(buffer, record, sizeof(record)));
+      assert_int_equal(0, ring_buffer_dequeue_into(buffer, out, sizeof(out)));
+      assert_memory_equal(out, record, sizeof(record));
+    }
+  }
+
+  assert_int_equal(0UL, ring_buffer_size(buffer));
+
+  ring_buffer_destroy(buffer);
+}
+
+#define RING_BUFFER_MESSAGES 200000UL
+
+static void ring_buffer_growable_test(void unused **state)
+{
+  ring_buffer_t *buffer = NULL;
+  uint32_t in[256];
+  uint32_t out[256];
+  uint32_t item = 0U;
+  uint32_t i;
+
+  buffer = ring_buffer_create_growable(64UL);
+  assert_int_equal(ring_buffer_get_cap(buffer), 64UL);
+
+  /* offset the cursors so the first growth has a wrapped region to unroll */
+  for (i = 0U; i < 10U; i++)
+  {
+    assert_int_equal(0, ring_buffer_enqueue(buffer, &i, sizeof(i)));
+    assert_int_equal(0, ring_buffer_dequeue_into(buffer, &item, sizeof(item)));
+  }
+
+  for (i = 0U; i < 1000U; i++)
+  {
+    assert_int_equal(0, ring_buffer_enqueue(buffer, &i, sizeof(i)));
+  }
+
+  assert_int_equal(ring_buffer_get_cap(buffer), 4096UL);
+  assert_int_equal(ring_buffer_size(buffer), 4000UL);
+
+  for (i = 0U; i < 1000U; i++)
+  {
+    assert_int_equal(0, ring_buffer_dequeue_into(buffer, &item, sizeof(item)));
+    assert_int_equal(item, i);
+    /* shrinking leaves the ring at most a quarter full */
+    assert_true(ring_buffer_size(buffer) * 8UL > ring_buffer_get_cap(buffer) ||
+                ring_buffer_get_cap(buffer) == 64UL);
+  }
+
+  assert_int_equal(ring_buffer_get_cap(buffer), 64UL);
+  assert_int_equal(-1, ring_buffer_dequeue_into(buffer, &item, sizeof(item)));
+
+  /* bulk and reserve grow too */
+  for (i = 0U; i < 256U; i++)
+  {
+    in[i] = i * 3U;
+  }
+
+  assert_int_equal(256UL, ring_buffer_enqueue_bulk(buffer, in, sizeof(*in), 256UL));
+  assert_non_null(ring_buffer_reserve(buffer, 2048UL));
+  assert_true(ring_buffer_get_cap(buffer) >= 3072UL);
+  assert_int_equal(256UL, ring_buffer_dequeue_bulk(buffer, out, sizeof(*out), 256UL));
+  assert_memory_equal(in, out, sizeof(in));
+
+  ring_buffer_destroy(buffer);
+}
+
+static void ring_buffer_fd_test(void unused **state)
+{
+  ring_buffer_t *buffer = NULL;
+  uint8_t in[48];
+  uint8_t out[48];
+  uint8_t skip[20];
+  int fds[2];
+  size_t i;
+
+  for (i = 0UL; i < sizeof(in); i++)
+  {
+    in[i] = (uint8_t)(i * 7UL + 1UL);
+  }
+
+  buffer = ring_buffer_create(64UL);
+  assert_int_equal(0, pipe(fds));
+
+  /* put the readable bytes across the end of the buffer */
+  assert_int_equal(0, ring_buffer_enqueue(buffer, skip, sizeof(skip)));
+  assert_int_equal(0, ring_buffer_dequeue_into(buffer, skip, sizeof(skip)));
+  assert_int_equal(0, ring_buffer_enqueue(buffer, in, sizeof(in)));
+
+  assert_int_equal(16, ring_buffer_write_fd(buffer, fds[1], 16UL));
+  assert_int_equal(32, ring_buffer_write_fd(buffer, fds[1], SIZE_MAX));
+  assert_int_equal(0, ring_buffer_write_fd(buffer, fds[1], SIZE_MAX));
+  assert_int_equal(0UL, ring_buffer_size(buffer));
+
+  assert_int_equal(sizeof(out), read(fds[0], out, sizeof(out)));
+  assert_memory_equal(in, out, sizeof(in));
+
+  /* and read them back in, again across the end */
+  assert_int_equal(sizeof(in), write(fds[1], in, sizeof(in)));
+  assert_int_equal(sizeof(in), ring_buffer_read_fd(buffer, fds[0], SIZE_MAX));
+  assert_int_equal(0, ring_buffer_dequeue_into(buffer, out, sizeof(out)));
+  assert_memory_equal(in, out, sizeof(in));
+
+  for (i = 0UL; i < 64UL; i += sizeof(in) / 3UL)
+  {
+    assert_int_equal(sizeof(in) / 3UL, write(fds[1], in, sizeof(in) / 3UL));
+    assert_int_equal(sizeof(in) / 3UL, ring_buffer_read_fd(buffer, fds[0], SIZE_MAX));
+  }
+
+  assert_int_equal(-1, ring_buffer_read_fd(buffer, fds[0], SIZE_MAX));
+  assert_int_equal(errno, ENOBUFS);
+
+  close(fds[0]);
+  close(fds[1]);
+  ring_buffer_destroy(buffer);
+}
+
+static void ring_buffer_uring_test(void unused **state)
+{
+  ring_buffer_t *buffer = NULL;
+  ring_buffer_uring_t *uring = NULL;
+  char path[] = "/tmp/doctrina_uring_XXXXXX";
+  uint64_t out[512];
+  uint64_t sent = 0UL;
+  uint64_t i;
+  ssize_t n;
+  int fd;
+
+  buffer = ring_buffer_create(1024UL);
+  fd = mkstemp(path);
+  assert_true(fd >= 0);
+  unlink(path);
+
+  uring = ring_buffer_uring_create(buffer, fd);
+  if (uring == NULL)
+  {
+    /* io_uring is not available here */
+    close(fd);
+    ring_buffer_destroy(buffer);
+    return;
+  }
+
+  /* refill between flushes so later writes start mid-buffer and wrap */
+  for (i = 0UL; i < 512UL; i++)
+  {
+    while (0 > ring_buffer_enqueue(buffer, &i, sizeof(i)))
+    {
+      n = ring_buffer_uring_flush(uring, 1);
+      assert_true(n >= 0);
+      sent += (uint64_t)n;
+    }
+  }
+
+  while (sent < sizeof(out))
+  {
+    n = ring_buffer_uring_flush(uring, 1);
+    assert_true(n >= 0);
+    sent += (uint64_t)n;
+  }
+
+  assert_int_equal(0UL, ring_buffer_size(buffer));
+  assert_int_equal(sizeof(out), pread(fd, out, sizeof(out), 0));
+
+  for (i = 0UL; i < 512UL; i++)
+  {
+    assert_int_equal(out[i], i);
+  }
+
+  ring_buffer_uring_destroy(uring);
+  ring_buffer_destroy(buffer);
+
+  /* a failed write is reported once its chain completes */
+  buffer = ring_buffer_create(1024UL);
+  uring = ring_buffer_uring_create(buffer, -1);
+  assert_non_null(uring);
+  assert_int_equal(0, ring_buffer_enqueue(buffer, &i, sizeof(i)));
+  assert_int_equal(-1, ring_buffer_uring_flush(uring, 1));
+  assert_int_equal(errno, EBADF);
+
+  ring_buffer_uring_destroy(uring);
+  ring_buffer_destroy(buffer);
+  close(fd);
+}
+
+static void *ring_buffer_producer(void *arg)
+{
+  ring_buffer_t *buffer = arg;
+  uint64_t i;
+
+  for (i = 0; i < RING_BUFFER_MESSAGES; i++)
+  {
+    while (0 > ring_buffer_enqueue(buffer, &i, sizeof(i)))
+    {
+      sched_yield();
+    }
+  }
+
+  return NULL;
+}
+
+static void ring_buffer_threads_test(void unused **state)
+{
+  ring_buffer_t *buffer = NULL;
+  pthread_t producer;
+  uint64_t *item = NULL;
+  uint64_t i;
+
+  buffer = ring_buffer_create(RING_BUFFER_CAPACITY);
+
+  assert_int_equal(0, pthread_create(&producer, NULL, ring_buffer_producer, buffer));
+
+  for (i = 0; i < RING_BUFFER_MESSAGES; i++)
+  {
+    while (NULL == (item = ring_buffer_dequeue(buffer, sizeof(*item))))
+    {
+      sched_yield();
+    }
+
+    assert_int_equal(*item, i);
+    free(item);
+  }
+
+  pthread_join(producer, NULL);
+  assert_int_equal(0UL, ring_buffer_size(buffer));
+
+  ring_buffer_destroy(buffer);
+}
+
+static void ring_buffer_frame_test(void unused **state)
+{
+  ring_buffer_t *buffer = NULL;
+  const uint8_t *frame = NULL;
+  uint8_t record[100];
+  uint8_t *slot = NULL;
+  size_t len = 0UL;
+  size_t i;
+  size_t j;
+
+  buffer = ring_buffer_create(256UL);
+  assert_null(ring_buffer_read_frame(buffer, &len));
+
+  /* lengths that are not multiples of 8, so frames wrap at every offset */
+  for (i = 0UL; i < 1000UL; i++)
+  {
+    len = i % 97UL;
+    memset(record, (int)i, len);
+    assert_int_equal(0, ring_buffer_write_frame(buffer, record, len));
+
+    frame = ring_buffer_read_frame(buffer, &len);
+    assert_non_null(frame);
+    assert_int_equal(len, i % 97UL);
+    assert_int_equal(0UL, (uintptr_t)frame % 8UL);
+
+    for (j = 0UL; j < len; j++)
+    {
+      assert_int_equal(frame[j], (uint8_t)i);
+    }
+
+    ring_buffer_release_frame(buffer, len);
+  }
+
+  assert_int_equal(0UL, ring_buffer_size(buffer));
+
+  /* a frame larger than the ring is refused, several small ones queue up */
+  assert_int_equal(-1, ring_buffer_write_frame(buffer, record, 300UL));
+
+  for (i = 0UL; i < 5UL; i++)
+  {
+    assert_int_equal(0, ring_buffer_write_frame(buffer, &i, sizeof(i)));
+  }
+
+  for (i = 0UL; i < 5UL; i++)
+  {
+    frame = ring_buffer_read_frame(buffer, &len);
+    assert_int_equal(len, sizeof(i));
+    assert_memory_equal(frame, &i, sizeof(i));
+    ring_buffer_release_frame(buffer, len);
+  }
+
+  /* reserve for the worst case and commit what was written */
+  slot = ring_buffer_reserve_frame(buffer, 64UL);
+  assert_non_null(slot);
+  memcpy(slot, "hello", 5UL);
+  ring_buffer_commit_frame(buffer, 5UL);
+
+  frame = ring_buffer_read_frame(buffer, &len);
+  assert_int_equal(len, 5UL);
+  assert_memory_equal(frame, "hello", 5UL);
+  ring_buffer_release_frame(buffer, len);
+  assert_int_equal(0UL, ring_buffer_size(buffer));
+
+  ring_buffer_destroy(buffer);
+
+  /* a fixed ring refuses frames over half its capacity at any offset */
+  buffer = ring_buffer_create(64UL);
+
+  assert_int_equal(-1, ring_buffer_write_frame(buffer, record, 40UL));
+  assert_int_equal(0, ring_buffer_write_frame(buffer, record, 24UL));
+  ring_buffer_read_frame(buffer, &len);
+  ring_buffer_release_frame(buffer, len);
+
+  assert_int_equal(-1, ring_buffer_write_frame(buffer, record, 40UL));
+  assert_int_equal(0, ring_buffer_write_frame(buffer, record, 24UL));
+  ring_buffer_read_frame(buffer, &len);
+  ring_buffer_release_frame(buffer, len);
+
+  /* half the ring fits even when the cursor forces a pad */
+  assert_int_equal(0, ring_buffer_write_frame(buffer, record, 8UL));
+  ring_buffer_read_frame(buffer, &len);
+  ring_buffer_release_frame(buffer, len);
+  assert_int_equal(0, ring_buffer_write_frame(buffer, record, 24UL));
+  frame = ring_buffer_read_frame(buffer, &len);
+  assert_non_null(frame);
+  assert_int_equal(len, 24UL);
+  ring_buffer_release_frame(buffer, len);
+
+  ring_buffer_destroy(buffer);
+
+  /* a growable ring takes them, growing past the pad if it must */
+  buffer = ring_buffer_create_growable(64UL);
+
+  assert_int_equal(0, ring_buffer_write_frame(buffer, record, 24UL));
+  ring_buffer_read_frame(buffer, &len);
+  ring_buffer_release_frame(buffer, len);
+  assert_int_equal(0, ring_buffer_write_frame(buffer, record, 40UL));
+  frame = ring_buffer_read_frame(buffer, &len);
+  assert_non_null(frame);
+  assert_int_equal(len, 40UL);
+  ring_buffer_release_frame(buffer, len);
+
+  ring_buffer_destroy(buffer);
+
+  /* a growable ring keeps a live pad frame readable across a resize */
+  buffer = ring_buffer_create_growable(64UL);
+
+  for (i = 0UL; i < 2UL; i++)
+  {
+    memset(record, (int)i, 16UL);
+    assert_int_equal(0, ring_buffer_write_frame(buffer, record, 16UL));
+  }
+
+  ring_buffer_read_frame(buffer, &len);
+  ring_buffer_release_frame(buffer, len);
+
+  /* pads the last 16 bytes and wraps, then forces a resize */
+  for (i = 2UL; i < 20UL; i++)
+  {
+    memset(record, (int)i, 16UL);
+    assert_int_equal(0, ring_buffer_write_frame(buffer, record, 16UL));
+  }
+
+  assert_true(ring_buffer_get_cap(buffer) > 64UL);
+
+  for (i = 1UL; i < 20UL; i++)
+  {
+    frame = ring_buffer_read_frame(buffer, &len);
+    assert_non_null(frame);
+    assert_int_equal(len, 16UL);
+    assert_int_equal(frame[15], (uint8_t)i);
+    ring_buffer_release_frame(buffer, len);
+  }
+
+  assert_null(ring_buffer_read_frame(buffer, &len));
+
+  ring_buffer_destroy(buffer);
+}
+
+static void *ring_buffer_frame_producer(void *arg)
+{
+  ring_buffer_t *buffer = arg;
+  uint64_t record[8];
+  uint64_t i;
+
+  for (i = 0; i < RING_BUFFER_MESSAGES; i++)
+  {
+    record[0] = i;
+
+    while (0 > ring_buffer_write_frame(buffer, record, sizeof(uint64_t) * (1UL + i % 8UL)))
+    {
+      sched_yield();
+    }
+  }
+
+  return NULL;
+}
+
+static void ring_buffer_frame_threads_test(void unused **state)
+{
+  ring_buffer_t *buffer = NULL;
+  const uint64_t *frame = NULL;
+  pthread_t producer;
+  size_t len = 0UL;
+  uint64_t i;
+
+  buffer = ring_buffer_create(256UL);
+
+  assert_int_equal(0, pthread_create(&producer, NULL, ring_buffer_frame_producer, buffer));
+
+  for (i = 0; i < RING_BUFFER_MESSAGES; i++)
+  {
+    while (NULL == (frame = ring_buffer_read_frame(buffer, &len)))
+    {
+      sched_yield();
+    }
+
+    assert_int_equal(len, sizeof(uint64_t) * (1UL + i % 8UL));
+    assert_int_equal(frame[0], i);
+    ring_buffer_release_frame(buffer, len);
+  }
+
+  pthread_join(producer, NULL);
+  assert_int_equal(0UL, ring_buffer_size(buffer));
+
+  ring_buffer_destroy(buffer);
+}
+
+static void ring_buffer_wait_test(void unused **state)
+{
+  ring_buffer_t *buffer = NULL;
+  struct timespec start;
+  struct timespec end;
+  uint64_t events = 0UL;
+  uint64_t item = 7UL;
+  int fd;
+
+  buffer = ring_buffer_create(RING_BUFFER_CAPACITY);
+
+  assert_int_equal(-1, ring_buffer_wait_nonempty(buffer, sizeof(item), 0));
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  assert_int_equal(-1, ring_buffer_wait_nonempty(buffer, sizeof(item), 20));
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  assert_true((end.tv_sec - start.tv_sec) * 1000L + (end.tv_nsec - start.tv_nsec) / 1000000L >= 20L);
+
+  assert_int_equal(0, ring_buffer_wait_nonfull(buffer, RING_BUFFER_CAPACITY, 0));
+  assert_int_equal(-1, ring_buffer_wait_nonfull(buffer, RING_BUFFER_CAPACITY + 1UL, 0));
+
+  /* an armed poll makes the next publish signal the eventfd */
+  fd = ring_buffer_get_eventfd(buffer);
+  assert_true(fd >= 0);
+  assert_int_equal(-1, read(fd, &events, sizeof(events)));
+
+  assert_int_equal(-1, ring_buffer_wait_nonempty(buffer, sizeof(item), 0));
+  assert_int_equal(0, ring_buffer_enqueue(buffer, &item, sizeof(item)));
+  assert_int_equal(sizeof(events), read(fd, &events, sizeof(events)));
+  assert_int_equal(events, 1UL);
+
+  assert_int_equal(0, ring_buffer_wait_nonempty(buffer, sizeof(item), -1));
+
+  /* nobody is waiting now, so further publishes stay quiet */
+  assert_int_equal(0, ring_buffer_enqueue(buffer, &item, sizeof(item)));
+  assert_int_equal(-1, read(fd, &events, sizeof(events)));
+
+  ring_buffer_destroy(buffer);
+}
+
+static void *ring_buffer_blocking_producer(void *arg)
+{
+  ring_buffer_t *buffer = arg;
+  uint64_t i;
+
+  for (i = 0; i < RING_BUFFER_MESSAGES; i++)
+  {
+    while (0 > ring_buffer_enqueue(buffer, &i, sizeof(i)))
+    {
+      assert_int_equal(0, ring_buffer_wait_nonfull(buffer, sizeof(i), -1));
+    }
+
+    /* go quiet now and then so the consumer falls asleep */
+    if (i % 50000UL == 0UL)
+    {
+      nanosleep(&(struct timespec){ 0, 2000000L }, NULL);
+    }
+  }
+
+  return NULL;
+}
+
+static void ring_buffer_blocking_threads_test(void unused **state)
+{
+  ring_buffer_t *buffer = NULL;
+  pthread_t producer;
+  uint64_t item = 0UL;
+  uint64_t i;
+
+  buffer = ring_buffer_create(RING_BUFFER_CAPACITY);
+
+  assert_int_equal(0, pthread_create(&producer, NULL, ring_buffer_blocking_producer, buffer));
+
+  for (i = 0; i < RING_BUFFER_MESSAGES; i++)
+  {
+    assert_int_equal(0, ring_buffer_wait_nonempty(buffer, sizeof(item), -1));
+    assert_int_equal(0, ring_buffer_dequeue_into(buffer, &item, sizeof(item)));
+    assert_int_equal(item, i);
+  }
+
+  pthread_join(producer, NULL);
+  assert_int_equal(0UL, ring_buffer_size(buffer));
+
+  ring_buffer_destroy(buffer);
+}
+
+static void ring_buffer_shared_test(void unused **state)
+{
+  ring_buffer_t *writer = NULL;
+  ring_buffer_t *reader = NULL;
+  const uint64_t *frame = NULL;
+  char name[64];
+  size_t len = 0UL;
+  uint64_t record[4];
+  uint64_t i;
+  pid_t child;
+  int status = 0;
+  int fd;
+
+  snprintf(name, sizeof(name), "/doctrina_ring_%ld", (long)getpid());
+  shm_unlink(name);
+
+  assert_null(ring_buffer_attach_shared(name));
+
+  writer = ring_buffer_create_shared(name, 4096UL);
+  assert_non_null(writer);
+  assert_null(ring_buffer_create_shared(name, 4096UL));
+  assert_int_equal(ring_buffer_get_eventfd(writer), -1);
+
+  /* a second mapping of the same ring lands at another address */
+  reader = ring_buffer_attach_shared(name);
+  assert_non_null(reader);
+  assert_true(reader != writer);
+  assert_int_equal(ring_buffer_get_cap(reader), 4096UL);
+
+  for (i = 0UL; i < 1000UL; i++)
+  {
+    record[0] = i;
+    assert_int_equal(0, ring_buffer_write_frame(writer, record, sizeof(uint64_t) * (1UL + i % 4UL)));
+
+    frame = ring_buffer_read_frame(reader, &len);
+    assert_non_null(frame);
+    assert_int_equal(len, sizeof(uint64_t) * (1UL + i % 4UL));
+    assert_int_equal(frame[0], i);
+    ring_buffer_release_frame(reader, len);
+  }
+
+  ring_buffer_destroy(writer);
+
+  /* a child process writes into the ring while this one reads */
+  child = fork();
+  assert_true(child >= 0);
+
+  if (child == 0)
+  {
+    writer = ring_buffer_attach_shared(name);
+
+    for (i = 0UL; writer != NULL && i < RING_BUFFER_MESSAGES; i++)
+    {
+      record[0] = i;
+
+      while (0 > ring_buffer_write_frame(writer, record, sizeof(uint64_t) * (1UL + i % 4UL)))
+      {
+        ring_buffer_wait_nonfull(writer, 64UL, -1);
+      }
+    }
+
+    _exit(writer == NULL ? EXIT_FAILURE : EXIT_SUCCESS);
+  }
+
+  for (i = 0UL; i < RING_BUFFER_MESSAGES; i++)
+  {
+    assert_int_equal(0, ring_buffer_wait_nonempty(reader, sizeof(uint64_t), -1));
+
+    frame = ring_buffer_read_frame(reader, &len);
+    assert_non_null(frame);
+    assert_int_equal(frame[0], i);
+    ring_buffer_release_frame(reader, len);
+  }
+
+  assert_int_equal(child, waitpid(child, &status, 0));
+  assert_true(WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS);
+
+  ring_buffer_destroy(reader);
+  shm_unlink(name);
+
+  /* memory that does not hold a ring is refused */
+  fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+  assert_true(fd >= 0);
+  assert_int_equal(0, ftruncate(fd, 8192));
+  assert_null(ring_buffer_attach_fd(fd));
+  close(fd);
+  shm_unlink(name);
+}
+
+static void mpmc_queue_test(void unused **state)
+{
+  mpmc_queue_t *queue = NULL;
+  mpmc_queue_stats_t stats;
+  uint32_t item = 0U;
+  uint32_t i;
+
+  queue = mpmc_queue_create(6UL, sizeof(uint32_t));
+  assert_int_equal(mpmc_queue_get_cap(queue), 8UL);
+
+  assert_int_equal(-1, mpmc_queue_dequeue(queue, &item));
+
+  for (i = 0U; i < 8U; i++)
+  {
+    assert_int_equal(0, mpmc_queue_enqueue(queue, &i));
+  }
+
+  assert_int_equal(-1, mpmc_queue_enqueue(queue, &i));
+  assert_int_equal(8UL, mpmc_queue_size(queue));
+
+  for (i = 0U; i < 8U; i++)
+  {
+    assert_int_equal(0, mpmc_queue_dequeue(queue, &item));
+    assert_int_equal(item, i);
+  }
+
+  assert_int_equal(0UL, mpmc_queue_size(queue));
+
+  mpmc_queue_get_stats(queue, &stats);
+  assert_int_equal(stats.full, 1UL);
+  assert_int_equal(stats.empty, 1UL);
+
+  mpmc_queue_destroy(queue);
+}
+
+static void mpmc_queue_bulk_test(void unused **state)
+{
+  mpmc_queue_t *queue = NULL;
+  uint32_t in[12];
+  uint32_t out[12];
+  uint32_t i;
+
+  queue = mpmc_queue_create(8UL, sizeof(uint32_t));
+
+  for (i = 0U; i < 12U; i++)
+  {
+    in[i] = i;
+  }
+
+  assert_int_equal(mpmc_queue_dequeue_bulk(queue, out, 4UL), 0UL);
+  assert_int_equal(mpmc_queue_enqueue_bulk(queue, in, 12UL), 8UL);
+  assert_int_equal(mpmc_queue_enqueue_bulk(queue, in, 1UL), 0UL);
+  assert_int_equal(mpmc_queue_dequeue_bulk(queue, out, 5UL), 5UL);
+  assert_memory_equal(in, out, 5 * sizeof(*in));
+  assert_int_equal(mpmc_queue_enqueue_bulk(queue, in + 8, 4UL), 4UL);
+  assert_int_equal(mpmc_queue_dequeue_bulk(queue, out, 12UL), 7UL);
+  assert_memory_equal(in + 5, out, 7 * sizeof(*in));
+
+  mpmc_queue_destroy(queue);
+}
+
+#define MPMC_THREADS 4UL
+
+struct mpmc_worker
+{
+  mpmc_queue_t *queue;
+  uint64_t      id;
+  uint64_t      sum;
+  uint64_t     *received;
+};
+
+static void *mpmc_producer(void *arg)
+{
+  struct mpmc_worker *self = arg;
+  uint64_t batch[16];
+  size_t sent;
+  size_t n;
+  uint64_t i;
+
+  /* odd producers send in batches */
+  for (i = 0; i < RING_BUFFER_MESSAGES; i += n)
+  {
+    const size_t count = self->id & 1 ? 16 : 1;
+
+    for (n = 0; n < count && i + n < RING_BUFFER_MESSAGES; n++)
+    {
+      batch[n] = self->id * RING_BUFFER_MESSAGES + i + n;
+    }
+
+    sent = 0;
+
+    while ((sent += mpmc_queue_enqueue_bulk(self->queue, batch + sent, n - sent)) < n)
+    {
+      sched_yield();
+    }
+  }
+
+  return NULL;
+}
+
+static void *mpmc_consumer(void *arg)
+{
+  struct mpmc_worker *self = arg;
+  uint64_t message;
+
+  while (__atomic_fetch_add(self->received, 1UL, __ATOMIC_RELAXED) < MPMC_THREADS * RING_BUFFER_MESSAGES)
+  {
+    while (0 > mpmc_queue_dequeue(self->queue, &message))
+    {
+      sched_yield();
+    }
+
+    self->sum += message;
+  }
+
+  return NULL;
+}
+
+static void mpmc_queue_threads_test(void unused **state)
+{
+  const uint64_t total = MPMC_THREADS * RING_BUFFER_MESSAGES;
+  mpmc_queue_t *queue = mpmc_queue_create(64UL, sizeof(uint64_t));
+  struct mpmc_worker producers[MPMC_THREADS];
+  struct mpmc_worker consumers[MPMC_THREADS];
+  pthread_t threads[2 * MPMC_THREADS];
+  uint64_t received = 0UL;
+  uint64_t sum = 0UL;
+  uint64_t i;
+
+  for (i = 0; i < MPMC_THREADS; i++)
+  {
+    producers[i] = (struct mpmc_worker){queue, i, 0UL, NULL};
+    consumers[i] = (struct mpmc_worker){queue, i, 0UL, &received};
+
+    assert_int_equal(0, pthread_create(&threads[i], NULL, mpmc_producer, &producers[i]));
+    assert_int_equal(0, pthread_create(&threads[MPMC_THREADS + i], NULL, mpmc_consumer, &consumers[i]));
+  }
+
+  for (i = 0; i < 2 * MPMC_THREADS; i++)
+  {
+    pthread_join(threads[i], NULL);
+  }
+
+  for (i = 0; i < MPMC_THREADS; i++)
+  {
+    sum += consumers[i].sum;
+  }
+
+  /* every message arrives exactly once */
+  assert_int_equal(sum, total * (total - 1) / 2);
+  assert_int_equal(0UL, mpmc_queue_size(queue));
+
+  mpmc_queue_destroy(queue);
+}
+
+static void broadcast_ring_test(void unused **state)
+{
+  broadcast_ring_t *ring = NULL;
+  uint32_t i;
+  int logger;
+  int metrics;
+  int forwarder;
+  int deps[2];
+
+  ring = broadcast_ring_create(6UL, sizeof(uint32_t));
+  assert_int_equal(broadcast_ring_get_cap(ring), 8UL);
+
+  logger = broadcast_ring_add_consumer(ring, NULL, 0UL);
+  metrics = broadcast_ring_add_consumer(ring, NULL, 0UL);
+  deps[0] = logger;
+  deps[1] = metrics;
+  forwarder = broadcast_ring_add_consumer(ring, deps, 2UL);
+  assert_int_equal(forwarder, 2);
+
+  deps[0] = 7;
+  assert_int_equal(-1, broadcast_ring_add_consumer(ring, deps, 1UL));
+
+  assert_int_equal(0UL, broadcast_ring_available(ring, logger));
+
+  for (i = 0U; i < 8U; i++)
+  {
+    assert_int_equal(0, broadcast_ring_publish(ring, &i));
+  }
+
+  /* the ring is full until every consumer is past the oldest slot */
+  assert_int_equal(-1, broadcast_ring_publish(ring, &i));
+
+  assert_int_equal(8UL, broadcast_ring_available(ring, logger));
+  assert_int_equal(8UL, broadcast_ring_available(ring, metrics));
+  assert_int_equal(0UL, broadcast_ring_available(ring, forwarder));
+
+  for (i = 0U; i < 8U; i++)
+  {
+    assert_int_equal(*(const uint32_t *)broadcast_ring_peek(ring, logger, i), i);
+    assert_true(broadcast_ring_peek(ring, logger, i) == broadcast_ring_peek(ring, metrics, i));
+  }
+
+  broadcast_ring_release(ring, logger, 8UL);
+  broadcast_ring_release(ring, metrics, 3UL);
+
+  /* the forwarder waits for the slower of its dependencies */
+  assert_int_equal(3UL, broadcast_ring_available(ring, forwarder));
+  assert_int_equal(*(const uint32_t *)broadcast_ring_peek(ring, forwarder, 2UL), 2U);
+  assert_int_equal(-1, broadcast_ring_publish(ring, &i));
+
+  broadcast_ring_release(ring, forwarder, 3UL);
+
+  for (i = 8U; i < 11U; i++)
+  {
+    assert_int_equal(0, broadcast_ring_publish(ring, &i));
+  }
+
+  assert_null(broadcast_ring_reserve(ring));
+
+  broadcast_ring_destroy(ring);
+}
+
+struct broadcast_worker
+{
+  broadcast_ring_t *ring;
+  int id;
+  uint64_t *seen[2];
+};
+
+static void *broadcast_consumer(void *arg)
+{
+  struct broadcast_worker *self = arg;
+  uint64_t expected = 0UL;
+  size_t available;
+  size_t i;
+
+  while (expected < RING_BUFFER_MESSAGES)
+  {
+    while (0UL == (available = broadcast_ring_available(self->ring, self->id)))
+    {
+      sched_yield();
+    }
+
+    for (i = 0UL; i < available; i++, expected++)
+    {
+      const uint64_t event = *(const uint64_t *)broadcast_ring_peek(self->ring, self->id, i);
+
+      if (event != expected)
+      {
+        return (void *)1;
+      }
+
+      /* the first two consumers stamp the event, the third checks both did */
+      if (self->id < 2)
+      {
+        __atomic_store_n(&self->seen[self->id][event], 1UL, __ATOMIC_RELAXED);
+      }
+      else if (0UL == __atomic_load_n(&self->seen[0][event], __ATOMIC_RELAXED) ||
+               0UL == __atomic_load_n(&self->seen[1][event], __ATOMIC_RELAXED))
+      {
+        return (void *)1;
+      }
+    }
+
+    broadcast_ring_release(self->ring, self->id, available);
+  }
+
+  return NULL;
+}
+
+static void broadcast_ring_threads_test(void unused **state)
+{
+  broadcast_ring_t *ring = NULL;
+  struct broadcast_worker workers[3];
+  pthread_t threads[3];
+  uint64_t *seen[2];
+  void *result = NULL;
+  const int deps[2] = {0, 1};
+  uint64_t i;
+  int t;
+
+  ring = broadcast_ring_create(64UL, sizeof(uint64_t));
+  seen[0] = calloc(RING_BUFFER_MESSAGES, sizeof(uint64_t));
+  seen[1] = calloc(RING_BUFFER_MESSAGES, sizeof(uint64_t));
+
+  assert_int_equal(0, broadcast_ring_add_consumer(ring, NULL, 0UL));
+  assert_int_equal(1, broadcast_ring_add_consumer(ring, NULL, 0UL));
+  assert_int_equal(2, broadcast_ring_add_consumer(ring, deps, 2UL));
+
+  for (t = 0; t < 3; t++)
+  {
+    workers[t].ring = ring;
+    workers[t].id = t;
+    workers[t].seen[0] = seen[0];
+    workers[t].seen[1] = seen[1];
+    assert_int_equal(0, pthread_create(&threads[t], NULL, broadcast_consumer, &workers[t]));
+  }
+
+  for (i = 0UL; i < RING_BUFFER_MESSAGES; i++)
+  {
+    while (0 > broadcast_ring_publish(ring, &i))
+    {
+      sched_yield();
+    }
+  }
+
+  for (t = 0; t < 3; t++)
+  {
+    pthread_join(threads[t], &result);
+    assert_null(result);
+  }
+
+  free(seen[0]);
+  free(seen[1]);
+  broadcast_ring_destroy(ring);
+}
+
+static void deque_ends_test(void unused **state)
+{
+  deque_t *deque = NULL;
+  uint32_t item = 0U;
+  uint32_t i;
+
+  assert_null(deque_create(0UL));
+
+  deque = deque_create(sizeof(uint32_t));
+  assert_non_null(deque);
+
+  assert_int_equal(-1, deque_pop_front(deque, &item));
+  assert_int_equal(-1, deque_pop_back(deque, &item));
+  assert_null(deque_at(deque, 0UL));
+
+  for (i = 0U; i < 4U; i++)
+  {
+    assert_int_equal(0, deque_push_back(deque, &i));
+  }
+
+  for (i = 10U; i < 14U; i++)
+  {
+    assert_int_equal(0, deque_push_front(deque, &i));
+  }
+
+  /* 13 12 11 10 0 1 2 3 */
+  assert_int_equal(8UL, deque_size(deque));
+  assert_int_equal(*(uint32_t *)deque_at(deque, 0UL), 13U);
+  assert_int_equal(*(uint32_t *)deque_at(deque, 4UL), 0U);
+  assert_int_equal(*(uint32_t *)deque_at(deque, 7UL), 3U);
+  assert_null(deque_at(deque, 8UL));
+
+  assert_int_equal(0, deque_pop_back(deque, &item));
+  assert_int_equal(item, 3U);
+  assert_int_equal(0, deque_pop_front(deque, &item));
+  assert_int_equal(item, 13U);
+  assert_int_equal(0, deque_pop_front(deque, NULL));
+  assert_int_equal(*(uint32_t *)deque_at(deque, 0UL), 11U);
+  assert_int_equal(5UL, deque_size(deque));
+
+  while (0 == deque_pop_back(deque, NULL))
+    ;
+
+  assert_int_equal(0UL, deque_size(deque));
+
+  deque_destroy(deque);
+}
+
+static void deque_growth_test(void unused **state)
+{
+  deque_t *deque = NULL;
+  uint64_t *model = NULL;
+  uint64_t item = 0UL;
+  uint32_t *pinned = NULL;
+  uint32_t value = 7U;
+  size_t head = 1UL << 17;
+  size_t tail = head;
+  size_t i;
+  uint64_t seed = 1UL;
+
+  /* a pointer into the deque stays valid while both ends grow */
+  deque = deque_create(sizeof(uint32_t));
+  deque_push_back(deque, &value);
+  pinned = (uint32_t *)deque_at(deque, 0UL);
+
+  for (i = 0UL; i < 100000UL; i++)
+  {
+    deque_push_back(deque, &value);
+    deque_push_front(deque, &value);
+  }
+
+  assert_true(pinned == deque_at(deque, 100000UL));
+  assert_int_equal(*pinned, 7U);
+  deque_destroy(deque);
+
+  /* random operations against an array model, crossing many blocks */
+  model = (uint64_t *)calloc(head * 2UL, sizeof(*model));
+  deque = deque_create(sizeof(uint64_t));
+
+  for (i = 0UL; i < 200000UL; i++)
+  {
+    seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+
+    switch ((seed >> 33) % 5UL)
+    {
+    case 0:
+    case 1:
+      assert_int_equal(0, deque_push_back(deque, &i));
+      model[tail++] = i;
+      break;
+    case 2:
+      assert_int_equal(0, deque_push_front(deque, &i));
+      model[--head] = i;
+      break;
+    case 3:
+      if (head == tail)
+      {
+        assert_int_equal(-1, deque_pop_front(deque, &item));
+        break;
+      }
+      assert_int_equal(0, deque_pop_front(deque, &item));
+      assert_int_equal(item, model[head++]);
+      break;
+    default:
+      if (head == tail)
+      {
+        assert_int_equal(-1, deque_pop_back(deque, &item));
+        break;
+      }
+      assert_int_equal(0, deque_pop_back(deque, &item));
+      assert_int_equal(item, model[--tail]);
+      break;
+    }
+
+    assert_int_equal(deque_size(deque), tail - head);
+  }
+
+  for (i = 0UL; i < tail - head; i += 97UL)
+  {
+    assert_int_equal(*(uint64_t *)deque_at(deque, i), model[head + i]);
+  }
+
+  deque_destroy(deque);
+  free(model);
+}
+
 int main(void)
 {
   const struct CMUnitTest tests[] = {
     cmocka_unit_test(ring_buffer_new_test),
     cmocka_unit_test(ring_buffer_enqueue_test),
     cmocka_unit_test(ring_buffer_dequeue_test),
+    cmocka_unit_test(ring_buffer_wrap_test),
+    cmocka_unit_test(ring_buffer_zero_copy_test),
+    cmocka_unit_test(ring_buffer_bulk_test),
+    cmocka_unit_test(ring_buffer_mirrored_test),
+    cmocka_unit_test(ring_buffer_growable_test),
+    cmocka_unit_test(ring_buffer_threads_test),
+    cmocka_unit_test(ring_buffer_fd_test),
+    cmocka_unit_test(ring_buffer_uring_test),
+    cmocka_unit_test(ring_buffer_frame_test),
+    cmocka_unit_test(ring_buffer_frame_threads_test),
+    cmocka_unit_test(ring_buffer_wait_test),
+    cmocka_unit_test(ring_buffer_blocking_threads_test),
+    cmocka_unit_test(ring_buffer_shared_test),
+    cmocka_unit_test(mpmc_queue_test),
+    cmocka_unit_test(mpmc_queue_bulk_test),
+    cmocka_unit_test(mpmc_queue_threads_test),
+    cmocka_unit_test(broadcast_ring_test),
+    cmocka_unit_test(broadcast_ring_threads_test),
+    cmocka_unit_test(deque_ends_test),
+    cmocka_unit_test(deque_growth_test),
   };
 
   return cmocka_run_group_tests(tests, NULL, NULL);
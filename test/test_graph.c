@@ -135,6 +135,25 @@ static void test_graph_bfs(void **state) {
     graph_destroy(g);
 }
 
+/*
+* test_graph_bfs_wide:
+*   Run breadth-first search from a node with more neighbours than the
+*   initial capacity of the BFS queue, which has to grow to hold them.
+*/
+static void test_graph_bfs_wide(void **state) {
+    UNUSED(state);
+    graph_t *g = graph_create(256);
+    assert_non_null(g);
+
+    uint32_t hub = 0, i;
+    for (i = 1; i < 16; i++) {
+        graph_add_edge(g, &hub, sizeof(hub), &i, sizeof(i));
+    }
+
+    graph_bfs(g, &hub, sizeof(hub));
+    graph_destroy(g);
+}
+
 /*
 * test_graph_dfs:
 *   Create a small graph and perform depth-first search.
@@ -156,13 +175,34 @@ static void test_graph_dfs(void **state) {
     graph_destroy(g);
 }
 
+/*
+* test_graph_dfs_wide:
+*   Run depth-first search from a node with more neighbours than fit in a
+*   small fixed stack, including leaves that have no edges of their own.
+*/
+static void test_graph_dfs_wide(void **state) {
+    UNUSED(state);
+    graph_t *g = graph_create(256);
+    assert_non_null(g);
+
+    uint32_t hub = 0, i;
+    for (i = 1; i < 16; i++) {
+        graph_add_edge(g, &hub, sizeof(hub), &i, sizeof(i));
+    }
+
+    graph_dfs(g, &hub, sizeof(hub));
+    graph_destroy(g);
+}
+
 int main(void)
 {
   const struct CMUnitTest tests[] = {
     cmocka_unit_test(test_graph_create_destroy),
     cmocka_unit_test(test_graph_add_edge),
     cmocka_unit_test(test_graph_bfs),
+    cmocka_unit_test(test_graph_bfs_wide),
     cmocka_unit_test(test_graph_dfs),
+    cmocka_unit_test(test_graph_dfs_wide),
   };
   return cmocka_run_group_tests(tests, NULL, NULL);
 }
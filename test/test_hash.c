@@ -0,0 +1,875 @@
+/*
+ * Copyright (C) 2025 Da'Jour J. Christophe. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <setjmp.h>
+
+#include "cmocka.h"
+
+#include "common.h"
+#include "internal/cpu.h"
+#include "internal/hash.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define INPUT_SIZE 4096UL
+
+struct vector
+{
+  size_t   len;
+  uint64_t seed;
+  uint64_t hash;
+};
+
+/* reference values from the upstream XXH3_64bits_withSeed() */
+static const struct vector vectors[] = {
+    {   0, 0ULL, 0x2d06800538d394c2ULL},
+    {   0, 2ULL, 0xf36cf7ecd1fcfda0ULL},
+    {   1, 0ULL, 0xc44bdff4074eecdbULL},
+    {   1, 2ULL, 0x1cddf8f8475304c7ULL},
+    {   2, 0ULL, 0x2855685d6d035695ULL},
+    {   2, 2ULL, 0x621913aadc6b259cULL},
+    {   3, 0ULL, 0xfbaa49d452844ea8ULL},
+    {   3, 2ULL, 0xa3b97f6279e772bbULL},
+    {   4, 0ULL, 0xbacd13b886e5acdeULL},
+    {   4, 2ULL, 0x9aad3766652b843aULL},
+    {   7, 0ULL, 0x9a4225721ddbd7a0ULL},
+    {   7, 2ULL, 0x622fb08b5b08163bULL},
+    {   8, 0ULL, 0x1b792cfcb8b90490ULL},
+    {   8, 2ULL, 0xe0bd69e460c341b9ULL},
+    {   9, 0ULL, 0xdfa39952e4f14d2cULL},
+    {   9, 2ULL, 0xf2abf846bda9cfbaULL},
+    {  15, 0ULL, 0xab1b3503bb51583fULL},
+    {  15, 2ULL, 0x917aebaeeb9b001bULL},
+    {  16, 0ULL, 0x6b78ce970b9f8bc8ULL},
+    {  16, 2ULL, 0xf66ef2aa5f647bd1ULL},
+    {  17, 0ULL, 0x938f40fff1db8e10ULL},
+    {  17, 2ULL, 0x67f6c48cb2294263ULL},
+    {  31, 0ULL, 0xa9395bb408e66f83ULL},
+    {  31, 2ULL, 0xed309c17b31b8963ULL},
+    {  32, 0ULL, 0xf68b495318217791ULL},
+    {  32, 2ULL, 0x4cc2b6b3275b904fULL},
+    {  33, 0ULL, 0x94426d2a49f1ea8cULL},
+    {  33, 2ULL, 0x48660b4cc83643a1ULL},
+    {  64, 0ULL, 0x9a6dc9ca86296e4eULL},
+    {  64, 2ULL, 0x751a9f583eb87088ULL},
+    {  65, 0ULL, 0x7d4e4d6ba153b6a0ULL},
+    {  65, 2ULL, 0x34e2d7b5039fe4a9ULL},
+    {  96, 0ULL, 0x55452c74e7f3851bULL},
+    {  96, 2ULL, 0x24d215bdb4b86410ULL},
+    {  97, 0ULL, 0xbe136218b90e928fULL},
+    {  97, 2ULL, 0x77784325abf9c731ULL},
+    { 128, 0ULL, 0x171853b3496482b0ULL},
+    { 128, 2ULL, 0x9811d67edef0e167ULL},
+    { 129, 0ULL, 0x5a6f4423306ee0f6ULL},
+    { 129, 2ULL, 0xe332113a7562d75bULL},
+    { 200, 0ULL, 0xecf0a032a83ae84cULL},
+    { 200, 2ULL, 0xf85cac909b548c0bULL},
+    { 240, 0ULL, 0x50a5a82a8837498bULL},
+    { 240, 2ULL, 0x7ccf2c28cc5bc878ULL},
+    { 241, 0ULL, 0xb512069c8951dd3aULL},
+    { 241, 2ULL, 0xeed4f9d48fca5448ULL},
+    { 255, 0ULL, 0x398e82e2874db2e8ULL},
+    { 255, 2ULL, 0x8356d203bcdba948ULL},
+    { 256, 0ULL, 0x02728fdf8b5b2599ULL},
+    { 256, 2ULL, 0x2891d538b36b6f69ULL},
+    {1023, 0ULL, 0x57d0af8322e17f65ULL},
+    {1023, 2ULL, 0x8500936881f6e80fULL},
+    {1024, 0ULL, 0x44814855123e73aaULL},
+    {1024, 2ULL, 0x4bdf130fa5711e9fULL},
+    {1025, 0ULL, 0x07e08c99aaceb5a6ULL},
+    {1025, 2ULL, 0x42a01fcd50cef4ddULL},
+    {2048, 0ULL, 0xa67ea82911361f90ULL},
+    {2048, 2ULL, 0x3c642654a00bf867ULL},
+    {4096, 0ULL, 0x76c1c8943d6be032ULL},
+    {4096, 2ULL, 0xb412c2d829b94d90ULL},
+};
+
+struct vector128
+{
+  size_t   len;
+  uint64_t seed;
+  xxh128_t hash;
+};
+
+/* reference values from the upstream XXH3_128bits_withSeed() */
+static const struct vector128 vectors128[] = {
+    {   0, 0ULL, {0x6001c324468d497fULL, 0x99aa06d3014798d8ULL}},
+    {   0, 2ULL, {0xc9e9363846530d53ULL, 0xd060ff214ee7c359ULL}},
+    {   1, 0ULL, {0xc44bdff4074eecdbULL, 0xa6cd5e9392000f6aULL}},
+    {   1, 2ULL, {0x1cddf8f8475304c7ULL, 0xb3d4eb9ebd5c8733ULL}},
+    {   3, 0ULL, {0xfbaa49d452844ea8ULL, 0x9ab13aaa6743890fULL}},
+    {   3, 2ULL, {0xa3b97f6279e772bbULL, 0xf6ba65cdd51cad0fULL}},
+    {   4, 0ULL, {0x38747373de30e0d1ULL, 0x282b017a3a4445edULL}},
+    {   4, 2ULL, {0xf31aa4346589dad1ULL, 0x18b31800069ef3d7ULL}},
+    {   8, 0ULL, {0x6eacda2fc257f3feULL, 0x59b1fc5636a13d76ULL}},
+    {   8, 2ULL, {0xaa8b13bdd1db3bebULL, 0x5fbe50f951a3256aULL}},
+    {   9, 0ULL, {0xaf1cc770e075a165ULL, 0x100fec48ae54bcb9ULL}},
+    {   9, 2ULL, {0x835cffb76d55ccd0ULL, 0x093c8514b9582c9bULL}},
+    {  16, 0ULL, {0x6a9ee623fd0690c4ULL, 0x013af35d398354cbULL}},
+    {  16, 2ULL, {0xf43aeec7db862b3aULL, 0x7a99636769308596ULL}},
+    {  17, 0ULL, {0x74e4ef3160f7175cULL, 0xd916324ba8e60613ULL}},
+    {  17, 2ULL, {0x9824e97fbe2b1a65ULL, 0x764cc0dcffbbf3bcULL}},
+    {  64, 0ULL, {0x6a92388bd7393eeaULL, 0xd21d26cfb0c9a14fULL}},
+    {  64, 2ULL, {0x07c430335481606aULL, 0xddc51844afab47efULL}},
+    { 128, 0ULL, {0xd712bed38096e247ULL, 0xa4096a07b17065e2ULL}},
+    { 128, 2ULL, {0x36dec1691565c1dbULL, 0x06828f7c38cefd6cULL}},
+    { 129, 0ULL, {0x37da797c27c7defbULL, 0xeb50c200569f949bULL}},
+    { 129, 2ULL, {0x93a48b1c02ac7bdfULL, 0xbd343d80d7b89a33ULL}},
+    { 240, 0ULL, {0xc740a5ba71a7a3a2ULL, 0x3939990661a9c797ULL}},
+    { 240, 2ULL, {0xe165ecfc10128950ULL, 0xac4dd5a440c05635ULL}},
+    { 241, 0ULL, {0xb512069c8951dd3aULL, 0x71a77b21a2e2cffdULL}},
+    { 241, 2ULL, {0xeed4f9d48fca5448ULL, 0xda8a0324f67bff26ULL}},
+    {1024, 0ULL, {0x44814855123e73aaULL, 0xf9dcd918075b4b3cULL}},
+    {1024, 2ULL, {0x4bdf130fa5711e9fULL, 0xc0d52808f3793949ULL}},
+    {4096, 0ULL, {0x76c1c8943d6be032ULL, 0x208f6b4d4982d97aULL}},
+    {4096, 2ULL, {0xb412c2d829b94d90ULL, 0x307b00420d8b12caULL}},
+};
+
+/*
+ * The xxhsum self-test: its generated buffer and published results, with
+ * seeds 0 and PRIME64.
+ */
+#define SANITY_PRIME32 2654435761U
+#define SANITY_PRIME64 11400714785074694797ULL
+#define SANITY_SIZE    2367UL
+
+static const struct vector sanity[] = {
+    {   0, 0ULL,        0x2d06800538d394c2ULL},
+    {   0, SANITY_PRIME64, 0xa8a6b918b2f0364aULL},
+    {   1, 0ULL,        0xc44bdff4074eecdbULL},
+    {   1, SANITY_PRIME64, 0x032be332dd766ef8ULL},
+    {   6, 0ULL,        0x27b56a84cd2d7325ULL},
+    {   6, SANITY_PRIME64, 0x84589c116ab59ab9ULL},
+    {  12, 0ULL,        0xa713daf0dfbb77e7ULL},
+    {  12, SANITY_PRIME64, 0xe7303e1b2336de0eULL},
+    {  24, 0ULL,        0xa3fe70bf9d3510ebULL},
+    {  24, SANITY_PRIME64, 0x850e80fc35bdd690ULL},
+    {  48, 0ULL,        0x397da259ecba1f11ULL},
+    {  48, SANITY_PRIME64, 0xadc2cbaa44acc616ULL},
+    {  80, 0ULL,        0xbcdefbbb2c47c90aULL},
+    {  80, SANITY_PRIME64, 0xc6dd0cb699532e73ULL},
+    { 195, 0ULL,        0xcd94217ee362ec3aULL},
+    { 195, SANITY_PRIME64, 0xba68003d370cb3d9ULL},
+    { 403, 0ULL,        0xcdeb804d65c6dea4ULL},
+    { 403, SANITY_PRIME64, 0x6259f6ecfd6443fdULL},
+    { 512, 0ULL,        0x617e49599013cb6bULL},
+    { 512, SANITY_PRIME64, 0x3ce457de14c27708ULL},
+    {2048, 0ULL,        0xdd59e2c3a5f038e0ULL},
+    {2048, SANITY_PRIME64, 0x66f81670669ababcULL},
+    {2240, 0ULL,        0x6e73a90539cf2948ULL},
+    {2240, SANITY_PRIME64, 0x757ba8487d1b5247ULL},
+    {2367, 0ULL,        0xcb37aeb9e5d361edULL},
+    {2367, SANITY_PRIME64, 0xd2db3415b942b42aULL},
+};
+
+struct mix_vector
+{
+  size_t   len;
+  uint64_t crc32c_mix;
+  uint64_t aes_mix;
+};
+
+/* recorded from this implementation with seed 2 on the sanity buffer */
+static const struct mix_vector mix_vectors[] = {
+    {   0, 0x7535e1156c01adf2ULL, 0x76c0395d5c940249ULL},
+    {   1, 0x681301fd480dc3c6ULL, 0x05813f1e6c72ee34ULL},
+    {   6, 0xc989effb832b4433ULL, 0xcf64a7ef8d37fbc0ULL},
+    {  12, 0x1438a688ee3eb04fULL, 0x422393302c07c9b4ULL},
+    {  24, 0x48229f9a0f9ada3eULL, 0x74c6ee06ba1736f7ULL},
+    {  48, 0x32cba74f38fbad94ULL, 0x3b080a7c39602c41ULL},
+    {  80, 0xe72e4245e98d9076ULL, 0x3f6e8cbb2eb06faeULL},
+    { 195, 0xee79e0b05ec1ecd3ULL, 0x57482fe0d0b14208ULL},
+    { 403, 0x0960b67e5a8cb5b7ULL, 0x086706e29e982a79ULL},
+    { 512, 0x809f7514c7f22908ULL, 0x5303619f3591ed4eULL},
+    {2048, 0xc5b9d2a7647a1533ULL, 0x56f01249e6414c85ULL},
+    {2240, 0x8c94a0133282d997ULL, 0x000514764d2c64deULL},
+    {2367, 0x2f4b76ab9503d748ULL, 0x02691f56052b7befULL},
+};
+
+static void fill(uint8_t *buf, const size_t size)
+{
+  uint32_t x = 0;
+  size_t i;
+
+  for (i = 0; i < size; i++)
+  {
+    x = x * 1103515245U + 12345U;
+    buf[i] = (uint8_t)(x >> 16);
+  }
+}
+
+static void fill_sanity(uint8_t *buf, const size_t size)
+{
+  uint64_t x = SANITY_PRIME32;
+  size_t i;
+
+  for (i = 0; i < size; i++)
+  {
+    buf[i] = (uint8_t)(x >> 56);
+    x *= SANITY_PRIME64;
+  }
+}
+
+static void test_hash_vectors(void **state)
+{
+  UNUSED(state);
+
+  uint8_t *buf = malloc(INPUT_SIZE);
+  size_t i;
+
+  fill(buf, INPUT_SIZE);
+
+  for (i = 0; i < sizeof(vectors) / sizeof(*vectors); i++)
+  {
+    assert_int_equal(xxh3(buf, vectors[i].len, vectors[i].seed), vectors[i].hash);
+  }
+
+  free(buf);
+}
+
+static void test_hash_sanity(void **state)
+{
+  UNUSED(state);
+
+  uint8_t *buf = malloc(SANITY_SIZE);
+  size_t i;
+
+  fill_sanity(buf, SANITY_SIZE);
+
+  for (i = 0; i < sizeof(sanity) / sizeof(*sanity); i++)
+  {
+    assert_int_equal(xxh3(buf, sanity[i].len, sanity[i].seed), sanity[i].hash);
+  }
+
+  free(buf);
+}
+
+static void test_hash_mix_vectors(void **state)
+{
+  UNUSED(state);
+
+  uint8_t *buf = malloc(SANITY_SIZE);
+  size_t i;
+
+  fill_sanity(buf, SANITY_SIZE);
+
+  for (i = 0; i < sizeof(mix_vectors) / sizeof(*mix_vectors); i++)
+  {
+    assert_int_equal(crc32c_mix(buf, mix_vectors[i].len, 2), mix_vectors[i].crc32c_mix);
+    assert_int_equal(aes_mix(buf, mix_vectors[i].len, 2), mix_vectors[i].aes_mix);
+  }
+
+  free(buf);
+}
+
+static void test_hash_vectors128(void **state)
+{
+  UNUSED(state);
+
+  uint8_t *buf = malloc(INPUT_SIZE);
+  size_t i;
+
+  fill(buf, INPUT_SIZE);
+
+  for (i = 0; i < sizeof(vectors128) / sizeof(*vectors128); i++)
+  {
+    const xxh128_t hash = xxh3_128(buf, vectors128[i].len, vectors128[i].seed);
+
+    assert_int_equal(hash.low64, vectors128[i].hash.low64);
+    assert_int_equal(hash.high64, vectors128[i].hash.high64);
+  }
+
+  free(buf);
+}
+
+static void test_hash_unaligned(void **state)
+{
+  UNUSED(state);
+
+  uint8_t *buf = malloc(INPUT_SIZE + 8);
+  uint8_t *copy = malloc(INPUT_SIZE + 8);
+  size_t len;
+  size_t offset;
+
+  fill(buf, INPUT_SIZE);
+
+  for (len = 0; len <= 1100; len += 7)
+  {
+    const uint64_t expected = xxh3(buf, len, 2);
+
+    for (offset = 1; offset < 8; offset++)
+    {
+      memcpy(copy + offset, buf, len);
+      assert_int_equal(xxh3(copy + offset, len, 2), expected);
+    }
+  }
+
+  free(buf);
+  free(copy);
+}
+
+static void test_hash_streaming(void **state)
+{
+  UNUSED(state);
+
+  uint8_t *buf = malloc(INPUT_SIZE);
+  const size_t chunks[] = {1, 3, 16, 63, 64, 100, 255, 256, 257, 1000};
+  xxh3_state_t st;
+  size_t len;
+  size_t c;
+  size_t off;
+
+  fill(buf, INPUT_SIZE);
+
+  for (len = 0; len <= INPUT_SIZE; len += len < 600 ? 13 : 337)
+  {
+    for (c = 0; c < sizeof(chunks) / sizeof(*chunks); c++)
+    {
+      xxh3_reset(&st, len & 1 ? 2 : 0);
+
+      for (off = 0; off < len; off += chunks[c])
+      {
+        xxh3_update(&st, buf + off, len - off < chunks[c] ? len - off : chunks[c]);
+      }
+
+      const xxh128_t expected = xxh3_128(buf, len, len & 1 ? 2 : 0);
+      const xxh128_t digest = xxh3_128_digest(&st);
+
+      assert_int_equal(xxh3_digest(&st), xxh3(buf, len, len & 1 ? 2 : 0));
+      assert_int_equal(digest.low64, expected.low64);
+      assert_int_equal(digest.high64, expected.high64);
+    }
+  }
+
+  free(buf);
+}
+
+/* a state from malloc() is only guaranteed natural alignment */
+static void test_hash_streaming_heap(void **state)
+{
+  UNUSED(state);
+
+  uint8_t *buf = malloc(INPUT_SIZE);
+  uint8_t *mem = malloc(sizeof(xxh3_state_t) + 72);
+  xxh3_state_t *st = (xxh3_state_t *)(void *)(mem + (64 - (uintptr_t)mem % 64) + 8);
+  size_t len;
+
+  fill(buf, INPUT_SIZE);
+
+  for (len = 0; len <= INPUT_SIZE; len += len < 600 ? 13 : 337)
+  {
+    xxh3_reset(st, len & 1 ? 2 : 0);
+    xxh3_update(st, buf, len / 3);
+    xxh3_update(st, buf + len / 3, len - len / 3);
+
+    const xxh128_t expected = xxh3_128(buf, len, len & 1 ? 2 : 0);
+    const xxh128_t digest = xxh3_128_digest(st);
+
+    assert_int_equal(xxh3_digest(st), xxh3(buf, len, len & 1 ? 2 : 0));
+    assert_int_equal(digest.low64, expected.low64);
+    assert_int_equal(digest.high64, expected.high64);
+  }
+
+  free(mem);
+  free(buf);
+}
+
+static void test_hash_batch(void **state)
+{
+  UNUSED(state);
+
+  uint8_t *buf = malloc(INPUT_SIZE);
+  uint64_t out[100];
+  size_t len;
+  size_t stride;
+  size_t i;
+
+  fill(buf, INPUT_SIZE);
+
+  for (len = 0; len <= 24; len++)
+  {
+    for (stride = len > 0 ? len : 1; stride <= len + 3; stride++)
+    {
+      xxh3_batch(buf + 1, stride, len, 100, 2, out);
+
+      for (i = 0; i < 100; i++)
+      {
+        assert_int_equal(out[i], xxh3(buf + 1 + i * stride, len, 2));
+      }
+    }
+  }
+
+  free(buf);
+}
+
+static void test_hash_seed(void **state)
+{
+  UNUSED(state);
+
+  uint8_t *buf = malloc(INPUT_SIZE);
+  const size_t lens[] = {0, 3, 8, 16, 100, 200, 1000};
+  size_t i;
+
+  fill(buf, INPUT_SIZE);
+
+  for (i = 0; i < sizeof(lens) / sizeof(*lens); i++)
+  {
+    assert_true(xxh3(buf, lens[i], 1) != xxh3(buf, lens[i], 2));
+    assert_true(crc32c_mix(buf, lens[i], 1) != crc32c_mix(buf, lens[i], 2));
+    assert_true(aes_mix(buf, lens[i], 1) != aes_mix(buf, lens[i], 2));
+  }
+
+  free(buf);
+}
+
+/*
+ * Quality checks in the spirit of SMHasher, run over every hash a table
+ * can be configured with. Keys come from a fixed generator so a failure
+ * reproduces.
+ */
+static const hash_fn_t quality_fns[] = {xxh3, crc32c_mix, aes_mix};
+
+#define QUALITY_FNS (sizeof(quality_fns) / sizeof(*quality_fns))
+
+static uint64_t splitmix64(uint64_t *x)
+{
+  uint64_t z = (*x += 0x9E3779B97F4A7C15ULL);
+
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+
+static int compare_u64(const void *a, const void *b)
+{
+  const uint64_t x = *(const uint64_t *)a;
+  const uint64_t y = *(const uint64_t *)b;
+
+  return (x > y) - (x < y);
+}
+
+static size_t count_collisions(uint64_t *hashes, const size_t n, const uint64_t mask)
+{
+  size_t collisions = 0;
+  size_t i;
+
+  for (i = 0; i < n; i++)
+  {
+    hashes[i] &= mask;
+  }
+
+  qsort(hashes, n, sizeof(*hashes), compare_u64);
+
+  for (i = 1; i < n; i++)
+  {
+    collisions += hashes[i] == hashes[i - 1];
+  }
+
+  return collisions;
+}
+
+/* flipping any input bit flips each output bit with probability 1/2 */
+static void test_hash_avalanche(void **state)
+{
+  UNUSED(state);
+
+  const size_t lens[] = {4, 8, 16, 32};
+  const size_t keys = 1000;
+  uint32_t *flips = malloc(32 * 8 * 64 * sizeof(*flips));
+  uint8_t key[32];
+  uint64_t x = 1;
+  size_t f, l, k, i, bit;
+
+  for (f = 0; f < QUALITY_FNS; f++)
+  {
+    for (l = 0; l < sizeof(lens) / sizeof(*lens); l++)
+    {
+      const size_t len = lens[l];
+
+      memset(flips, 0, len * 8 * 64 * sizeof(*flips));
+
+      for (k = 0; k < keys; k++)
+      {
+        for (i = 0; i < len; i += 8)
+        {
+          const uint64_t r = splitmix64(&x);
+          memcpy(key + i, &r, len - i < 8 ? len - i : 8);
+        }
+
+        const uint64_t h = quality_fns[f](key, len, 2);
+
+        for (i = 0; i < len * 8; i++)
+        {
+          key[i / 8] ^= (uint8_t)(1U << (i % 8));
+          const uint64_t d = h ^ quality_fns[f](key, len, 2);
+          key[i / 8] ^= (uint8_t)(1U << (i % 8));
+
+          for (bit = 0; bit < 64; bit++)
+          {
+            flips[i * 64 + bit] += (uint32_t)((d >> bit) & 1);
+          }
+        }
+      }
+
+      /* five standard deviations at 1000 keys */
+      for (i = 0; i < len * 8 * 64; i++)
+      {
+        assert_in_range(flips[i], 420, 580);
+      }
+    }
+  }
+
+  free(flips);
+}
+
+/*
+ * Bit independence: for a flipped input bit, whether one output bit flips
+ * says nothing about whether another does. Checked as the correlation of
+ * every pair of output bits over 2000 keys.
+ */
+static void test_hash_bic(void **state)
+{
+  UNUSED(state);
+
+  const size_t keys = 2000;
+  uint32_t *flips = malloc(64 * 64 * sizeof(*flips));
+  uint32_t *pairs = malloc(64 * 64 * 64 * sizeof(*pairs));
+  const double limit = 6.0 / sqrt((double)keys);
+  uint64_t x = 3;
+  size_t f, k, i, j, m;
+
+  for (f = 0; f < QUALITY_FNS; f++)
+  {
+    memset(flips, 0, 64 * 64 * sizeof(*flips));
+    memset(pairs, 0, 64 * 64 * 64 * sizeof(*pairs));
+
+    for (k = 0; k < keys; k++)
+    {
+      const uint64_t key = splitmix64(&x);
+      const uint64_t h = quality_fns[f](&key, sizeof(key), 2);
+
+      for (i = 0; i < 64; i++)
+      {
+        const uint64_t flipped = key ^ (1ULL << i);
+        uint64_t d = h ^ quality_fns[f](&flipped, sizeof(flipped), 2);
+
+        while (d != 0)
+        {
+          const size_t a = (size_t)__builtin_ctzll(d);
+          uint64_t rest = d &= d - 1;
+
+          flips[i * 64 + a]++;
+
+          while (rest != 0)
+          {
+            pairs[(i * 64 + a) * 64 + (size_t)__builtin_ctzll(rest)]++;
+            rest &= rest - 1;
+          }
+        }
+      }
+    }
+
+    for (i = 0; i < 64; i++)
+    {
+      for (j = 0; j < 64; j++)
+      {
+        for (m = j + 1; m < 64; m++)
+        {
+          const double n = (double)keys;
+          const double a = (double)flips[i * 64 + j];
+          const double b = (double)flips[i * 64 + m];
+          const double ab = (double)pairs[(i * 64 + j) * 64 + m];
+          const double r = (n * ab - a * b) / sqrt(a * (n - a) * b * (n - b));
+
+          assert_true(fabs(r) < limit);
+        }
+      }
+    }
+  }
+
+  free(flips);
+  free(pairs);
+}
+
+/* keys with at most two bits set must not collide in 64 bits, nor often in 32 */
+static void test_hash_sparse(void **state)
+{
+  UNUSED(state);
+
+  const size_t len = 16;
+  const size_t n = 1 + 128 + 128 * 127 / 2;
+  uint64_t *hashes = malloc(n * sizeof(*hashes));
+  uint64_t *copy = malloc(n * sizeof(*copy));
+  uint8_t key[16];
+  size_t f, i, j, c;
+
+  for (f = 0; f < QUALITY_FNS; f++)
+  {
+    c = 0;
+    memset(key, 0, len);
+    hashes[c++] = quality_fns[f](key, len, 2);
+
+    for (i = 0; i < len * 8; i++)
+    {
+      key[i / 8] ^= (uint8_t)(1U << (i % 8));
+      hashes[c++] = quality_fns[f](key, len, 2);
+
+      for (j = i + 1; j < len * 8; j++)
+      {
+        key[j / 8] ^= (uint8_t)(1U << (j % 8));
+        hashes[c++] = quality_fns[f](key, len, 2);
+        key[j / 8] ^= (uint8_t)(1U << (j % 8));
+      }
+
+      key[i / 8] ^= (uint8_t)(1U << (i % 8));
+    }
+
+    assert_int_equal(c, n);
+
+    memcpy(copy, hashes, n * sizeof(*hashes));
+    assert_int_equal(count_collisions(copy, n, ~0ULL), 0);
+
+    memcpy(copy, hashes, n * sizeof(*hashes));
+    assert_true(count_collisions(copy, n, 0xFFFFFFFFULL) <= 2);
+
+    for (i = 0; i < n; i++)
+    {
+      copy[i] = hashes[i] >> 32;
+    }
+    assert_true(count_collisions(copy, n, ~0ULL) <= 2);
+  }
+
+  free(hashes);
+  free(copy);
+}
+
+static double chi_squared(const uint32_t *counts, const size_t buckets, const size_t n)
+{
+  const double expected = (double)n / (double)buckets;
+  double chi = 0.0;
+  size_t i;
+
+  for (i = 0; i < buckets; i++)
+  {
+    chi += ((double)counts[i] - expected) * ((double)counts[i] - expected) / expected;
+  }
+
+  return chi;
+}
+
+/*
+ * Sequential and strided integer keys spread evenly over the buckets a
+ * table would pick, both by hash % size and by masking the low bits of a
+ * power-of-two size. The high bits are checked too, as a sketch would
+ * use them.
+ */
+static void test_hash_distribution(void **state)
+{
+  UNUSED(state);
+
+  const size_t sizes[] = {1000, 1009, 1024, 4096, 4099};
+  const size_t n = 1UL << 16;
+  uint32_t *counts = malloc(4099 * sizeof(*counts));
+  uint32_t *high = malloc(1024 * sizeof(*high));
+  size_t f, s, stride;
+  uint32_t i;
+
+  for (f = 0; f < QUALITY_FNS; f++)
+  {
+    for (stride = 1; stride <= 4096; stride *= 64)
+    {
+      for (s = 0; s < sizeof(sizes) / sizeof(*sizes); s++)
+      {
+        const size_t size = sizes[s];
+        const int pow2 = (size & (size - 1)) == 0;
+
+        memset(counts, 0, size * sizeof(*counts));
+        memset(high, 0, 1024 * sizeof(*high));
+
+        for (i = 0; i < n; i++)
+        {
+          const uint64_t key = (uint64_t)i * stride;
+          const uint64_t h = quality_fns[f](&key, sizeof(key), 2);
+
+          counts[pow2 ? h & (size - 1) : h % size]++;
+          high[h >> 54]++;
+        }
+
+        /* size - 1 degrees of freedom; allow six standard deviations */
+        assert_true(chi_squared(counts, size, n) < (double)(size - 1) + 6.0 * sqrt(2.0 * (double)(size - 1)));
+        assert_true(chi_squared(high, 1024, n) < 1023.0 + 6.0 * sqrt(2.0 * 1023.0));
+      }
+    }
+  }
+
+  free(counts);
+  free(high);
+}
+
+/* the portable crc32c_mix and aes_mix must agree with SSE4.2 and AES-NI */
+static void test_hash_mix_dispatch(void **state)
+{
+  UNUSED(state);
+
+  uint8_t *buf = malloc(INPUT_SIZE);
+  uint64_t crc[300];
+  uint64_t aes[300];
+  size_t len;
+
+  fill(buf, INPUT_SIZE);
+
+  cpu_restrict(0U);
+
+  for (len = 0; len < 300; len++)
+  {
+    crc[len] = crc32c_mix(buf + 1, len, len);
+    aes[len] = aes_mix(buf + 1, len, len);
+  }
+
+  cpu_restrict(~0U);
+
+  for (len = 0; len < 300; len++)
+  {
+    assert_int_equal(crc32c_mix(buf + 1, len, len), crc[len]);
+    assert_int_equal(aes_mix(buf + 1, len, len), aes[len]);
+  }
+
+  free(buf);
+}
+
+static void test_hash_tree(void **state)
+{
+  UNUSED(state);
+
+  const size_t lens[] = {0, 1, XXH3_TREE_LEAF - 1, XXH3_TREE_LEAF, 3 * XXH3_TREE_LEAF + 12345};
+  const unsigned int threads[] = {1, 2, 3, 8, 0};
+  const size_t size = 3 * XXH3_TREE_LEAF + 12345;
+  uint8_t *buf = malloc(size);
+  xxh128_t digests[4];
+  size_t l, t, i;
+
+  fill(buf, size);
+
+  for (l = 0; l < sizeof(lens) / sizeof(*lens); l++)
+  {
+    const size_t leaves = lens[l] == 0 ? 1 : (lens[l] + XXH3_TREE_LEAF - 1) / XXH3_TREE_LEAF;
+
+    for (i = 0; i < leaves; i++)
+    {
+      const size_t rest = lens[l] - i * XXH3_TREE_LEAF;
+      digests[i] = xxh3_128(buf + i * XXH3_TREE_LEAF, rest < XXH3_TREE_LEAF ? rest : XXH3_TREE_LEAF, 2);
+    }
+
+    const uint64_t expected = xxh3(digests, leaves * sizeof(*digests), 2);
+
+    for (t = 0; t < sizeof(threads) / sizeof(*threads); t++)
+    {
+      assert_int_equal(xxh3_tree(buf, lens[l], 2, threads[t]), expected);
+    }
+  }
+
+  const uint64_t before = xxh3_tree(buf, size, 2, 4);
+  buf[size - 1] ^= 1;
+  assert_true(xxh3_tree(buf, size, 2, 4) != before);
+
+  free(buf);
+}
+
+static void test_hash_tree_file(void **state)
+{
+  UNUSED(state);
+
+  const size_t size = 2 * XXH3_TREE_LEAF + 77;
+  uint8_t *buf = malloc(size);
+  char path[] = "/tmp/test_hash_XXXXXX";
+  uint64_t hash = 0;
+  int fd;
+
+  fill(buf, size);
+
+  fd = mkstemp(path);
+  assert_true(fd >= 0);
+  assert_int_equal(write(fd, buf, size), (ssize_t)size);
+  close(fd);
+
+  assert_int_equal(xxh3_tree_file(path, 2, 0, &hash), 0);
+  assert_int_equal(hash, xxh3_tree(buf, size, 2, 1));
+
+  assert_int_equal(truncate(path, 0), 0);
+  assert_int_equal(xxh3_tree_file(path, 2, 0, &hash), 0);
+  assert_int_equal(hash, xxh3_tree(NULL, 0, 2, 1));
+
+  unlink(path);
+  assert_int_equal(xxh3_tree_file(path, 2, 0, &hash), -1);
+  assert_int_equal(xxh3_tree_file("/tmp", 2, 0, &hash), -1);
+
+  free(buf);
+}
+
+/* every kernel variant the host can run must give the reference results */
+static void test_hash_dispatch(void **state)
+{
+  const unsigned int masks[] = {0U, CPU_SSE2, CPU_SSE2 | CPU_AVX2, ~0U};
+  size_t i;
+
+  for (i = 0; i < sizeof(masks) / sizeof(*masks); i++)
+  {
+    cpu_restrict(masks[i]);
+
+    test_hash_vectors(state);
+    test_hash_vectors128(state);
+    test_hash_sanity(state);
+    test_hash_mix_vectors(state);
+    test_hash_streaming(state);
+    test_hash_streaming_heap(state);
+    test_hash_batch(state);
+  }
+
+  cpu_restrict(~0U);
+}
+
+int main(void)
+{
+  const struct CMUnitTest tests[] = {
+    cmocka_unit_test(test_hash_vectors),
+    cmocka_unit_test(test_hash_vectors128),
+    cmocka_unit_test(test_hash_sanity),
+    cmocka_unit_test(test_hash_mix_vectors),
+    cmocka_unit_test(test_hash_unaligned),
+    cmocka_unit_test(test_hash_streaming),
+    cmocka_unit_test(test_hash_streaming_heap),
+    cmocka_unit_test(test_hash_batch),
+    cmocka_unit_test(test_hash_seed),
+    cmocka_unit_test(test_hash_dispatch),
+    cmocka_unit_test(test_hash_avalanche),
+    cmocka_unit_test(test_hash_bic),
+    cmocka_unit_test(test_hash_sparse),
+    cmocka_unit_test(test_hash_distribution),
+    cmocka_unit_test(test_hash_mix_dispatch),
+    cmocka_unit_test(test_hash_tree),
+    cmocka_unit_test(test_hash_tree_file),
+  };
+
+  return cmocka_run_group_tests(tests, NULL, NULL);
+}
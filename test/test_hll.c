@@ -0,0 +1,175 @@
+/*
+ * Copyright (C) 2025 Da'Jour J. Christophe. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <setjmp.h>
+
+#include "cmocka.h"
+
+#include "common.h"
+#include "hll.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static void test_hll_create_destroy(void **state)
+{
+  UNUSED(state);
+
+  hll_t *h = hll_new(14);
+  assert_non_null(h);
+  assert_int_equal(hll_count(h), 0);
+  assert_int_equal(hll_is_sparse(h), 1);
+  hll_destroy(h);
+
+  assert_null(hll_new(3));
+  assert_null(hll_new(19));
+}
+
+static void test_hll_sparse(void **state)
+{
+  UNUSED(state);
+
+  hll_t *h = hll_new(14);
+  uint64_t i;
+
+  for (i = 0; i < 100; i++)
+  {
+    hll_add(h, &i, sizeof(i));
+    hll_add(h, &i, sizeof(i));
+  }
+
+  assert_int_equal(hll_is_sparse(h), 1);
+  assert_in_range(hll_count(h), 97, 103);
+  assert_true(hll_memory(h) < (1UL << 14));
+
+  hll_destroy(h);
+}
+
+static void test_hll_dense(void **state)
+{
+  UNUSED(state);
+
+  const uint64_t n = 1000000;
+  hll_t *h = hll_new(14);
+  uint64_t i;
+
+  for (i = 0; i < n; i++)
+  {
+    hll_add(h, &i, sizeof(i));
+  }
+
+  assert_int_equal(hll_is_sparse(h), 0);
+
+  /* standard error at p = 14 is about 0.8%, allow four of them */
+  assert_in_range(hll_count(h), n - n / 30, n + n / 30);
+
+  hll_destroy(h);
+}
+
+static void test_hll_add_hashes(void **state)
+{
+  UNUSED(state);
+
+  const size_t n = 50000;
+  uint64_t *hashes = malloc(n * sizeof(*hashes));
+  hll_t *a = hll_new(12);
+  hll_t *b = hll_new(12);
+  size_t i;
+
+  for (i = 0; i < n; i++)
+  {
+    hashes[i] = (i + 1) * 0x9E3779B97F4A7C15ULL;
+    hashes[i] ^= hashes[i] >> 29;
+    hll_add_hash(a, hashes[i]);
+  }
+
+  hll_add_hashes(b, hashes, n);
+  assert_int_equal(hll_count(a), hll_count(b));
+
+  free(hashes);
+  hll_destroy(a);
+  hll_destroy(b);
+}
+
+static void test_hll_merge(void **state)
+{
+  UNUSED(state);
+
+  hll_t *a = hll_new(14);
+  hll_t *b = hll_new(14);
+  hll_t *c = hll_new(12);
+  uint64_t i;
+
+  for (i = 0; i < 60000; i++)
+  {
+    hll_add(a, &i, sizeof(i));
+  }
+
+  for (i = 40000; i < 100000; i++)
+  {
+    hll_add(b, &i, sizeof(i));
+  }
+
+  assert_int_equal(hll_merge(a, b), 0);
+  assert_in_range(hll_count(a), 96000, 104000);
+  assert_int_equal(hll_merge(a, c), -1);
+
+  hll_destroy(a);
+  hll_destroy(b);
+  hll_destroy(c);
+}
+
+static void test_hll_merge_sparse(void **state)
+{
+  UNUSED(state);
+
+  hll_t *a = hll_new(14);
+  hll_t *b = hll_new(14);
+  uint64_t i;
+
+  for (i = 0; i < 50; i++)
+  {
+    hll_add(a, &i, sizeof(i));
+  }
+
+  for (i = 25; i < 75; i++)
+  {
+    hll_add(b, &i, sizeof(i));
+  }
+
+  assert_int_equal(hll_merge(a, b), 0);
+  assert_int_equal(hll_is_sparse(a), 1);
+  assert_in_range(hll_count(a), 73, 77);
+
+  hll_destroy(a);
+  hll_destroy(b);
+}
+
+int main(void)
+{
+  const struct CMUnitTest tests[] = {
+    cmocka_unit_test(test_hll_create_destroy),
+    cmocka_unit_test(test_hll_sparse),
+    cmocka_unit_test(test_hll_dense),
+    cmocka_unit_test(test_hll_add_hashes),
+    cmocka_unit_test(test_hll_merge),
+    cmocka_unit_test(test_hll_merge_sparse),
+  };
+
+  return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -210,6 +210,128 @@ static void test_map_collision_resolution(void **state)
   map_destroy(m);
 }
 
+static void test_map_identity(void **state)
+{
+  UNUSED(state);
+
+  map_t *m = map_new(64);
+  const char *key = "content";
+  const char *val1 = "first";
+  const char *val2 = "second";
+  size_t out_size;
+
+  assert_int_equal(map_set(m, key, strlen(key), val1, strlen(val1) + 1), 0);
+
+  map_enable_identity(m);
+
+  char *ret = (char *)map_get(m, key, strlen(key), &out_size);
+  assert_non_null(ret);
+  assert_string_equal(ret, val1);
+  free(ret);
+
+  assert_int_equal(map_set(m, key, strlen(key), val2, strlen(val2) + 1), 0);
+
+  ret = (char *)map_get(m, key, strlen(key), &out_size);
+  assert_non_null(ret);
+  assert_string_equal(ret, val2);
+  free(ret);
+
+  assert_int_equal(map_exists(m, "other", 5), 0);
+  assert_int_equal(map_del(m, key, strlen(key)), 0);
+  assert_int_equal(map_exists(m, key, strlen(key)), 0);
+
+  map_destroy(m);
+}
+
+static void test_map_batch(void **state)
+{
+  UNUSED(state);
+
+  const size_t n = 1000;
+  map_t *m = map_new(4096);
+  uint64_t *keys = malloc(2 * n * sizeof(*keys));
+  uint32_t *values = malloc(n * sizeof(*values));
+  int *found = malloc(2 * n * sizeof(*found));
+  size_t out_size;
+  size_t i;
+
+  for (i = 0; i < 2 * n; i++)
+  {
+    keys[i] = i * 7919;
+  }
+
+  for (i = 0; i < n; i++)
+  {
+    values[i] = (uint32_t)i;
+  }
+
+  assert_int_equal(map_set_batch(m, keys, sizeof(*keys), values, sizeof(*values), n), 0);
+
+  for (i = 0; i < n; i++)
+  {
+    uint32_t *value = map_get(m, &keys[i], sizeof(*keys), &out_size);
+    assert_non_null(value);
+    assert_int_equal(*value, i);
+    free(value);
+  }
+
+  assert_int_equal(map_exists_batch(m, keys, sizeof(*keys), 2 * n, found), n);
+
+  for (i = 0; i < 2 * n; i++)
+  {
+    assert_int_equal(found[i], i < n);
+  }
+
+  map_enable_identity(m);
+  assert_int_equal(map_exists_batch(m, keys, sizeof(*keys), 2 * n, NULL), n);
+
+  free(keys);
+  free(values);
+  free(found);
+  map_destroy(m);
+}
+
+static void test_map_use_hash(void **state)
+{
+  UNUSED(state);
+
+  const hash_fn_t fns[] = {crc32c_mix, aes_mix, xxh3};
+  const size_t n = 1000;
+  map_t *m = map_new(4096);
+  uint64_t *keys = malloc(2 * n * sizeof(*keys));
+  size_t out_size;
+  size_t f;
+  size_t i;
+
+  for (i = 0; i < 2 * n; i++)
+  {
+    keys[i] = i * 7919;
+  }
+
+  for (i = 0; i < n / 2; i++)
+  {
+    assert_int_equal(map_set(m, &keys[i], sizeof(*keys), &i, sizeof(i)), 0);
+  }
+
+  for (f = 0; f < sizeof(fns) / sizeof(*fns); f++)
+  {
+    map_use_hash(m, fns[f]);
+    assert_int_equal(map_set_batch(m, keys, sizeof(*keys), keys, sizeof(*keys), n), 0);
+    assert_int_equal(map_exists_batch(m, keys, sizeof(*keys), 2 * n, NULL), n);
+
+    for (i = 0; i < n; i++)
+    {
+      uint64_t *value = map_get(m, &keys[i], sizeof(*keys), &out_size);
+      assert_non_null(value);
+      assert_int_equal(*value, keys[i]);
+      free(value);
+    }
+  }
+
+  free(keys);
+  map_destroy(m);
+}
+
 int main(void)
 {
   const struct CMUnitTest tests[] = {
@@ -220,6 +342,9 @@ int main(void)
     cmocka_unit_test(test_map_nonexistent),
     cmocka_unit_test(test_map_overflow),
     cmocka_unit_test(test_map_collision_resolution),
+    cmocka_unit_test(test_map_identity),
+    cmocka_unit_test(test_map_batch),
+    cmocka_unit_test(test_map_use_hash),
   };
 
   return cmocka_run_group_tests(tests, NULL, NULL);
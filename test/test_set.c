@@ -21,6 +21,7 @@
 #include "cmocka.h"
 
 #include "common.h"
+#include "internal/cpu.h"
 #include "set.h"
 
 #include <stdlib.h>
@@ -191,6 +192,222 @@ static void test_set_overflow(void **state)
   set_destroy(s);
 }
 
+static void test_set_algebra(void **state)
+{
+  UNUSED(state);
+
+  set_t *a = set_new(10);
+  set_t *b = set_new(10);
+
+  const char *left[] = {"alpha", "beta", "gamma"};
+  const char *right[] = {"beta", "gamma", "delta", "epsilon"};
+
+  for (size_t i = 0; i < 3; i++)
+  {
+    assert_int_equal(set_add(a, left[i], strlen(left[i]) + 1), 0);
+  }
+
+  for (size_t i = 0; i < 4; i++)
+  {
+    assert_int_equal(set_add(b, right[i], strlen(right[i]) + 1), 0);
+  }
+
+  set_t *u = set_union(a, b);
+  assert_int_equal(set_exists(u, "alpha", 6), 1);
+  assert_int_equal(set_exists(u, "beta", 5), 1);
+  assert_int_equal(set_exists(u, "epsilon", 8), 1);
+
+  set_t *n = set_intersect(a, b);
+  assert_int_equal(set_exists(n, "alpha", 6), 0);
+  assert_int_equal(set_exists(n, "beta", 5), 1);
+  assert_int_equal(set_exists(n, "gamma", 6), 1);
+  assert_int_equal(set_exists(n, "delta", 6), 0);
+
+  set_t *d = set_difference(a, b);
+  assert_int_equal(set_exists(d, "alpha", 6), 1);
+  assert_int_equal(set_exists(d, "beta", 5), 0);
+  assert_int_equal(set_exists(d, "gamma", 6), 0);
+
+  assert_int_equal(set_is_subset(n, a), 1);
+  assert_int_equal(set_is_subset(n, b), 1);
+  assert_int_equal(set_is_subset(a, b), 0);
+  assert_int_equal(set_is_subset(a, u), 1);
+
+  set_destroy(d);
+  set_destroy(n);
+  set_destroy(u);
+  set_destroy(b);
+  set_destroy(a);
+}
+
+static void test_set_algebra_u32(void **state)
+{
+  UNUSED(state);
+
+  const size_t na = 1000;
+  const size_t nb = 700;
+  uint32_t *a = calloc(na, sizeof(*a));
+  uint32_t *b = calloc(nb, sizeof(*b));
+  uint32_t *out = calloc(na + nb, sizeof(*out));
+  size_t expected = 0;
+  size_t i;
+
+  assert_non_null(a);
+  assert_non_null(b);
+  assert_non_null(out);
+
+  for (i = 0; i < na; i++)
+  {
+    a[i] = (uint32_t)(i * 3);
+  }
+
+  for (i = 0; i < nb; i++)
+  {
+    b[i] = (uint32_t)(i * 5 + 1);
+  }
+
+  for (i = 0; i < nb; i++)
+  {
+    expected += (b[i] % 3 == 0 && b[i] / 3 < na);
+  }
+
+  size_t count = set_intersect_u32(a, na, b, nb, out);
+  assert_int_equal(count, expected);
+
+  for (i = 0; i < count; i++)
+  {
+    assert_int_equal(out[i] % 3, 0);
+    assert_int_equal(out[i] % 5, 1);
+    if (i > 0)
+    {
+      assert_true(out[i - 1] < out[i]);
+    }
+  }
+
+  assert_int_equal(set_union_u32(a, na, b, nb, out), na + nb - expected);
+  for (i = 1; i < na + nb - expected; i++)
+  {
+    assert_true(out[i - 1] < out[i]);
+  }
+
+  assert_int_equal(set_difference_u32(a, na, b, nb, out), na - expected);
+
+  count = set_intersect_u32(a, na, b, nb, out);
+  assert_int_equal(set_is_subset_u32(out, count, a, na), 1);
+  assert_int_equal(set_is_subset_u32(out, count, b, nb), 1);
+  assert_int_equal(set_is_subset_u32(b, nb, a, na), 0);
+
+  free(out);
+  free(b);
+  free(a);
+}
+
+/* the intersection gets an output of exactly min(na, nb) slots */
+static void test_set_intersect_u32_exact(void **state)
+{
+  UNUSED(state);
+
+  uint32_t a[16];
+  uint32_t b[8] = {1, 2, 3, 4, 5, 6, 7, 200};
+  uint32_t *out = malloc(8 * sizeof(*out));
+  size_t i;
+
+  assert_non_null(out);
+
+  for (i = 0; i < 8; i++)
+  {
+    a[i] = (uint32_t)(i + 1);
+    a[i + 8] = (uint32_t)(i + 108);
+  }
+
+  assert_int_equal(set_intersect_u32(a, 16, b, 8, out), 7);
+
+  for (i = 0; i < 7; i++)
+  {
+    assert_int_equal(out[i], i + 1);
+  }
+
+  free(out);
+
+  /* every equal prefix length, with the output sized to match */
+  for (i = 1; i <= 40; i++)
+  {
+    uint32_t *x = malloc(i * sizeof(*x));
+    uint32_t *y = malloc(i * sizeof(*y));
+    size_t n;
+
+    out = malloc(i * sizeof(*out));
+    assert_non_null(x);
+    assert_non_null(y);
+    assert_non_null(out);
+
+    for (n = 0; n < i; n++)
+    {
+      x[n] = y[n] = (uint32_t)(n * 2);
+    }
+
+    assert_int_equal(set_intersect_u32(x, i, y, i, out), i);
+    assert_memory_equal(out, x, i * sizeof(*out));
+
+    free(out);
+    free(y);
+    free(x);
+  }
+}
+
+static void test_set_algebra_u32_dispatch(void **state)
+{
+  const unsigned int masks[] = {0U, CPU_SSSE3, ~0U};
+  size_t i;
+
+  for (i = 0; i < sizeof(masks) / sizeof(*masks); i++)
+  {
+    cpu_restrict(masks[i]);
+    test_set_algebra_u32(state);
+    test_set_intersect_u32_exact(state);
+  }
+
+  cpu_restrict(~0U);
+}
+
+static void test_set_identity(void **state)
+{
+  UNUSED(state);
+
+  set_t *s = set_new(1024);
+  set_t *t = NULL;
+  uint64_t i;
+
+  for (i = 0; i < 500; i++)
+  {
+    assert_int_equal(set_add(s, &i, sizeof(i)), 0);
+  }
+
+  set_enable_identity(s);
+
+  for (i = 0; i < 500; i++)
+  {
+    assert_int_equal(set_exists(s, &i, sizeof(i)), 1);
+  }
+
+  for (i = 500; i < 1000; i++)
+  {
+    assert_int_equal(set_exists(s, &i, sizeof(i)), 0);
+    assert_int_equal(set_add(s, &i, sizeof(i)), 0);
+  }
+
+  assert_int_equal(set_add(s, &(uint64_t){42}, sizeof(uint64_t)), 0);
+  assert_int_equal(set_remove(s, &(uint64_t){42}, sizeof(uint64_t)), 0);
+  assert_int_equal(set_exists(s, &(uint64_t){42}, sizeof(uint64_t)), 0);
+
+  t = set_intersect(s, s);
+  assert_int_equal(t->identity, 1);
+  assert_int_equal(set_exists(t, &(uint64_t){7}, sizeof(uint64_t)), 1);
+
+  set_destroy(t);
+  set_destroy(s);
+}
+
 int main(void)
 {
   const struct CMUnitTest tests[] = {
@@ -201,6 +418,11 @@ int main(void)
     cmocka_unit_test(test_set_remove_nonexistent),
     cmocka_unit_test(test_set_getall),
     cmocka_unit_test(test_set_overflow),
+    cmocka_unit_test(test_set_algebra),
+    cmocka_unit_test(test_set_algebra_u32),
+    cmocka_unit_test(test_set_intersect_u32_exact),
+    cmocka_unit_test(test_set_algebra_u32_dispatch),
+    cmocka_unit_test(test_set_identity),
   };
 
   return cmocka_run_group_tests(tests, NULL, NULL);